@@ -0,0 +1,14 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// see include/Material.glsl
+#define BINDLESS_TEXTURES
+
+#stage vertex
+#include "include/SkinningVertex.glsl"
+
+#stage geometry
+#include "include/MultiCameraGeometry.glsl"
+
+#stage fragment
+#include "include/Material.glsl"
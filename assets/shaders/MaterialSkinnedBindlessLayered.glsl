@@ -0,0 +1,15 @@
+#version 460
+#extension GL_ARB_shader_viewport_layer_array : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+// see include/VertexOutput.glsl
+#define LAYERED_CAMERAS
+
+// see include/Material.glsl
+#define BINDLESS_TEXTURES
+
+#stage vertex
+#include "include/SkinningVertex.glsl"
+
+#stage fragment
+#include "include/Material.glsl"
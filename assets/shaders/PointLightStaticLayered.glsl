@@ -0,0 +1,11 @@
+#version 460
+#extension GL_ARB_shader_viewport_layer_array : require
+
+// see include/VertexOutput.glsl
+#define LAYERED_CAMERAS
+
+#stage vertex
+#include "include/StaticVertex.glsl"
+
+#stage fragment
+#include "include/PointLightDepth.glsl"
@@ -10,37 +10,86 @@ layout(set = 1, binding = 0, std140) uniform Material {
     vec4 Albedo, Specular, Ambient;
     float Shininess;
     bool HasNormalMap;
+
+#ifdef BINDLESS_TEXTURES
+    // albedo, specular, ambient and normal indices into u_Textures
+    ivec4 TextureIndices;
+#endif
 } u_Material;
 
+#ifdef BINDLESS_TEXTURES
+// every texture used by a material, registered by the renderer
+layout(set = 3, binding = 0) uniform sampler2D u_Textures[];
+
+#define ALBEDO_TEXTURE u_Textures[u_Material.TextureIndices.x]
+#define SPECULAR_TEXTURE u_Textures[u_Material.TextureIndices.y]
+#define AMBIENT_TEXTURE u_Textures[u_Material.TextureIndices.z]
+#define NORMAL_TEXTURE u_Textures[u_Material.TextureIndices.w]
+#else
 layout(set = 1, binding = 1) uniform sampler2D u_Albedo;
 layout(set = 1, binding = 2) uniform sampler2D u_Specular;
 layout(set = 1, binding = 3) uniform sampler2D u_Ambient;
 layout(set = 1, binding = 4) uniform sampler2D u_Normal;
 
+#define ALBEDO_TEXTURE u_Albedo
+#define SPECULAR_TEXTURE u_Specular
+#define AMBIENT_TEXTURE u_Ambient
+#define NORMAL_TEXTURE u_Normal
+#endif
+
 // MaterialXXX(UV) just returns the corresponding material aspect color
 // no lighting shenanigans
 
 vec4 MaterialAlbedo(in vec2 uv) {
-    vec4 tex = texture(u_Albedo, uv);
+    vec4 tex = texture(ALBEDO_TEXTURE, uv);
     return u_Material.Albedo * tex;
 }
 
 vec4 MaterialSpecular(in vec2 uv) {
-    vec4 tex = texture(u_Specular, uv);
+    vec4 tex = texture(SPECULAR_TEXTURE, uv);
     return u_Material.Specular * tex;
 }
 
 vec4 MaterialAmbient(in vec2 uv) {
-    vec4 tex = texture(u_Ambient, uv);
+    vec4 tex = texture(AMBIENT_TEXTURE, uv);
     return u_Material.Ambient * tex;
 }
 
+// moves a direction into the corner of its cube face that a light's shadow map covers
+vec3 GetShadowAtlasDirection(in vec3 direction, float scale) {
+    vec3 absolute = abs(direction);
+
+    // the sign relating each component to the face's coordinates, and 0 for the major axis
+    // see "cube map face selection" in the vulkan spec
+    float major;
+    vec3 faceSigns;
+    if (absolute.x >= absolute.y && absolute.x >= absolute.z) {
+        major = absolute.x;
+        faceSigns = vec3(0, -1, -sign(direction.x));
+    } else if (absolute.y >= absolute.z) {
+        major = absolute.y;
+        faceSigns = vec3(1, 0, sign(direction.y));
+    } else {
+        major = absolute.z;
+        faceSigns = vec3(sign(direction.z), -1, 0);
+    }
+
+    // face coordinates go from [-1, 1] to [-1, 2 * scale - 1]
+    // half a texel is kept from the edge, so that filtering does not pick up other lights' maps
+    float texel = 1.0 / float(textureSize(u_ShadowAtlas, 0).x);
+    vec3 faceCoords = direction * faceSigns / major;
+    vec3 scaled = clamp((faceCoords + 1) * scale - 1, texel - 1, 2 * scale - 1 - texel);
+
+    return mix(direction, scaled * faceSigns * major, abs(faceSigns));
+}
+
 float SampleShadowCubeMap(in Light light, in vec3 uvw) {
     float near = light.ShadowZRange[0];
     float far = light.ShadowZRange[1];
     float range = far - near;
 
-    float shadowSample = texture(u_ShadowCubeMaps[light.ShadowIndex], uvw).r; 
+    vec3 direction = GetShadowAtlasDirection(uvw, light.ShadowScale);
+    float shadowSample = texture(u_ShadowAtlas, vec4(direction, light.ShadowIndex)).r;
     float closestDepth = shadowSample * range + near;
 
     return closestDepth;
@@ -59,6 +108,10 @@ float Attenuate(float distance, float radius, float falloff) {
 }
 
 float CalculatePointLightShadow(in Light light) {
+    if (light.ShadowIndex < 0) {
+        return 0;
+    }
+
     vec3 lightToFragment = in_Data.WorldPosition - light.Position;
     float currentDepth = length(lightToFragment);
 
@@ -95,7 +148,7 @@ float CalculatePointLightShadow(in Light light) {
 
 vec3 CalculateLightColor(int index, in vec3 normal, in vec3 materialAlbedo,
                          in vec3 materialSpecular, in vec3 materialAmbient) {
-    Light light = u_Scene.Lights[index];
+    Light light = u_Lights.Data[index];
 
     vec3 lightToFragment;
     float shadow;
@@ -142,7 +195,7 @@ void main() {
         vec3 bitangent = normalize(in_Data.VertexData.Bitangent);
 
         mat3 tbn = mat3(tangent, bitangent, nnorm);
-        vec3 normalSample = texture(u_Normal, in_Data.VertexData.UV).rgb;
+        vec3 normalSample = texture(NORMAL_TEXTURE, in_Data.VertexData.UV).rgb;
 
         normal = normalize(tbn * normalSample);
     } else {
@@ -154,8 +207,20 @@ void main() {
     vec4 ambient = MaterialAlbedo(in_Data.VertexData.UV);
 
     vec3 fragmentColor = vec3(0);
-    for (int i = 0; i < u_Scene.LightCount; i++) {
-        fragmentColor += CalculateLightColor(i, normal, albedo.rgb, specular.rgb, ambient.rgb);
+    int cluster = GetLightCluster(in_Data.WorldPosition);
+
+    if (cluster < 0) {
+        for (int i = 0; i < u_Scene.LightCount; i++) {
+            fragmentColor += CalculateLightColor(i, normal, albedo.rgb, specular.rgb, ambient.rgb);
+        }
+    } else {
+        uint offset = u_LightClusters.Data[cluster * 2];
+        uint count = u_LightClusters.Data[cluster * 2 + 1];
+
+        for (uint i = 0; i < count; i++) {
+            int index = int(u_LightClusters.Data[offset + i]);
+            fragmentColor += CalculateLightColor(index, normal, albedo.rgb, specular.rgb, ambient.rgb);
+        }
     }
 
     float alpha = albedo.a + specular.a + ambient.a;
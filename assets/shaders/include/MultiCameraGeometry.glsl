@@ -11,6 +11,10 @@ layout(location = 0) out GeometryOut out_Data;
 
 void main() {
     for (int i = 0; i < u_PushConstants.CameraCount; i++) {
+        if ((u_PushConstants.CameraMask & (1 << i)) == 0) {
+            continue;
+        }
+
         int cameraIndex = i + u_PushConstants.FirstCamera;
         Camera camera = u_Scene.Cameras[cameraIndex];
 
@@ -2,4 +2,7 @@ layout(push_constant) uniform PushConstants {
     mat4 Model;
     int FirstCamera, CameraCount;
     int BoneOffset;
+
+    // bit i is set if camera FirstCamera + i can see the draw
+    int CameraMask;
 } u_PushConstants;
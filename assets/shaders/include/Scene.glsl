@@ -15,8 +15,9 @@ struct Light {
     int Type;
     vec3 Position;
 
-    int ShadowIndex;
+    int ShadowIndex; // -1 if the light casts no shadows
     vec2 ShadowZRange;
+    float ShadowScale;
 
     LightColors Colors;
     LightAttenuation Attenuation;
@@ -30,9 +31,55 @@ struct Camera {
 
 layout(set = 0, binding = 0, std140) uniform Scene {
     Camera Cameras[10];
-
-    Light Lights[64];
     int LightCount;
+
+    // the camera that lights are clustered for, or -1 if fragments shade every light
+    int ClusterCamera;
 } u_Scene;
 
-layout(set = 0, binding = 1) uniform samplerCube u_ShadowCubeMaps[16];
+// each shadowed light renders to the corner of each face of one cube
+layout(set = 0, binding = 1) uniform samplerCubeArray u_ShadowAtlas;
+
+layout(set = 0, binding = 2, std430) readonly buffer Lights {
+    Light Data[];
+} u_Lights;
+
+// see LightGrid in src/fuujin/renderer/LightGrid.h
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 9
+#define CLUSTER_SLICES 24
+
+// an offset and count per cluster, indexing the light indices that follow
+layout(set = 0, binding = 3, std430) readonly buffer LightClusters {
+    uint Data[];
+} u_LightClusters;
+
+// returns -1 if the position is outside of every cluster
+int GetLightCluster(in vec3 worldPosition) {
+    if (u_Scene.ClusterCamera < 0) {
+        return -1;
+    }
+
+    Camera camera = u_Scene.Cameras[u_Scene.ClusterCamera];
+    vec4 clip = camera.ViewProjection * vec4(worldPosition, 1);
+
+    float near = camera.ZRange[0];
+    float far = camera.ZRange[1];
+    if (clip.w < near || clip.w > far) {
+        return -1;
+    }
+
+    vec2 ndc = clip.xy / clip.w;
+    if (any(greaterThan(abs(ndc), vec2(1)))) {
+        return -1;
+    }
+
+    ivec2 tileCount = ivec2(CLUSTER_TILES_X, CLUSTER_TILES_Y);
+    ivec2 tile = clamp(ivec2(floor((ndc * 0.5 + 0.5) * vec2(tileCount))), ivec2(0), tileCount - 1);
+
+    // slices are spaced exponentially, so that clusters stay roughly cubic with distance
+    float depth = log(clip.w / near) / log(far / near);
+    int slice = clamp(int(floor(depth * CLUSTER_SLICES)), 0, CLUSTER_SLICES - 1);
+
+    return (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x;
+}
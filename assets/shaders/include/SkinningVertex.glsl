@@ -1,6 +1,4 @@
-#include "Renderer.glsl"
-#include "Scene.glsl"
-#include "InterStage.glsl"
+#include "VertexOutput.glsl"
 
 layout(location = 0) in vec3 in_Position;
 layout(location = 1) in vec2 in_UV;
@@ -10,8 +8,6 @@ layout(location = 3) in vec3 in_Tangent;
 layout(location = 4) in ivec4 in_BoneIDs;
 layout(location = 5) in vec4 in_Weights;
 
-layout(location = 0) out VertexOut out_Data;
-
 layout(set = 2, binding = 0, std140) uniform Bones {
     mat4 Transforms[128];
 } u_Bones;
@@ -28,11 +24,13 @@ void main() {
     mat4 modelToWorld = u_PushConstants.Model;
     mat4 bindToWorld = modelToWorld * bindToModel;
 
-    gl_Position = bindToWorld * vec4(in_Position, 1.0);
-    out_Data.UV = in_UV;
+    VertexOut vertexData;
+    vertexData.UV = in_UV;
 
     mat3 normalMatrix = transpose(inverse(mat3(bindToWorld)));
-    out_Data.Normal = normalize(normalMatrix * in_Normal);
-    out_Data.Tangent = normalize(normalMatrix * in_Tangent);
-    out_Data.Bitangent = normalize(cross(out_Data.Normal, out_Data.Tangent));
+    vertexData.Normal = normalize(normalMatrix * in_Normal);
+    vertexData.Tangent = normalize(normalMatrix * in_Tangent);
+    vertexData.Bitangent = normalize(cross(vertexData.Normal, vertexData.Tangent));
+
+    WriteVertex(bindToWorld * vec4(in_Position, 1.0), vertexData);
 }
@@ -1,20 +1,25 @@
-#include "Renderer.glsl"
-#include "Scene.glsl"
-#include "InterStage.glsl"
+#include "VertexOutput.glsl"
 
 layout(location = 0) in vec3 in_Position;
 layout(location = 1) in vec2 in_UV;
 layout(location = 2) in vec3 in_Normal;
 layout(location = 3) in vec3 in_Tangent;
 
-layout(location = 0) out VertexOut out_Data;
+// indexed by GetInstanceIndex, which includes the first instance of the draw
+layout(set = 2, binding = 0, std430) readonly buffer Instances {
+    mat4 Transforms[];
+} u_Instances;
 
 void main() {
-    gl_Position = u_PushConstants.Model * vec4(in_Position, 1.0);
-    out_Data.UV = in_UV;
+    mat4 modelToWorld = u_Instances.Transforms[GetInstanceIndex()];
 
-    mat3 normalMatrix = transpose(inverse(mat3(u_PushConstants.Model)));
-    out_Data.Normal = normalize(normalMatrix * in_Normal);
-    out_Data.Tangent = normalize(normalMatrix * in_Tangent);
-    out_Data.Bitangent = normalize(cross(out_Data.Normal, out_Data.Tangent));
+    VertexOut vertexData;
+    vertexData.UV = in_UV;
+
+    mat3 normalMatrix = transpose(inverse(mat3(modelToWorld)));
+    vertexData.Normal = normalize(normalMatrix * in_Normal);
+    vertexData.Tangent = normalize(normalMatrix * in_Tangent);
+    vertexData.Bitangent = normalize(cross(vertexData.Normal, vertexData.Tangent));
+
+    WriteVertex(modelToWorld * vec4(in_Position, 1.0), vertexData);
 }
@@ -0,0 +1,55 @@
+#include "Renderer.glsl"
+#include "Scene.glsl"
+#include "InterStage.glsl"
+
+#ifdef LAYERED_CAMERAS
+// the vertex stage picks the camera and layer, instead of MultiCameraGeometry.glsl
+// every instance is drawn once per camera in CameraMask; see Renderer::RenderWithMaterial
+layout(location = 0) out GeometryOut out_Data;
+
+int GetCameraMask() {
+    int mask = u_PushConstants.CameraMask;
+    if (u_PushConstants.CameraCount < 32) {
+        mask &= (1 << u_PushConstants.CameraCount) - 1;
+    }
+
+    return mask;
+}
+
+int GetInstanceIndex() {
+    return gl_InstanceIndex / bitCount(GetCameraMask());
+}
+
+void WriteVertex(vec4 worldPosition, VertexOut vertexData) {
+    int mask = GetCameraMask();
+    int slot = gl_InstanceIndex % bitCount(mask);
+
+    // the camera of the slot-th bit set in the mask
+    for (int i = 0; i < slot; i++) {
+        mask &= mask - 1;
+    }
+
+    int layer = findLSB(mask);
+    Camera camera = u_Scene.Cameras[layer + u_PushConstants.FirstCamera];
+
+    gl_Layer = layer;
+    gl_Position = camera.ViewProjection * worldPosition;
+
+    out_Data.WorldPosition = worldPosition.xyz;
+    out_Data.CameraPosition = camera.Position;
+    out_Data.ZRange = camera.ZRange;
+    out_Data.VertexData = vertexData;
+}
+#else
+// the geometry stage transforms the world position into each camera
+layout(location = 0) out VertexOut out_Data;
+
+int GetInstanceIndex() {
+    return gl_InstanceIndex;
+}
+
+void WriteVertex(vec4 worldPosition, VertexOut vertexData) {
+    gl_Position = worldPosition;
+    out_Data = vertexData;
+}
+#endif
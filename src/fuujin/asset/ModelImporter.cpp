@@ -264,7 +264,9 @@ namespace fuujin {
         }
 
         auto material = GetMaterial(mesh->mMaterialIndex);
-        auto result = std::make_unique<Mesh>(material, vertices, indices, bones, armatureIndex);
+        auto bounds = Mesh::CalculateBounds(vertices);
+        auto result =
+            std::make_unique<Mesh>(material, vertices, indices, bones, armatureIndex, bounds);
 
         m_ImportedBones.clear();
         m_Model->AddMesh(std::move(result));
@@ -4,6 +4,7 @@
 #include "fuujin/core/Platform.h"
 #include "fuujin/core/Event.h"
 #include "fuujin/core/Layer.h"
+#include "fuujin/core/JobSystem.h"
 
 #include "fuujin/renderer/Renderer.h"
 #include "fuujin/renderer/GraphicsContext.h"
@@ -80,6 +81,7 @@ namespace fuujin {
         s_App = this;
 
         Platform::Init();
+        JobSystem::Init();
 
         m_Data = new ApplicationData;
         m_Data->LastTimestamp = std::chrono::high_resolution_clock::now();
@@ -99,9 +101,11 @@ namespace fuujin {
     Application::~Application() {
         ZoneScoped;
 
+        Renderer::Wait();
         m_Data->LayerStack.clear();
         AssetManager::SHutdown();
         Renderer::Shutdown();
+        JobSystem::Shutdown();
 
         m_Data->AppView.Reset();
         Platform::Shutdown();
@@ -189,8 +193,8 @@ namespace fuujin {
             layer->PostUpdate(delta);
         }
 
+        // the renderer throttles the next frame if the render thread falls behind
         Renderer::PopRenderTarget();
-        Renderer::Wait();
 
         m_Data->AppView->Update();
     }
@@ -0,0 +1,377 @@
+#include "fuujinpch.h"
+#include "fuujin/core/JobSystem.h"
+
+#include <thread>
+#include <deque>
+
+namespace fuujin {
+    struct QueuedJob {
+        JobSystem::Job Callback;
+        Ref<JobCounter> Counter;
+    };
+
+    struct JobWorker {
+        std::thread Thread;
+
+        // the owning worker pops from the back, thieves steal from the front
+        std::mutex Mutex;
+        std::deque<QueuedJob> Jobs;
+    };
+
+    struct JobSystemData {
+        std::vector<std::unique_ptr<JobWorker>> Workers;
+        std::atomic<uint32_t> NextWorker;
+
+        std::atomic<bool> Running;
+        std::atomic<uint32_t> Signal;
+
+        // kept apart from the workers so that Wait never picks these up
+        std::thread Background;
+        std::mutex BackgroundMutex;
+        std::deque<QueuedJob> BackgroundJobs;
+
+        std::atomic<bool> BackgroundRunning;
+        std::atomic<uint32_t> BackgroundSignal;
+    };
+
+    static std::unique_ptr<JobSystemData> s_Data;
+    static thread_local std::optional<uint32_t> s_WorkerIndex;
+
+    JobCounter::JobCounter(uint32_t count) { m_Remaining.store(count); }
+
+    JobCounter::~JobCounter() {
+        if (!m_Continuations.empty()) {
+            FUUJIN_WARN("Job counter destroyed with {} pending continuations!",
+                        m_Continuations.size());
+        }
+    }
+
+    void JobCounter::Increment(uint32_t count) { m_Remaining.fetch_add(count); }
+
+    void JobCounter::Decrement() {
+        if (m_Remaining.fetch_sub(1) != 1) {
+            return;
+        }
+
+        std::vector<std::function<void()>> continuations;
+        {
+            std::lock_guard lock(m_Mutex);
+            continuations = std::move(m_Continuations);
+        }
+
+        m_Remaining.notify_all();
+        for (auto& job : continuations) {
+            job();
+        }
+    }
+
+    bool JobCounter::AddContinuation(std::function<void()>&& job) {
+        std::lock_guard lock(m_Mutex);
+        if (IsDone()) {
+            return false;
+        }
+
+        m_Continuations.push_back(std::move(job));
+        return true;
+    }
+
+    void JobSystem::Init(std::optional<uint32_t> workerCount) {
+        ZoneScoped;
+
+        if (s_Data) {
+            FUUJIN_WARN("Job system already initialized - skipping second initialization");
+            return;
+        }
+
+        uint32_t count;
+        if (workerCount.has_value()) {
+            count = workerCount.value();
+        } else {
+            // main thread and render thread
+            uint32_t cores = std::thread::hardware_concurrency();
+            count = cores > 2 ? cores - 2 : 1;
+        }
+
+        if (count == 0) {
+            throw std::runtime_error("Cannot run a job system with no workers!");
+        }
+
+        s_Data = std::make_unique<JobSystemData>();
+        s_Data->NextWorker = 0;
+        s_Data->Running = true;
+        s_Data->Signal = 0;
+        s_Data->BackgroundRunning = true;
+        s_Data->BackgroundSignal = 0;
+
+        for (uint32_t i = 0; i < count; i++) {
+            s_Data->Workers.push_back(std::make_unique<JobWorker>());
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            s_Data->Workers[i]->Thread = std::thread(WorkerThread, i);
+        }
+
+        s_Data->Background = std::thread(BackgroundThread);
+
+        FUUJIN_INFO("Job system started with {} workers", count);
+    }
+
+    void JobSystem::Shutdown() {
+        ZoneScoped;
+
+        if (!s_Data) {
+            FUUJIN_WARN("Job system not initialized - skipping");
+            return;
+        }
+
+        // background jobs may schedule continuations, so they finish before the workers stop
+        s_Data->BackgroundRunning = false;
+        s_Data->BackgroundSignal++;
+        s_Data->BackgroundSignal.notify_all();
+        s_Data->Background.join();
+
+        // drain whatever is left before stopping
+        while (TryRunJob({})) {
+        }
+
+        s_Data->Running = false;
+        s_Data->Signal++;
+        s_Data->Signal.notify_all();
+
+        for (auto& worker : s_Data->Workers) {
+            worker->Thread.join();
+        }
+
+        s_Data.reset();
+    }
+
+    uint32_t JobSystem::GetWorkerCount() {
+        ZoneScoped;
+        if (!s_Data) {
+            return 0;
+        }
+
+        return (uint32_t)s_Data->Workers.size();
+    }
+
+    std::optional<uint32_t> JobSystem::GetWorkerIndex() { return s_WorkerIndex; }
+
+    Ref<JobCounter> JobSystem::Submit(Job job, const Ref<JobCounter>& dependency,
+                                      Ref<JobCounter> counter) {
+        ZoneScoped;
+
+        if (counter.IsEmpty()) {
+            counter = Ref<JobCounter>::Create();
+        }
+
+        counter->Increment(1);
+        Schedule(std::move(job), dependency, counter);
+
+        return counter;
+    }
+
+    Ref<JobCounter> JobSystem::ParallelFor(size_t count, const RangeJob& callback,
+                                           size_t batchSize, const Ref<JobCounter>& dependency) {
+        ZoneScoped;
+
+        auto counter = Ref<JobCounter>::Create();
+        if (count == 0) {
+            return counter;
+        }
+
+        batchSize = std::max<size_t>(batchSize, 1);
+        size_t batchCount = (count + batchSize - 1) / batchSize;
+
+        // counted up front, so that an early batch finishing cannot release waiters before the
+        // later batches are queued
+        counter->Increment((uint32_t)batchCount);
+
+        for (size_t begin = 0; begin < count; begin += batchSize) {
+            size_t end = std::min(begin + batchSize, count);
+            Schedule([callback, begin, end]() { callback(begin, end); }, dependency, counter);
+        }
+
+        return counter;
+    }
+
+    Ref<JobCounter> JobSystem::SubmitBackground(Job job) {
+        ZoneScoped;
+
+        if (!s_Data) {
+            throw std::runtime_error("Job system has not been initialized!");
+        }
+
+        auto counter = Ref<JobCounter>::Create(1);
+        {
+            std::lock_guard lock(s_Data->BackgroundMutex);
+
+            auto& queued = s_Data->BackgroundJobs.emplace_back();
+            queued.Callback = std::move(job);
+            queued.Counter = counter;
+        }
+
+        s_Data->BackgroundSignal++;
+        s_Data->BackgroundSignal.notify_one();
+
+        return counter;
+    }
+
+    void JobSystem::Wait(const Ref<JobCounter>& counter) {
+        ZoneScoped;
+
+        if (counter.IsEmpty()) {
+            return;
+        }
+
+        while (!counter->IsDone()) {
+            if (TryRunJob(s_WorkerIndex)) {
+                continue;
+            }
+
+            // nothing to help with - sleep until the counter hits zero
+            uint32_t remaining = counter->GetRemaining();
+            if (remaining > 0) {
+                counter->m_Remaining.wait(remaining);
+            }
+        }
+    }
+
+    void JobSystem::Schedule(Job&& job, const Ref<JobCounter>& dependency,
+                             const Ref<JobCounter>& counter) {
+        ZoneScoped;
+
+        if (dependency.IsPresent()) {
+            auto continuation = [job = std::move(job), counter]() mutable {
+                Enqueue(std::move(job), counter);
+            };
+
+            if (dependency->AddContinuation(std::move(continuation))) {
+                return;
+            }
+        }
+
+        Enqueue(std::move(job), counter);
+    }
+
+    void JobSystem::Enqueue(Job&& job, const Ref<JobCounter>& counter) {
+        ZoneScoped;
+
+        if (!s_Data) {
+            throw std::runtime_error("Job system has not been initialized!");
+        }
+
+        // workers push onto their own deque, everyone else distributes round-robin
+        uint32_t workerIndex;
+        if (s_WorkerIndex.has_value()) {
+            workerIndex = s_WorkerIndex.value();
+        } else {
+            workerIndex = s_Data->NextWorker++ % (uint32_t)s_Data->Workers.size();
+        }
+
+        auto& worker = *s_Data->Workers[workerIndex];
+        {
+            std::lock_guard lock(worker.Mutex);
+
+            auto& queued = worker.Jobs.emplace_back();
+            queued.Callback = std::move(job);
+            queued.Counter = counter;
+        }
+
+        s_Data->Signal++;
+        s_Data->Signal.notify_one();
+    }
+
+    bool JobSystem::TryRunJob(std::optional<uint32_t> worker) {
+        QueuedJob job;
+        bool found = false;
+
+        if (worker.has_value()) {
+            auto& own = *s_Data->Workers[worker.value()];
+            std::lock_guard lock(own.Mutex);
+
+            if (!own.Jobs.empty()) {
+                job = std::move(own.Jobs.back());
+                own.Jobs.pop_back();
+                found = true;
+            }
+        }
+
+        size_t workerCount = s_Data->Workers.size();
+        size_t start = worker.value_or(0);
+
+        for (size_t i = 1; i <= workerCount && !found; i++) {
+            auto& victim = *s_Data->Workers[(start + i) % workerCount];
+            std::lock_guard lock(victim.Mutex);
+
+            if (!victim.Jobs.empty()) {
+                job = std::move(victim.Jobs.front());
+                victim.Jobs.pop_front();
+                found = true;
+            }
+        }
+
+        if (!found) {
+            return false;
+        }
+
+        {
+            ZoneScopedN("Job");
+            job.Callback();
+        }
+
+        job.Counter->Decrement();
+        return true;
+    }
+
+    void JobSystem::WorkerThread(uint32_t index) {
+        auto name = "Job worker " + std::to_string(index);
+        tracy::SetThreadName(name.c_str());
+
+        s_WorkerIndex = index;
+        while (s_Data->Running) {
+            uint32_t signal = s_Data->Signal.load();
+            if (TryRunJob(index)) {
+                continue;
+            }
+
+            s_Data->Signal.wait(signal);
+        }
+    }
+
+    void JobSystem::BackgroundThread() {
+        tracy::SetThreadName("Background worker");
+
+        // queued jobs still run after shutdown is requested
+        while (true) {
+            uint32_t signal = s_Data->BackgroundSignal.load();
+
+            QueuedJob job;
+            bool found = false;
+
+            {
+                std::lock_guard lock(s_Data->BackgroundMutex);
+                if (!s_Data->BackgroundJobs.empty()) {
+                    job = std::move(s_Data->BackgroundJobs.front());
+                    s_Data->BackgroundJobs.pop_front();
+                    found = true;
+                }
+            }
+
+            if (!found) {
+                if (!s_Data->BackgroundRunning) {
+                    break;
+                }
+
+                s_Data->BackgroundSignal.wait(signal);
+                continue;
+            }
+
+            {
+                ZoneScopedN("Background job");
+                job.Callback();
+            }
+
+            job.Counter->Decrement();
+        }
+    }
+} // namespace fuujin
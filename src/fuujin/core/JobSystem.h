@@ -0,0 +1,77 @@
+#pragma once
+#include "fuujin/core/Ref.h"
+
+namespace fuujin {
+    // tracks a group of jobs; reaches zero once every job in the group has run
+    class JobCounter : public RefCounted {
+    public:
+        JobCounter(uint32_t count = 0);
+        ~JobCounter();
+
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        bool IsDone() const { return m_Remaining.load(std::memory_order_acquire) == 0; }
+        uint32_t GetRemaining() const { return m_Remaining.load(std::memory_order_acquire); }
+
+    private:
+        void Increment(uint32_t count);
+        void Decrement();
+
+        // returns false if the counter is already done, in which case the job should run now
+        bool AddContinuation(std::function<void()>&& job);
+
+        std::atomic<uint32_t> m_Remaining;
+
+        std::mutex m_Mutex;
+        std::vector<std::function<void()>> m_Continuations;
+
+        friend class JobSystem;
+    };
+
+    class JobSystem {
+    public:
+        using Job = std::function<void()>;
+        using RangeJob = std::function<void(size_t begin, size_t end)>;
+
+        JobSystem() = delete;
+
+        // spawns one worker per core, minus the main and render threads, unless specified
+        static void Init(std::optional<uint32_t> workerCount = {});
+        static void Shutdown();
+
+        static uint32_t GetWorkerCount();
+
+        // returns the index of the calling worker, if called from a worker
+        static std::optional<uint32_t> GetWorkerIndex();
+
+        // queues a job to run on any worker
+        // if a dependency is passed, the job will not start until it is done
+        // if a counter is passed, the job is added to it instead of to a new counter
+        static Ref<JobCounter> Submit(Job job, const Ref<JobCounter>& dependency = {},
+                                      Ref<JobCounter> counter = {});
+
+        // splits [0, count) into batches of at most batchSize and runs them across workers
+        static Ref<JobCounter> ParallelFor(size_t count, const RangeJob& callback,
+                                           size_t batchSize = 64,
+                                           const Ref<JobCounter>& dependency = {});
+
+        // queues a long job, such as a pipeline compile, on the single background thread
+        // background jobs run in the order they were submitted and never hold up the workers
+        // Wait does not run them itself, so waiting on one only sleeps until it is done
+        static Ref<JobCounter> SubmitBackground(Job job);
+
+        // blocks until the counter reaches zero, running queued jobs in the meantime
+        static void Wait(const Ref<JobCounter>& counter);
+
+    private:
+        // queues a job that has already been counted, once the dependency is done
+        static void Schedule(Job&& job, const Ref<JobCounter>& dependency,
+                             const Ref<JobCounter>& counter);
+
+        static void Enqueue(Job&& job, const Ref<JobCounter>& counter);
+        static bool TryRunJob(std::optional<uint32_t> worker);
+        static void WorkerThread(uint32_t index);
+        static void BackgroundThread();
+    };
+} // namespace fuujin
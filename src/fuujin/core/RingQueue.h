@@ -0,0 +1,123 @@
+#pragma once
+
+#include <thread>
+
+namespace fuujin {
+    /*
+     * Bounded multi-producer, single-consumer ring of values. Slots carry a sequence number so
+     * producers only contend on a single atomic cursor, and the consumer never takes a lock. Pushes
+     * bump a signal word that the consumer can block on (futex on linux) instead of polling.
+     */
+    template <typename _Ty>
+    class RingQueue {
+    public:
+        RingQueue(size_t capacity) {
+            ZoneScoped;
+
+            if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+                throw std::runtime_error("Ring queue capacity must be a power of two!");
+            }
+
+            m_Mask = capacity - 1;
+            m_Slots = std::make_unique<Slot[]>(capacity);
+
+            for (size_t i = 0; i < capacity; i++) {
+                m_Slots[i].Sequence.store(i, std::memory_order_relaxed);
+            }
+
+            m_Head.store(0, std::memory_order_relaxed);
+            m_Tail = 0;
+            m_Signal.store(0, std::memory_order_relaxed);
+        }
+
+        RingQueue(const RingQueue&) = delete;
+        RingQueue& operator=(const RingQueue&) = delete;
+
+        // returns false if the ring is full
+        bool TryPush(_Ty&& value) {
+            ZoneScoped;
+
+            size_t position = m_Head.load(std::memory_order_relaxed);
+            Slot* slot;
+
+            while (true) {
+                slot = &m_Slots[position & m_Mask];
+                size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+                auto difference = (intptr_t)sequence - (intptr_t)position;
+
+                if (difference == 0) {
+                    if (m_Head.compare_exchange_weak(position, position + 1,
+                                                     std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = m_Head.load(std::memory_order_relaxed);
+                }
+            }
+
+            slot->Value = std::move(value);
+            slot->Sequence.store(position + 1, std::memory_order_release);
+
+            m_Signal.fetch_add(1, std::memory_order_release);
+            m_Signal.notify_one();
+
+            return true;
+        }
+
+        // spins while the ring is full
+        void Push(_Ty&& value) {
+            ZoneScoped;
+
+            while (!TryPush(std::move(value))) {
+                std::this_thread::yield();
+            }
+        }
+
+        // only to be called from the consumer thread
+        bool TryPop(_Ty& value) {
+            ZoneScoped;
+
+            auto& slot = m_Slots[m_Tail & m_Mask];
+            size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+            if (sequence != m_Tail + 1) {
+                return false;
+            }
+
+            value = std::move(slot.Value);
+            slot.Value = _Ty();
+            slot.Sequence.store(m_Tail + m_Mask + 1, std::memory_order_release);
+
+            m_Tail++;
+            return true;
+        }
+
+        // snapshot of the signal word, to be passed to Sleep
+        uint32_t GetSignal() const { return m_Signal.load(std::memory_order_acquire); }
+
+        // blocks the consumer until something has been pushed since the signal was read
+        void Sleep(uint32_t signal) const { m_Signal.wait(signal, std::memory_order_acquire); }
+
+        // wakes a sleeping consumer without pushing anything
+        void Wake() {
+            m_Signal.fetch_add(1, std::memory_order_release);
+            m_Signal.notify_all();
+        }
+
+        size_t GetCapacity() const { return m_Mask + 1; }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> Sequence;
+            _Ty Value;
+        };
+
+        std::unique_ptr<Slot[]> m_Slots;
+        size_t m_Mask;
+
+        alignas(64) std::atomic<size_t> m_Head;
+        alignas(64) size_t m_Tail;
+        alignas(64) std::atomic<uint32_t> m_Signal;
+    };
+} // namespace fuujin
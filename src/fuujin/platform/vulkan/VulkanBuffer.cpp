@@ -8,6 +8,8 @@
 #include "fuujin/renderer/Renderer.h"
 
 namespace fuujin {
+    static uint64_t s_BufferID = 0;
+
     VulkanBuffer::VulkanBuffer(Ref<VulkanDevice> device, const VmaAllocator& allocator,
                                const Spec& spec) {
         ZoneScoped;
@@ -19,6 +21,7 @@ namespace fuujin {
         m_Allocation = VK_NULL_HANDLE;
 
         m_Spec = spec;
+        m_ID = s_BufferID++;
 
         Renderer::Submit([&]() { RT_Allocate(allocator); });
     }
@@ -38,7 +41,7 @@ namespace fuujin {
 
         switch (m_Spec.BufferUsage) {
         case Usage::Uniform:
-            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; // see VulkanShader
         case Usage::Storage:
             return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         }
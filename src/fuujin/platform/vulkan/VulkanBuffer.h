@@ -11,6 +11,7 @@ namespace fuujin {
         virtual ~VulkanBuffer() override;
 
         virtual const Spec& GetSpec() const override { return m_Spec; }
+        virtual uint64_t GetID() const override { return m_ID; }
 
         VkBuffer Get() const { return m_Buffer; }
 
@@ -36,5 +37,6 @@ namespace fuujin {
         VkBuffer m_Buffer;
 
         Spec m_Spec;
+        uint64_t m_ID;
     };
 } // namespace fuujin
\ No newline at end of file
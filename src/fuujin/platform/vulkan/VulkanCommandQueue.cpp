@@ -84,6 +84,7 @@ namespace fuujin {
 
         m_SignaledCount = 0;
         m_WaitedCount = 0;
+        m_PendingQueue = nullptr;
 
         Renderer::Submit([this]() { RT_Create(); }, "Create semaphore");
     }
@@ -238,6 +239,7 @@ namespace fuujin {
 
         m_Device = device;
         m_Type = type;
+        m_SubmitCount = 0;
 
         Renderer::Submit([this]() { RT_Create(); }, "Set up command queue");
     }
@@ -246,17 +248,24 @@ namespace fuujin {
         ZoneScoped;
         Wait();
 
-        while (!m_StoredBuffers.empty()) {
-            delete m_StoredBuffers.front().Buffer;
-            m_StoredBuffers.pop();
+        std::vector<VkCommandPool> pools;
+        for (auto& pool : m_Pools) {
+            while (!pool.StoredBuffers.empty()) {
+                delete pool.StoredBuffers.front().Buffer;
+                pool.StoredBuffers.pop();
+            }
+
+            pools.push_back(pool.Pool);
         }
 
         auto device = m_Device->GetDevice();
-        auto pool = m_Pool;
-
         Renderer::Submit(
-            [=]() { vkDestroyCommandPool(device, pool, &VulkanContext::GetAllocCallbacks()); },
-            "Destroy command pool");
+            [=]() {
+                for (auto pool : pools) {
+                    vkDestroyCommandPool(device, pool, &VulkanContext::GetAllocCallbacks());
+                }
+            },
+            "Destroy command pools");
     }
 
     static void CheckRenderThread() {
@@ -265,32 +274,33 @@ namespace fuujin {
         }
     }
 
-    CommandList& VulkanCommandQueue::RT_Get() {
+    CommandList& VulkanCommandQueue::RT_Get(uint32_t pool) {
         ZoneScoped;
         CheckRenderThread();
 
         std::lock_guard lock(m_Mutex);
+        while (pool >= m_Pools.size()) {
+            RT_CreatePool();
+        }
 
+        auto& storedBuffers = m_Pools[pool].StoredBuffers;
         VulkanCommandBuffer* buffer = nullptr;
-        if (!m_StoredBuffers.empty()) {
-            const auto& storedBuffer = m_StoredBuffers.front();
+        if (!storedBuffers.empty()) {
+            const auto& storedBuffer = storedBuffers.front();
             auto fence = storedBuffer.BufferWait;
 
             if (fence->RT_IsReady()) {
-                if (storedBuffer.FenceOwned) {
-                    fence->Reset();
-                    m_AvailableFences.push(fence);
-                }
+                ReleaseFence(storedBuffer);
 
                 buffer = storedBuffer.Buffer;
-                m_StoredBuffers.pop();
+                storedBuffers.pop();
 
                 buffer->RT_Reset();
             }
         }
 
         if (buffer == nullptr) {
-            buffer = new VulkanCommandBuffer(m_Device, m_Pool);
+            buffer = new VulkanCommandBuffer(m_Device, m_Pools[pool].Pool);
         }
 
         return *buffer;
@@ -302,51 +312,35 @@ namespace fuujin {
 
         std::lock_guard lock(m_Mutex);
 
-        StoredCommandBuffer stored;
-        stored.Buffer = (VulkanCommandBuffer*)&cmdList;
-
-        if (fence.IsEmpty()) {
-            if (m_AvailableFences.empty()) {
-                stored.BufferWait = Ref<VulkanFence>::Create(m_Device);
-            } else {
-                stored.BufferWait = m_AvailableFences.front();
-                m_AvailableFences.pop();
+        // a batch can only signal a single fence
+        if (fence.IsPresent()) {
+            if (m_BatchFence.IsPresent()) {
+                RT_SubmitBatch();
             }
 
-            stored.FenceOwned = true;
-        } else {
-            stored.BufferWait = fence.As<VulkanFence>();
-            stored.FenceOwned = false;
+            m_BatchFence = fence.As<VulkanFence>();
         }
 
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-        auto cmdBuffer = stored.Buffer->Get();
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &cmdBuffer;
-
-        std::vector<VkPipelineStageFlags> waitStageFlags;
-        std::vector<VkSemaphore> waitSemaphores, signalSemaphores;
+        auto& submission = m_Batch.emplace_back();
+        submission.Buffer = (VulkanCommandBuffer*)&cmdList;
+        submission.FirstWait = m_BatchWaits.size();
+        submission.FirstSignal = m_BatchSignals.size();
 
         std::unordered_set<VkSemaphore> signaledSemaphores;
         std::vector<Ref<VulkanSemaphore>> semaphores;
-        if (stored.Buffer->GetSemaphores(SemaphoreUsage::Signal, semaphores)) {
+        if (submission.Buffer->GetSemaphores(SemaphoreUsage::Signal, semaphores)) {
             for (auto semaphore : semaphores) {
                 semaphore->SetSignaled();
+                semaphore->SetPendingQueue(this);
 
-                VkSemaphore vkSemaphore = semaphore->Get();
-                signaledSemaphores.insert(vkSemaphore);
-                signalSemaphores.push_back(vkSemaphore);
+                signaledSemaphores.insert(semaphore->Get());
+                m_BatchSignals.push_back(semaphore);
             }
-
-            submitInfo.signalSemaphoreCount = (uint32_t)signalSemaphores.size();
-            submitInfo.pSignalSemaphores = signalSemaphores.data();
         }
 
         std::unordered_map<VkSemaphore, size_t> waitedSemaphores;
-        if (stored.Buffer->GetSemaphores(SemaphoreUsage::Wait, semaphores)) {
-            const auto& waitStages = stored.Buffer->GetWaitStages();
+        if (submission.Buffer->GetSemaphores(SemaphoreUsage::Wait, semaphores)) {
+            const auto& waitStages = submission.Buffer->GetWaitStages();
             for (size_t i = 0; i < semaphores.size(); i++) {
                 auto semaphore = semaphores[i];
                 VkSemaphore vkSemaphore = semaphore->Get();
@@ -357,10 +351,17 @@ namespace fuujin {
                 }
 
                 if (!waitedSemaphores.contains(vkSemaphore)) {
-                    waitSemaphores.push_back(vkSemaphore);
-                    waitStageFlags.push_back(waitStages.contains(i)
-                                                 ? waitStages.at(i)
-                                                 : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+                    // the signal has to reach the device before anything waits on it
+                    auto pendingQueue = semaphore->GetPendingQueue();
+                    if (pendingQueue != nullptr && pendingQueue != this) {
+                        pendingQueue->RT_Flush();
+                    }
+
+                    waitedSemaphores[vkSemaphore] = m_BatchWaits.size();
+                    m_BatchWaits.push_back(vkSemaphore);
+                    m_BatchWaitStages.push_back(waitStages.contains(i)
+                                                    ? waitStages.at(i)
+                                                    : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
                     semaphore->SetWaited();
 
@@ -370,24 +371,122 @@ namespace fuujin {
                     if (waitedCount > signaledCount) {
                         throw std::runtime_error("Attempted to wait on an unsignaled semaphore!");
                     }
-
-                    waitedSemaphores[vkSemaphore] = i;
                 } else if (waitStages.contains(i)) {
                     size_t index = waitedSemaphores.at(vkSemaphore);
-                    waitStageFlags[index] |= waitStages.at(i);
+                    m_BatchWaitStages[index] |= waitStages.at(i);
                 }
             }
+        }
+
+        submission.WaitCount = m_BatchWaits.size() - submission.FirstWait;
+        submission.SignalCount = m_BatchSignals.size() - submission.FirstSignal;
+    }
+
+    void VulkanCommandQueue::RT_Flush() {
+        ZoneScoped;
+        CheckRenderThread();
 
-            submitInfo.waitSemaphoreCount = (uint32_t)waitSemaphores.size();
-            submitInfo.pWaitSemaphores = waitSemaphores.data();
-            submitInfo.pWaitDstStageMask = waitStageFlags.data();
+        std::lock_guard lock(m_Mutex);
+        RT_SubmitBatch();
+    }
+
+    void VulkanCommandQueue::RT_SubmitBatch() {
+        ZoneScoped;
+        if (m_Batch.empty()) {
+            return;
         }
 
-        if (vkQueueSubmit(m_Queue, 1, &submitInfo, stored.BufferWait->Get()) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to submit command buffer to queue!");
+        StoredCommandBuffer stored;
+        if (m_BatchFence.IsPresent()) {
+            stored.BufferWait = m_BatchFence;
+            stored.FenceOwned = false;
+        } else {
+            if (m_AvailableFences.empty()) {
+                stored.BufferWait = Ref<VulkanFence>::Create(m_Device);
+            } else {
+                stored.BufferWait = m_AvailableFences.front();
+                m_AvailableFences.pop();
+            }
+
+            stored.FenceOwned = true;
+        }
+
+        std::vector<VkSemaphore> signalSemaphores;
+        for (const auto& semaphore : m_BatchSignals) {
+            signalSemaphores.push_back(semaphore->Get());
+        }
+
+        std::vector<VkCommandBuffer> cmdBuffers;
+        std::vector<VkSubmitInfo> submitInfos;
+
+        cmdBuffers.reserve(m_Batch.size());
+        for (const auto& submission : m_Batch) {
+            auto& submitInfo = submitInfos.emplace_back();
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+            cmdBuffers.push_back(submission.Buffer->Get());
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &cmdBuffers.back();
+
+            if (submission.WaitCount > 0) {
+                submitInfo.waitSemaphoreCount = (uint32_t)submission.WaitCount;
+                submitInfo.pWaitSemaphores = &m_BatchWaits[submission.FirstWait];
+                submitInfo.pWaitDstStageMask = &m_BatchWaitStages[submission.FirstWait];
+            }
+
+            if (submission.SignalCount > 0) {
+                submitInfo.signalSemaphoreCount = (uint32_t)submission.SignalCount;
+                submitInfo.pSignalSemaphores = &signalSemaphores[submission.FirstSignal];
+            }
+        }
+
+        if (vkQueueSubmit(m_Queue, (uint32_t)submitInfos.size(), submitInfos.data(),
+                          stored.BufferWait->Get()) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit command buffers to queue!");
+        }
+
+        m_SubmitCount++;
+        for (const auto& semaphore : m_BatchSignals) {
+            semaphore->SetPendingQueue(nullptr);
+        }
+
+        for (const auto& submission : m_Batch) {
+            stored.Buffer = submission.Buffer;
+            if (stored.FenceOwned) {
+                m_FenceUsers[stored.BufferWait.Raw()]++;
+            }
+
+            auto vkPool = stored.Buffer->GetPool();
+            for (auto& pool : m_Pools) {
+                if (pool.Pool == vkPool) {
+                    pool.StoredBuffers.push(stored);
+                    break;
+                }
+            }
+        }
+
+        m_Batch.clear();
+        m_BatchWaits.clear();
+        m_BatchWaitStages.clear();
+        m_BatchSignals.clear();
+        m_BatchFence.Reset();
+    }
+
+    void VulkanCommandQueue::ReleaseFence(const StoredCommandBuffer& stored) {
+        ZoneScoped;
+        if (!stored.FenceOwned) {
+            return;
         }
 
-        m_StoredBuffers.push(stored);
+        auto it = m_FenceUsers.find(stored.BufferWait.Raw());
+        if (it == m_FenceUsers.end() || --it->second > 0) {
+            return;
+        }
+
+        m_FenceUsers.erase(it);
+
+        stored.BufferWait->Reset();
+        m_AvailableFences.push(stored.BufferWait);
     }
 
     static void RT_WaitForQueue(VkQueue queue) {
@@ -398,11 +497,20 @@ namespace fuujin {
         }
     }
 
-    void VulkanCommandQueue::Wait() const {
+    void VulkanCommandQueue::Wait() {
         ZoneScoped;
 
-        auto queue = m_Queue;
-        Renderer::Submit([=]() { RT_WaitForQueue(queue); }, "Wait for queue");
+        Renderer::Submit(
+            [this]() {
+                RT_Flush();
+                RT_WaitForQueue(m_Queue);
+            },
+            "Wait for queue");
+
+        // the job refers to this queue, which may be destroyed as soon as this returns
+        if (!Renderer::IsRenderThread()) {
+            Renderer::Wait();
+        }
     }
 
     void VulkanCommandQueue::Clear() {
@@ -411,16 +519,16 @@ namespace fuujin {
 
         std::lock_guard lock(m_Mutex);
 
-        while (!m_StoredBuffers.empty()) {
-            const auto& front = m_StoredBuffers.front();
+        for (auto& pool : m_Pools) {
+            auto& storedBuffers = pool.StoredBuffers;
+            while (!storedBuffers.empty()) {
+                const auto& front = storedBuffers.front();
 
-            delete front.Buffer;
-            if (front.FenceOwned) {
-                front.BufferWait->Reset();
-                m_AvailableFences.push(front.BufferWait);
-            }
+                delete front.Buffer;
+                ReleaseFence(front);
 
-            m_StoredBuffers.pop();
+                storedBuffers.pop();
+            }
         }
     }
 
@@ -428,28 +536,29 @@ namespace fuujin {
         ZoneScoped;
 
         const auto& queues = m_Device->GetQueues();
-        uint32_t family = queues.at(m_Type);
+        m_Family = queues.at(m_Type);
 
-        RT_GetQueue(family);
-        RT_CreatePool(family);
+        RT_GetQueue();
+        RT_CreatePool();
     }
 
-    void VulkanCommandQueue::RT_GetQueue(uint32_t family) {
+    void VulkanCommandQueue::RT_GetQueue() {
         ZoneScoped;
 
-        vkGetDeviceQueue(m_Device->GetDevice(), family, 0, &m_Queue);
+        vkGetDeviceQueue(m_Device->GetDevice(), m_Family, 0, &m_Queue);
     }
 
-    void VulkanCommandQueue::RT_CreatePool(uint32_t family) {
+    void VulkanCommandQueue::RT_CreatePool() {
         ZoneScoped;
 
         VkCommandPoolCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        createInfo.queueFamilyIndex = family;
+        createInfo.queueFamilyIndex = m_Family;
         createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
+        auto& pool = m_Pools.emplace_back();
         if (vkCreateCommandPool(m_Device->GetDevice(), &createInfo,
-                                &VulkanContext::GetAllocCallbacks(), &m_Pool) != VK_SUCCESS) {
+                                &VulkanContext::GetAllocCallbacks(), &pool.Pool) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create command pool for queue!");
         }
     }
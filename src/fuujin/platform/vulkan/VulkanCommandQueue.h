@@ -5,6 +5,8 @@
 #include "fuujin/platform/vulkan/VulkanDevice.h"
 
 namespace fuujin {
+    class VulkanCommandQueue;
+
     class VulkanFence : public Fence {
     public:
         VulkanFence(Ref<VulkanDevice> device, bool signaled = false);
@@ -37,6 +39,10 @@ namespace fuujin {
         uint64_t GetSignaledCount() const { return m_SignaledCount; }
         uint64_t GetWaitedCount() const { return m_WaitedCount; }
 
+        // the queue holding an unflushed batch that signals this semaphore, if any
+        VulkanCommandQueue* GetPendingQueue() const { return m_PendingQueue; }
+        void SetPendingQueue(VulkanCommandQueue* queue) { m_PendingQueue = queue; }
+
     private:
         void RT_Create();
 
@@ -44,6 +50,7 @@ namespace fuujin {
         VkSemaphore m_Semaphore;
 
         uint64_t m_SignaledCount, m_WaitedCount;
+        VulkanCommandQueue* m_PendingQueue;
     };
 
     class VulkanCommandBuffer : public CommandList {
@@ -66,6 +73,7 @@ namespace fuujin {
                            std::vector<Ref<VulkanSemaphore>>& semaphores) const;
 
         VkCommandBuffer Get() const { return m_Buffer; }
+        VkCommandPool GetPool() const { return m_Pool; }
 
         const std::unordered_map<size_t, VkPipelineStageFlags> GetWaitStages() const {
             return m_WaitStages;
@@ -92,12 +100,15 @@ namespace fuujin {
         virtual QueueType GetType() const override { return m_Type; }
 
         VkQueue GetQueue() const { return m_Queue; }
-        VkCommandPool GetPool() const { return m_Pool; }
+        VkCommandPool GetPool() const { return m_Pools[0].Pool; }
 
-        virtual CommandList& RT_Get() override;
+        virtual CommandList& RT_Get(uint32_t pool = 0) override;
         virtual void RT_Submit(CommandList& cmdList, Ref<Fence> fence = {}) override;
+        virtual void RT_Flush() override;
 
-        virtual void Wait() const override;
+        virtual uint64_t GetSubmitCount() const override { return m_SubmitCount.load(); }
+
+        virtual void Wait() override;
         virtual void Clear() override;
 
     private:
@@ -107,18 +118,44 @@ namespace fuujin {
             bool FenceOwned;
         };
 
+        struct CommandPool {
+            VkCommandPool Pool;
+            std::queue<StoredCommandBuffer> StoredBuffers;
+        };
+
+        // ranges into the semaphore arrays of the current batch
+        struct PendingSubmission {
+            VulkanCommandBuffer* Buffer;
+            size_t FirstWait, WaitCount;
+            size_t FirstSignal, SignalCount;
+        };
+
         void RT_Create();
-        void RT_GetQueue(uint32_t family);
-        void RT_CreatePool(uint32_t family);
+        void RT_GetQueue();
+        void RT_CreatePool();
+
+        // m_Mutex must be held for these
+        void RT_SubmitBatch();
+        void ReleaseFence(const StoredCommandBuffer& stored);
 
         QueueType m_Type;
         Ref<VulkanDevice> m_Device;
 
         VkQueue m_Queue;
-        VkCommandPool m_Pool;
-
+        uint32_t m_Family;
+        std::vector<CommandPool> m_Pools;
+
+        std::vector<PendingSubmission> m_Batch;
+        std::vector<VkSemaphore> m_BatchWaits;
+        std::vector<VkPipelineStageFlags> m_BatchWaitStages;
+        std::vector<Ref<VulkanSemaphore>> m_BatchSignals;
+        Ref<VulkanFence> m_BatchFence;
+        std::atomic<uint64_t> m_SubmitCount;
+
+        // owned fences are shared by every buffer in a batch
+        // they are only recycled once all of them have been recycled
         std::queue<Ref<VulkanFence>> m_AvailableFences;
-        std::queue<StoredCommandBuffer> m_StoredBuffers;
+        std::unordered_map<VulkanFence*, uint32_t> m_FenceUsers;
         std::mutex m_Mutex;
     };
 } // namespace fuujin
@@ -11,6 +11,8 @@
 #include "fuujin/platform/vulkan/VulkanBuffer.h"
 #include "fuujin/platform/vulkan/VulkanTexture.h"
 
+#include <fstream>
+
 namespace fuujin {
     static void* VKAPI_CALL VulkanAlloc(void* pUserData, size_t size, size_t alignment,
                                         VkSystemAllocationScope allocationScope) {
@@ -66,8 +68,111 @@ namespace fuujin {
         TracyVkCtx TracyContext = nullptr;
 
         std::unordered_map<QueueType, Ref<VulkanCommandQueue>> Queues;
+
+        VkPipelineCache PipelineCache = VK_NULL_HANDLE;
+        fs::path PipelineCachePath;
     };
 
+    // written ahead of the cache data, which is discarded if anything here does not match
+    struct PipelineCacheHeader {
+        uint32_t Magic, Version;
+        uint32_t VendorID, DeviceID, DriverVersion;
+        uint8_t CacheUUID[VK_UUID_SIZE];
+        uint64_t DataSize;
+    };
+
+    static constexpr uint32_t s_PipelineCacheMagic = 0x43504A46; // "FJPC"
+    static constexpr uint32_t s_PipelineCacheVersion = 1;
+    static const fs::path s_PipelineCacheDirectory = "cache/pipelines";
+
+    static void FillPipelineCacheHeader(const VkPhysicalDeviceProperties& properties,
+                                        PipelineCacheHeader& header) {
+        std::memset(&header, 0, sizeof(PipelineCacheHeader));
+
+        header.Magic = s_PipelineCacheMagic;
+        header.Version = s_PipelineCacheVersion;
+        header.VendorID = properties.vendorID;
+        header.DeviceID = properties.deviceID;
+        header.DriverVersion = properties.driverVersion;
+        std::memcpy(header.CacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    }
+
+    static Buffer ReadPipelineCache(const fs::path& path, const PipelineCacheHeader& expected) {
+        ZoneScoped;
+
+        std::ifstream file(path, std::ios::binary | std::ios::in);
+        if (!file.is_open()) {
+            return {};
+        }
+
+        PipelineCacheHeader header;
+        if (!file.read((char*)&header, sizeof(PipelineCacheHeader))) {
+            return {};
+        }
+
+        // a different driver or device may not be able to use the data at all
+        size_t comparedSize = offsetof(PipelineCacheHeader, DataSize);
+        if (std::memcmp(&header, &expected, comparedSize) != 0 || header.DataSize == 0) {
+            FUUJIN_INFO("Discarding stale pipeline cache {}", path.string().c_str());
+            return {};
+        }
+
+        Buffer data(header.DataSize);
+        if (!file.read((char*)data.Get(), (std::streamsize)header.DataSize)) {
+            FUUJIN_WARN("Pipeline cache {} is truncated! Discarding", path.string().c_str());
+            return {};
+        }
+
+        return data;
+    }
+
+    static void RT_WritePipelineCache(VkDevice device, VkPipelineCache cache,
+                                      const fs::path& path, PipelineCacheHeader header) {
+        ZoneScoped;
+
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(device, cache, &dataSize, nullptr) != VK_SUCCESS ||
+            dataSize == 0) {
+            return;
+        }
+
+        Buffer data(dataSize);
+        if (vkGetPipelineCacheData(device, cache, &dataSize, data.Get()) != VK_SUCCESS) {
+            FUUJIN_WARN("Failed to retrieve pipeline cache data!");
+            return;
+        }
+
+        header.DataSize = dataSize;
+
+        // written next to the cache first, so that a crash never leaves a partial file behind
+        std::error_code error;
+        fs::create_directories(path.parent_path(), error);
+
+        auto tempPath = path;
+        tempPath += ".tmp";
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::out | std::ios::trunc);
+            if (!file.is_open()) {
+                FUUJIN_WARN("Failed to open {} for writing!", tempPath.string().c_str());
+                return;
+            }
+
+            file.write((const char*)&header, sizeof(PipelineCacheHeader));
+            file.write((const char*)data.Get(), (std::streamsize)dataSize);
+
+            if (!file) {
+                FUUJIN_WARN("Failed to write pipeline cache!");
+                return;
+            }
+        }
+
+        fs::rename(tempPath, path, error);
+        if (error) {
+            FUUJIN_WARN("Failed to save pipeline cache: {}", error.message().c_str());
+        }
+    }
+
     static VKAPI_ATTR VkBool32 VKAPI_CALL VulkanDebugCallback(
         VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
         VkDebugUtilsMessageTypeFlagsEXT messageType,
@@ -237,6 +342,7 @@ namespace fuujin {
         device->Initialize();
         Renderer::Submit([this]() { RT_LoadDevice(); }, "Load device functions");
         Renderer::Submit([this]() { RT_CreateAllocator(); }, "Create allocator");
+        Renderer::Submit([this]() { RT_CreatePipelineCache(); }, "Create pipeline cache");
 
         Renderer::Submit(
             [this]() {
@@ -267,6 +373,28 @@ namespace fuujin {
         m_Data->Swapchain.Reset();
         m_Data->Queues.clear();
 
+        auto pipelineCache = m_Data->PipelineCache;
+        auto pipelineCachePath = m_Data->PipelineCachePath;
+        auto cacheDevice = m_Data->Devices[m_Data->UsedDevice];
+
+        Renderer::Submit(
+            [=]() {
+                if (pipelineCache == VK_NULL_HANDLE) {
+                    return;
+                }
+
+                VkPhysicalDeviceProperties2 properties{};
+                cacheDevice->RT_GetProperties(properties);
+
+                PipelineCacheHeader header;
+                FillPipelineCacheHeader(properties.properties, header);
+
+                auto device = cacheDevice->GetDevice();
+                RT_WritePipelineCache(device, pipelineCache, pipelineCachePath, header);
+                vkDestroyPipelineCache(device, pipelineCache, &GetAllocCallbacks());
+            },
+            "Save pipeline cache");
+
         auto tracyContext = m_Data->TracyContext;
         Renderer::Submit([tracyContext]() { TracyVkDestroy(tracyContext); });
 
@@ -293,6 +421,8 @@ namespace fuujin {
 
     Ref<VulkanInstance> VulkanContext::GetInstance() const { return m_Data->Instance; }
 
+    VkPipelineCache VulkanContext::GetPipelineCache() const { return m_Data->PipelineCache; }
+
     Ref<VulkanDevice> VulkanContext::GetVulkanDevice(
         const std::optional<std::string>& deviceName) const {
         auto name = deviceName.value_or(m_Data->UsedDevice);
@@ -468,6 +598,52 @@ namespace fuujin {
         }
     }
 
+    void VulkanContext::RT_CreatePipelineCache() {
+        ZoneScoped;
+        auto device = m_Data->Devices[m_Data->UsedDevice];
+
+        VkPhysicalDeviceProperties2 properties{};
+        device->RT_GetProperties(properties);
+
+        PipelineCacheHeader header;
+        FillPipelineCacheHeader(properties.properties, header);
+
+        // one file per device and driver, so that switching between them does not discard any cache
+        static constexpr char digits[] = "0123456789abcdef";
+
+        std::string filename;
+        for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+            filename += digits[header.CacheUUID[i] >> 4];
+            filename += digits[header.CacheUUID[i] & 0xF];
+        }
+
+        filename += ".bin";
+        m_Data->PipelineCachePath = s_PipelineCacheDirectory / filename;
+
+        auto data = ReadPipelineCache(m_Data->PipelineCachePath, header);
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = data.GetSize();
+        createInfo.pInitialData = data.Get();
+
+        auto callbacks = &GetAllocCallbacks();
+        if (vkCreatePipelineCache(device->GetDevice(), &createInfo, callbacks,
+                                  &m_Data->PipelineCache) == VK_SUCCESS) {
+            FUUJIN_DEBUG("Pipeline cache created with {} bytes of initial data", data.GetSize());
+            return;
+        }
+
+        // the driver may still reject data that passed our own checks
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+
+        if (vkCreatePipelineCache(device->GetDevice(), &createInfo, callbacks,
+                                  &m_Data->PipelineCache) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline cache!");
+        }
+    }
+
     void VulkanContext::RT_CreateTracyContext() {
         ZoneScoped;
 
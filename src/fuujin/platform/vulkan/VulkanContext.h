@@ -21,6 +21,9 @@ namespace fuujin {
 
         TracyVkCtx GetTracyContext() const;
 
+        // shared by every pipeline, and saved to disk when the context is destroyed
+        VkPipelineCache GetPipelineCache() const;
+
         virtual Ref<GraphicsDevice> GetDevice() const override;
         virtual Ref<Swapchain> GetSwapchain() const override;
         virtual Ref<CommandQueue> GetQueue(QueueType type) const override;
@@ -55,6 +58,7 @@ namespace fuujin {
         void RT_QueryPresentQueue();
         void RT_CreateAllocator();
         void RT_CreateTracyContext();
+        void RT_CreatePipelineCache();
 
         void RT_CreateDebugMessenger();
         void RT_EnumerateDevices(const std::optional<std::string>& deviceName);
@@ -378,6 +378,9 @@ namespace fuujin {
         }
     }
 
+    // the most textures a single table will hold, if the device allows that many
+    static constexpr uint32_t s_MaxBindlessTextures = 1024;
+
     void VulkanDevice::RT_GetDeviceProperties() {
         ZoneScoped;
 
@@ -393,6 +396,39 @@ namespace fuujin {
         api.TransposeMatrices = false;
         api.LeftHanded = false;
         api.Depth = DepthRange::ZeroToOne;
+        api.MaxBindlessTextures = 0;
+        api.LayeredVertexOutput = false;
+
+        uint32_t instanceVersion = m_Instance->GetSpec().API;
+        uint32_t deviceVersion = properties.properties.apiVersion;
+
+        if (instanceVersion >= VK_API_VERSION_1_2 && deviceVersion >= VK_API_VERSION_1_2) {
+            VkPhysicalDeviceVulkan12Features features12{};
+            features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+            VkPhysicalDeviceFeatures2 features{};
+            features.pNext = &features12;
+            RT_GetFeatures(features);
+
+            // every supported feature is enabled on device creation
+            if (features.features.shaderSampledImageArrayDynamicIndexing &&
+                features12.runtimeDescriptorArray && features12.descriptorBindingPartiallyBound &&
+                features12.descriptorBindingVariableDescriptorCount) {
+                // half of each limit is left to everything else bound alongside the table
+                const auto& limits = properties.properties.limits;
+                uint32_t limit = std::min(limits.maxPerStageDescriptorSamplers,
+                                          limits.maxPerStageDescriptorSampledImages);
+
+                limit = std::min(limit, limits.maxDescriptorSetSamplers);
+                limit = std::min(limit, limits.maxDescriptorSetSampledImages);
+
+                api.MaxBindlessTextures = std::min(s_MaxBindlessTextures, limit / 2);
+            }
+
+            // ShaderViewportIndexLayerEXT needs both under 1.2
+            api.LayeredVertexOutput =
+                features12.shaderOutputLayer && features12.shaderOutputViewportIndex;
+        }
 
         switch (properties.properties.deviceType) {
         case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
@@ -11,6 +11,7 @@ namespace fuujin {
         ZoneScoped;
 
         VkPipelineStageFlags stageMask = 0;
+        VkAccessFlags srcAccessMask = 0;
         VkAccessFlags dstAccessMask = 0;
 
         for (size_t i = 0; i < spec.Attachments.size(); i++) {
@@ -19,13 +20,24 @@ namespace fuujin {
             switch (attachment.Type) {
             case Framebuffer::AttachmentType::Color:
                 stageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+                srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
                 dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
+                if (spec.PreserveContents) {
+                    dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+                }
+
                 break;
             case Framebuffer::AttachmentType::Depth:
-                stageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+                stageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                             VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+                srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
                 dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+                if (spec.PreserveContents) {
+                    dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+                }
+
                 break;
             default:
                 FUUJIN_ERROR("Invalid attachment type!");
@@ -36,11 +48,14 @@ namespace fuujin {
         VkSubpassDependency dependency{};
         dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
         dependency.dstSubpass = 0;
-        dependency.srcStageMask = stageMask;
         dependency.dstStageMask = stageMask;
-        dependency.srcAccessMask = 0;
         dependency.dstAccessMask = dstAccessMask;
 
+        // waits on earlier writes to and samples of the images, so that renders on the same
+        // queue need no semaphore unless their results are read
+        dependency.srcStageMask = stageMask | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependency.srcAccessMask = srcAccessMask;
+
         std::set<size_t> resolveAttachmentIndices;
         for (size_t i = 0; i < spec.Attachments.size(); i++) {
             if (spec.Attachments[i].Type != Framebuffer::AttachmentType::Color) {
@@ -70,6 +85,12 @@ namespace fuujin {
             if (!resolveAttachmentIndices.contains(i)) {
                 desc.samples = samples;
                 desc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+
+                // attachments are left in their safe layout between renders
+                if (spec.PreserveContents) {
+                    desc.initialLayout = desc.finalLayout;
+                    desc.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+                }
             } else {
                 desc.samples = VK_SAMPLE_COUNT_1_BIT;
                 desc.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
@@ -186,6 +207,18 @@ namespace fuujin {
                 throw std::runtime_error("Invalid attachment type!");
             }
 
+            if (attachment.Source.IsPresent()) {
+                const auto& sourceSpec = attachment.Source->GetSpec();
+                if (sourceSpec.Width < m_Spec.Width || sourceSpec.Height < m_Spec.Height ||
+                    sourceSpec.ImageFormat != attachment.Format ||
+                    !sourceSpec.AdditionalFeatures.contains(attachmentFeature)) {
+                    throw std::runtime_error("Incompatible framebuffer attachment source!");
+                }
+
+                m_Textures.push_back(attachment.Source.As<VulkanTexture>());
+                continue;
+            }
+
             Texture::Spec spec;
             spec.Width = m_Spec.Width;
             spec.Height = m_Spec.Height;
@@ -213,8 +246,17 @@ namespace fuujin {
 
         Renderer::Submit(
             [&]() {
-                for (const auto& texture : m_Textures) {
-                    m_VulkanSpec.Attachments.push_back(texture->GetVulkanImage());
+                for (size_t i = 0; i < m_Textures.size(); i++) {
+                    auto image = m_Textures[i]->GetVulkanImage();
+
+                    // only the layers being rendered to are attached
+                    const auto& attachment = m_Spec.Attachments[i];
+                    if (attachment.Source.IsPresent()) {
+                        image = Ref<VulkanImage>::Create(image, VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+                                                         attachment.BaseLayer, m_Spec.Layers);
+                    }
+
+                    m_VulkanSpec.Attachments.push_back(image);
                 }
 
                 RT_Create();
@@ -255,17 +297,28 @@ namespace fuujin {
     void VulkanFramebuffer::RT_EndRender(CommandList& cmdList) {
         ZoneScoped;
 
+        RT_EndRender(cmdList, std::numeric_limits<uint32_t>::max());
+    }
+
+    void VulkanFramebuffer::RT_EndRender(CommandList& cmdList, uint32_t readAttachments) {
+        ZoneScoped;
+
         auto buffer = (VulkanCommandBuffer*)&cmdList;
         RT_EndRenderPass(buffer);
 
-        for (const auto& image : m_VulkanSpec.Attachments) {
+        for (size_t i = 0; i < m_VulkanSpec.Attachments.size(); i++) {
+            const auto& image = m_VulkanSpec.Attachments[i];
+
             auto semaphore = image->GetSignaledSemaphore();
             if (!semaphore.IsEmpty()) {
                 buffer->AddWaitSemaphore(semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
             }
 
-            semaphore = image->SignalUsed();
-            cmdList.AddSemaphore(semaphore, SemaphoreUsage::Signal);
+            // later renders to the same image are ordered by the render pass's dependency
+            if (i >= 32 || (readAttachments & (1u << i)) != 0) {
+                semaphore = image->SignalUsed();
+                cmdList.AddSemaphore(semaphore, SemaphoreUsage::Signal);
+            }
         }
     }
 
@@ -330,7 +383,13 @@ namespace fuujin {
         newSpec.Width = width;
         newSpec.Height = height;
 
-        return Ref<VulkanFramebuffer>::Create(m_Device, newSpec, *m_Allocator,
+        return Recreate(newSpec);
+    }
+
+    Ref<Framebuffer> VulkanFramebuffer::Recreate(const Spec& spec) const {
+        ZoneScoped;
+
+        return Ref<VulkanFramebuffer>::Create(m_Device, spec, *m_Allocator,
                                               m_VulkanSpec.RenderPass);
     }
 
@@ -40,6 +40,7 @@ namespace fuujin {
 
         virtual void RT_BeginRender(CommandList& cmdList, const glm::vec4& clearColor) override;
         virtual void RT_EndRender(CommandList& cmdList) override;
+        virtual void RT_EndRender(CommandList& cmdList, uint32_t readAttachments) override;
 
         void RT_BeginRenderPass(VulkanCommandBuffer* buffer, const glm::vec4& clear) const;
         void RT_EndRenderPass(VulkanCommandBuffer* buffer) const;
@@ -49,6 +50,7 @@ namespace fuujin {
         virtual Ref<Texture> GetTexture(size_t index) const override;
 
         virtual Ref<Framebuffer> Recreate(uint32_t width, uint32_t height) const override;
+        virtual Ref<Framebuffer> Recreate(const Spec& spec) const override;
 
     private:
         void RT_Create();
@@ -63,6 +63,25 @@ namespace fuujin {
         Renderer::Submit([&]() { RT_CreateView(); }, "Create image view");
     }
 
+    VulkanImage::VulkanImage(const Ref<VulkanImage>& image, VkImageViewType viewType,
+                             uint32_t baseLayer, uint32_t layerCount)
+        : m_Device(image->m_Device), m_ViewedImage(image), m_Spec(image->m_Spec),
+          m_Image(VK_NULL_HANDLE), m_View(VK_NULL_HANDLE), m_Allocation(VK_NULL_HANDLE) {
+        ZoneScoped;
+
+        m_Spec.ViewType = viewType;
+        m_Spec.BaseArrayLayer = image->m_Spec.BaseArrayLayer + baseLayer;
+        m_Spec.ArrayLayers = layerCount;
+
+        // the viewed image may not have been created yet
+        Renderer::Submit(
+            [&]() {
+                m_Image = m_ViewedImage->GetImage();
+                RT_CreateView();
+            },
+            "Create image view");
+    }
+
     VulkanImage::~VulkanImage() {
         ZoneScoped;
 
@@ -87,6 +106,10 @@ namespace fuujin {
     Ref<VulkanSemaphore> VulkanImage::SignalUsed() {
         ZoneScoped;
 
+        if (m_ViewedImage.IsPresent()) {
+            return m_ViewedImage->SignalUsed();
+        }
+
         m_SignaledSemaphore = Ref<VulkanSemaphore>::Create(m_Device);
         return m_SignaledSemaphore;
     }
@@ -94,6 +117,10 @@ namespace fuujin {
     Ref<VulkanSemaphore> VulkanImage::GetSignaledSemaphore() {
         ZoneScoped;
 
+        if (m_ViewedImage.IsPresent()) {
+            return m_ViewedImage->GetSignaledSemaphore();
+        }
+
         auto semaphore = m_SignaledSemaphore;
         m_SignaledSemaphore.Reset();
 
@@ -179,7 +206,7 @@ namespace fuujin {
         createInfo.subresourceRange.aspectMask = m_Spec.AspectFlags;
         createInfo.subresourceRange.baseMipLevel = 0;
         createInfo.subresourceRange.levelCount = m_Spec.MipLevels;
-        createInfo.subresourceRange.baseArrayLayer = 0;
+        createInfo.subresourceRange.baseArrayLayer = m_Spec.BaseArrayLayer;
         createInfo.subresourceRange.layerCount = m_Spec.ArrayLayers;
 
         if (vkCreateImageView(m_Device->GetDevice(), &createInfo,
@@ -200,7 +227,7 @@ namespace fuujin {
 
         const auto& spec = image->GetSpec();
         m_Subresource.aspectMask = spec.AspectFlags;
-        m_Subresource.baseArrayLayer = 0;
+        m_Subresource.baseArrayLayer = spec.BaseArrayLayer;
         m_Subresource.layerCount = spec.ArrayLayers;
         m_Subresource.baseMipLevel = 0;
         m_Subresource.levelCount = spec.MipLevels;
@@ -18,6 +18,7 @@ namespace fuujin {
             VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
             uint32_t MipLevels = 1;
             uint32_t ArrayLayers = 1;
+            uint32_t BaseArrayLayer = 0;
             VkImage ExistingImage = VK_NULL_HANDLE;
             VkImageCreateFlags Flags = 0;
             VkImageViewCreateFlags ViewFlags = 0;
@@ -37,6 +38,12 @@ namespace fuujin {
                                         const VkImageSubresourceRange& subresource);
 
         VulkanImage(const Ref<VulkanDevice>& device, const VulkanSpec& spec);
+
+        // views layerCount layers of the passed image, starting at baseLayer
+        // the view shares the image's memory, and so its semaphores
+        VulkanImage(const Ref<VulkanImage>& image, VkImageViewType viewType, uint32_t baseLayer,
+                    uint32_t layerCount);
+
         virtual ~VulkanImage() override;
 
         VkImage GetImage() const { return m_Image; }
@@ -58,6 +65,7 @@ namespace fuujin {
 
         Ref<VulkanDevice> m_Device;
         Ref<VulkanSemaphore> m_SignaledSemaphore;
+        Ref<VulkanImage> m_ViewedImage;
 
         VulkanSpec m_Spec;
 
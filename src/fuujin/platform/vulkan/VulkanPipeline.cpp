@@ -1,6 +1,7 @@
 #include "fuujinpch.h"
 #include "fuujin/platform/vulkan/VulkanPipeline.h"
 
+#include "fuujin/core/JobSystem.h"
 #include "fuujin/renderer/Renderer.h"
 
 #include "fuujin/platform/vulkan/VulkanContext.h"
@@ -9,14 +10,21 @@
 #include "fuujin/platform/vulkan/VulkanSwapchain.h"
 
 namespace fuujin {
+    static uint64_t s_PipelineID = 0;
+
     VulkanPipeline::VulkanPipeline(Ref<VulkanDevice> device, const Spec& spec) {
         ZoneScoped;
 
         m_Device = device;
         m_Spec = spec;
+        m_ID = s_PipelineID++;
 
         m_Pipeline = VK_NULL_HANDLE;
 
+        // draws are recorded ahead of the render thread, which creates the pipeline before it
+        // executes any of them, unless the pipeline is compiled asynchronously
+        m_Ready = !spec.Async;
+
         Renderer::Submit([this]() { RT_Create(); });
     }
 
@@ -33,19 +41,35 @@ namespace fuujin {
     void VulkanPipeline::RT_Create() {
         ZoneScoped;
 
+        // the shader and target are created on the render thread, and so are ready by now
+        if (m_Spec.Async) {
+            Ref<VulkanPipeline> self = this;
+            m_CompileJob = JobSystem::SubmitBackground([self]() { self->Compile(); });
+
+            return;
+        }
+
+        Compile();
+    }
+
+    void VulkanPipeline::Compile() {
+        ZoneScoped;
+
         switch (m_Spec.PipelineType) {
         case Type::Compute:
-            RT_CreateComputePipeline();
+            CreateComputePipeline();
             break;
         case Type::Graphics:
-            RT_CreateGraphicsPipeline();
+            CreateGraphicsPipeline();
             break;
         default:
             throw std::runtime_error("Invalid pipeline type!");
         }
+
+        m_Ready.store(true, std::memory_order_release);
     }
 
-    void VulkanPipeline::RT_CreateComputePipeline() {
+    void VulkanPipeline::CreateComputePipeline() {
         ZoneScoped;
 
         auto shader = m_Spec.PipelineShader.As<VulkanShader>();
@@ -62,14 +86,15 @@ namespace fuujin {
         createInfo.stage.module = modules.at(ShaderStage::Compute);
         createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
 
-        if (vkCreateComputePipelines(m_Device->GetDevice(), VK_NULL_HANDLE, 1, &createInfo,
+        auto cache = Renderer::GetContext().As<VulkanContext>()->GetPipelineCache();
+        if (vkCreateComputePipelines(m_Device->GetDevice(), cache, 1, &createInfo,
                                      &VulkanContext::GetAllocCallbacks(),
                                      &m_Pipeline) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create compute pipeline!");
         }
     }
 
-    void VulkanPipeline::RT_CreateGraphicsPipeline() {
+    void VulkanPipeline::CreateGraphicsPipeline() {
         ZoneScoped;
 
         Ref<VulkanRenderPass> renderPass;
@@ -254,7 +279,8 @@ namespace fuujin {
         createInfo.pColorBlendState = &colorBlend;
         createInfo.pDynamicState = &dynamicState;
 
-        if (vkCreateGraphicsPipelines(m_Device->GetDevice(), VK_NULL_HANDLE, 1, &createInfo,
+        auto cache = Renderer::GetContext().As<VulkanContext>()->GetPipelineCache();
+        if (vkCreateGraphicsPipelines(m_Device->GetDevice(), cache, 1, &createInfo,
                                       &VulkanContext::GetAllocCallbacks(),
                                       &m_Pipeline) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create graphics pipeline!");
@@ -12,14 +12,25 @@ namespace fuujin {
         virtual ~VulkanPipeline() override;
 
         virtual const Spec& GetSpec() const override { return m_Spec; }
+        virtual uint64_t GetID() const override { return m_ID; }
+
         VkPipeline GetPipeline() const { return m_Pipeline; }
 
+        virtual bool IsReady() const override { return m_Ready.load(std::memory_order_acquire); }
+        virtual Ref<JobCounter> GetCompileJob() const override { return m_CompileJob; }
+
     private:
         void RT_Create();
-        void RT_CreateComputePipeline();
-        void RT_CreateGraphicsPipeline();
 
+        // runs on the job system's background thread if the pipeline is compiled asynchronously
+        void Compile();
+        void CreateComputePipeline();
+        void CreateGraphicsPipeline();
+
+        uint64_t m_ID;
         VkPipeline m_Pipeline;
+        std::atomic<bool> m_Ready;
+        Ref<JobCounter> m_CompileJob;
 
         Spec m_Spec;
         Ref<VulkanDevice> m_Device;
@@ -11,12 +11,84 @@
 namespace fuujin {
     static uint64_t s_CurrentAllocationID = 0;
 
+    // kept around per recording thread to reuse capacity
+    static thread_local std::vector<uint32_t> s_DynamicOffsets;
+    static thread_local std::vector<VkDescriptorSet> s_DescriptorSets;
+    static thread_local std::vector<VkWriteDescriptorSet> s_DescriptorWrites;
+
+    // fnv-1a
+    static uint64_t HashBytes(const void* data, size_t size,
+                              uint64_t hash = 14695981039346656037ull) {
+        auto bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    // ranges are hashed and compared bytewise, and so must not have padding
+    static_assert(sizeof(VulkanDescriptorRange) == sizeof(uint32_t) * 4 + sizeof(size_t) * 2);
+
+    static bool IsImageDescriptor(VkDescriptorType type) {
+        switch (type) {
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+            return true;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+            return false;
+        default:
+            throw std::runtime_error("Unimplemented!");
+        }
+    }
+
+    bool VulkanSetContents::Matches(const VulkanSetContents& other) const {
+        ZoneScoped;
+
+        if (ShapeHash != other.ShapeHash || ShaderID != other.ShaderID || Set != other.Set ||
+            VariableCount != other.VariableCount || Ranges.size() != other.Ranges.size() ||
+            Data.GetSize() != other.Data.GetSize()) {
+            return false;
+        }
+
+        size_t rangeSize = Ranges.size() * sizeof(VulkanDescriptorRange);
+        return std::memcmp(Ranges.data(), other.Ranges.data(), rangeSize) == 0 &&
+               std::memcmp(Data.Get(), other.Data.Get(), Data.GetSize()) == 0;
+    }
+
     VulkanRendererAllocation::VulkanRendererAllocation(const Ref<VulkanShader>& shader) {
         ZoneScoped;
 
         m_Shader = shader;
         m_ID = s_CurrentAllocationID++;
         m_BindingsChanged = true;
+        m_Revision = m_ContentsRevision = 0;
+        m_DynamicOffsetCount = 0;
+
+        // every dynamic descriptor needs an offset when its set is bound, even if unused
+        for (const auto& [setIndex, resources] : shader->GetResources()) {
+            for (const auto& [bindingIndex, resource] : resources) {
+                auto descriptorType = VulkanShader::ConvertDescriptorType(resource.ResourceType);
+                if (descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+                    continue;
+                }
+
+                size_t descriptorCount = 1;
+                for (size_t dimension : resource.Dimensions) {
+                    descriptorCount *= dimension;
+                }
+
+                auto& setOffsets = m_DynamicOffsets[setIndex];
+                for (uint32_t i = 0; i < (uint32_t)descriptorCount; i++) {
+                    setOffsets[std::make_pair(bindingIndex, i)] = 0;
+                }
+
+                m_DynamicOffsetCount += (uint32_t)descriptorCount;
+            }
+        }
     }
 
     VulkanRendererAllocation::~VulkanRendererAllocation() {
@@ -44,11 +116,36 @@ namespace fuujin {
         data.Object = vulkanBuffer;
         data.DescriptorType = vulkanBuffer->GetDescriptorType();
 
+        // the offset of a dynamic descriptor is passed when binding, so moving within the same
+        // buffer does not change the descriptor
+        size_t descriptorOffset = offset;
+        {
+            std::lock_guard lock(m_Mutex);
+
+            if (data.DescriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+                auto key = std::make_pair(descriptor.Binding, index);
+                auto& setOffsets = m_DynamicOffsets[descriptor.Set];
+
+                if (setOffsets.contains(key)) {
+                    setOffsets[key] = (uint32_t)offset;
+                    descriptorOffset = 0;
+                }
+            }
+
+            // checked before the binder is built, as rebinding every frame must not allocate
+            data.Offset = descriptorOffset;
+            data.Range = bufferRange;
+
+            if (IsDescriptorCurrent(descriptor.Set, descriptor.Binding, index, data)) {
+                return true;
+            }
+        }
+
         auto bufferRaw = vulkanBuffer.Raw();
         data.Binder = [=](Buffer& block) {
             auto bufferInfo = (VkDescriptorBufferInfo*)block.Get();
             bufferInfo->buffer = bufferRaw->Get();
-            bufferInfo->offset = offset;
+            bufferInfo->offset = descriptorOffset;
             bufferInfo->range = bufferRange;
         };
 
@@ -70,6 +167,7 @@ namespace fuujin {
         VulkanDescriptor data;
         data.Object = texture;
         data.DescriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        data.Offset = data.Range = 0;
 
         auto raw = texture.As<VulkanTexture>().Raw();
         data.Binder = [=](Buffer& block) {
@@ -87,85 +185,60 @@ namespace fuujin {
         return true;
     }
 
-    struct SetAllocate {
-        VkDescriptorSetAllocateInfo AllocInfo;
-        uint32_t Offset;
-    };
-
-    void VulkanRendererAllocation::RT_AllocateDescriptorSets(const Ref<VulkanDevice>& device,
-                                                             VkDescriptorPool pool,
-                                                             DescriptorSetArray& sets) {
+    std::shared_ptr<const VulkanRendererAllocation::SetContents>
+    VulkanRendererAllocation::RT_GetSetContents() {
         ZoneScoped;
         std::lock_guard lock(m_Mutex);
 
-        if (m_BindingsChanged) {
-            RecalculateGroups();
+        if (m_Contents && m_ContentsRevision == m_Revision) {
+            return m_Contents;
         }
 
-        std::vector<VkDescriptorSetLayout> layouts;
-        std::map<uint32_t, size_t> offsetMap;
+        RecalculateGroups();
 
-        const auto& shaderLayouts = m_Shader->GetDescriptorSetLayouts();
-        for (const auto& [offset, count] : m_SetGroups) {
-            offsetMap[offset] = layouts.size();
+        auto contents = std::make_shared<SetContents>();
+        for (const auto& [setIndex, setBindings] : m_Bindings) {
+            contents->push_back(BuildSetContents(setIndex));
+        }
 
-            for (uint32_t i = 0; i < count; i++) {
-                uint32_t setIndex = offset + i;
+        m_Contents = contents;
+        m_ContentsRevision = m_Revision;
 
-                if (!shaderLayouts.contains(setIndex)) {
-                    throw std::runtime_error("No such set: " + std::to_string(setIndex));
-                }
+        return m_Contents;
+    }
 
-                layouts.push_back(shaderLayouts.at(setIndex));
-            }
-        }
+    void VulkanRendererAllocation::GetDynamicOffsets(uint32_t* offsets) {
+        ZoneScoped;
+        std::lock_guard lock(m_Mutex);
 
-        if (layouts.empty()) {
-            // vulkan doesnt like to be called to do nothing
-            return;
+        for (const auto& [set, setOffsets] : m_DynamicOffsets) {
+            for (const auto& [key, offset] : setOffsets) {
+                *offsets++ = offset;
+            }
         }
+    }
 
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = pool;
-        allocInfo.descriptorSetCount = (uint32_t)layouts.size();
-        allocInfo.pSetLayouts = layouts.data();
+    void VulkanRendererAllocation::GetDynamicOffsets(uint32_t set, const uint32_t* copy,
+                                                     std::vector<uint32_t>& offsets) const {
+        ZoneScoped;
 
-        std::vector<VkDescriptorSet> rawSets(layouts.size());
-        if (vkAllocateDescriptorSets(device->GetDevice(), &allocInfo, rawSets.data()) !=
-            VK_SUCCESS) {
-            throw std::runtime_error("Failed to allocate descriptor sets for renderer allocation!");
+        if (copy == nullptr) {
+            return;
         }
 
-        std::vector<VkWriteDescriptorSet> writes;
-        std::vector<Buffer> descriptorInfo(layouts.size());
-
-        for (const auto& [groupOffset, arrayOffset] : offsetMap) {
-            uint32_t groupSize = m_SetGroups.at(groupOffset);
-
-            auto begin = rawSets.begin() + arrayOffset;
-            auto end = begin + groupSize;
-
-            auto& setGroup = sets[groupOffset];
-            setGroup.resize(groupSize);
-            std::copy(begin, end, setGroup.begin());
-
-            for (uint32_t i = 0; i < setGroup.size(); i++) {
-                uint32_t setIndex = groupOffset + i;
-                uint32_t bufferIndex = arrayOffset + i;
-
-                BindSet(setGroup[i], setIndex, writes, descriptorInfo[bufferIndex]);
+        for (const auto& [setIndex, setOffsets] : m_DynamicOffsets) {
+            if (setIndex == set) {
+                offsets.insert(offsets.end(), copy, copy + setOffsets.size());
+                return;
             }
-        }
 
-        if (!writes.empty()) {
-            vkUpdateDescriptorSets(device->GetDevice(), (uint32_t)writes.size(), writes.data(), 0,
-                                   nullptr);
+            copy += setOffsets.size();
         }
     }
 
     bool VulkanRendererAllocation::IsDescriptorCurrent(uint32_t set, uint32_t binding,
-                                                       uint32_t index, void* object) const {
+                                                       uint32_t index,
+                                                       const VulkanDescriptor& data) const {
         ZoneScoped;
 
         if (!m_Bindings.contains(set)) {
@@ -182,8 +255,10 @@ namespace fuujin {
             return false;
         }
 
+        // buffers bound again with another range are written again
         const auto& descriptor = bindingData.Descriptors.at(index);
-        return object == (void*)descriptor.Object.Raw();
+        return data.Object.Raw() == descriptor.Object.Raw() && data.Offset == descriptor.Offset &&
+               data.Range == descriptor.Range;
     }
 
     void VulkanRendererAllocation::SetDescriptor(uint32_t set, uint32_t binding, uint32_t index,
@@ -193,7 +268,7 @@ namespace fuujin {
         ZoneScoped;
         std::lock_guard lock(m_Mutex);
 
-        if (IsDescriptorCurrent(set, binding, index, data.Object.Raw())) {
+        if (IsDescriptorCurrent(set, binding, index, data)) {
             return; // we dont need to do anything
         }
 
@@ -236,6 +311,7 @@ namespace fuujin {
         bindingData.DescriptorsChanged = true;
 
         m_BindingsChanged = true;
+        m_Revision++;
     }
 
     // solves for groups of keys within the input map
@@ -275,8 +351,6 @@ namespace fuujin {
             return;
         }
 
-        CalculateGenericGroups(m_Bindings, m_SetGroups);
-
         for (auto& [setIndex, bindings] : m_Bindings) {
             for (auto& [bindingIndex, binding] : bindings) {
                 if (!binding.DescriptorsChanged) {
@@ -312,22 +386,69 @@ namespace fuujin {
         m_BindingsChanged = false;
     }
 
-    void VulkanRendererAllocation::BindSet(VkDescriptorSet set, uint32_t index,
-                                           std::vector<VkWriteDescriptorSet>& writes,
-                                           Buffer& descriptorInfo) const {
+    std::shared_ptr<const VulkanSetContents> VulkanRendererAllocation::BuildSetContents(
+        uint32_t index) const {
         ZoneScoped;
 
         const auto& setBindings = m_Bindings.at(index);
         const auto& setResources = m_Shader->GetResources().at(index);
+        const auto& layouts = m_Shader->GetDescriptorSetLayouts();
+
+        if (!layouts.contains(index)) {
+            throw std::runtime_error("No such set: " + std::to_string(index));
+        }
+
+        auto contents = std::make_shared<VulkanSetContents>();
+        contents->ShaderID = m_Shader->GetID();
+        contents->Set = index;
+        contents->Layout = layouts.at(index);
+        contents->VariableCount = 0;
+        contents->Bindings = setBindings; // intentionally copy
+
+        // runtime-sized arrays only take as many descriptors from the pool as are bound
+        const auto& variableBindings = m_Shader->GetVariableBindings();
+        auto variableBinding = variableBindings.find(index);
+
+        if (variableBinding != variableBindings.end()) {
+            auto binding = setBindings.find(variableBinding->second);
+            if (binding != setBindings.end() && !binding->second.Descriptors.empty()) {
+                contents->VariableCount = binding->second.Descriptors.rbegin()->first + 1;
+            }
+        }
+
+        // every element of a fixed-size array takes a descriptor from the pool, bound or not
+        std::map<VkDescriptorType, uint32_t> poolSizes;
+        for (const auto& [bindingIndex, resource] : setResources) {
+            uint32_t descriptorCount = 1;
+            for (size_t dimension : resource.Dimensions) {
+                descriptorCount *= (uint32_t)dimension;
+            }
+
+            if (variableBinding != variableBindings.end() &&
+                variableBinding->second == bindingIndex) {
+                descriptorCount = contents->VariableCount;
+            }
+
+            if (descriptorCount > 0) {
+                auto descriptorType = VulkanShader::ConvertDescriptorType(resource.ResourceType);
+                poolSizes[descriptorType] += descriptorCount;
+            }
+        }
+
+        for (const auto& [descriptorType, descriptorCount] : poolSizes) {
+            contents->PoolSizes.push_back({ descriptorType, descriptorCount });
+        }
 
         size_t bufferSize = 0;
-        std::map<uint32_t, size_t> bufferOffsets;
         for (const auto& [bindingIndex, binding] : setBindings) {
-            bufferOffsets[bindingIndex] = bufferSize;
             bufferSize += binding.BufferSize;
         }
 
-        descriptorInfo = Buffer(bufferSize);
+        // padding within the descriptor info is hashed and compared along with everything else
+        contents->Data = Buffer(bufferSize);
+        std::memset(contents->Data.Get(), 0, bufferSize);
+
+        size_t bufferOffset = 0;
         for (const auto& [bindingIndex, binding] : setBindings) {
             const auto& resource = setResources.at(bindingIndex);
             auto descriptorType = VulkanShader::ConvertDescriptorType(resource.ResourceType);
@@ -339,28 +460,13 @@ namespace fuujin {
             }
 
             for (const auto& [offset, size] : binding.Groups) {
-                uint32_t groupOffset = bufferOffsets.at(bindingIndex) +
-                                       binding.OffsetMap.at(offset) * binding.BufferStride;
-                auto groupSlice = descriptorInfo.Slice(groupOffset);
-
-                VkWriteDescriptorSet write{};
-                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                write.descriptorType = descriptorType;
-                write.dstSet = set;
-                write.dstBinding = bindingIndex;
-                write.dstArrayElement = offset;
-                write.descriptorCount = size;
-
-                switch (binding.Type) {
-                case VulkanBindingType::Buffer:
-                    write.pBufferInfo = groupSlice.As<VkDescriptorBufferInfo>();
-                    break;
-                case VulkanBindingType::Image:
-                    write.pImageInfo = groupSlice.As<VkDescriptorImageInfo>();
-                    break;
-                default:
-                    throw std::runtime_error("Unimplemented!");
-                }
+                auto& range = contents->Ranges.emplace_back();
+                range.Binding = bindingIndex;
+                range.FirstElement = offset;
+                range.Count = size;
+                range.DescriptorType = descriptorType;
+                range.Offset = bufferOffset;
+                range.Stride = binding.BufferStride;
 
                 for (uint32_t i = 0; i < size; i++) {
                     uint32_t arrayIndex = offset + i;
@@ -371,15 +477,28 @@ namespace fuujin {
                                      bindingIndex, arrayIndex);
                     }
 
-                    auto descriptorSlice =
-                        groupSlice.Slice(i * binding.BufferStride, binding.BufferStride);
+                    auto descriptorSlice = contents->Data.Slice(
+                        bufferOffset + i * binding.BufferStride, binding.BufferStride);
 
                     data.Binder(descriptorSlice);
                 }
 
-                writes.push_back(write);
+                bufferOffset += size * binding.BufferStride;
             }
         }
+
+        uint64_t shapeHash = HashBytes(&contents->ShaderID, sizeof(uint64_t));
+        shapeHash = HashBytes(&contents->Set, sizeof(uint32_t), shapeHash);
+        shapeHash = HashBytes(contents->Ranges.data(),
+                              contents->Ranges.size() * sizeof(VulkanDescriptorRange), shapeHash);
+
+        uint64_t hash = HashBytes(&contents->VariableCount, sizeof(uint32_t), shapeHash);
+        hash = HashBytes(contents->Data.Get(), bufferSize, hash);
+
+        contents->ShapeHash = shapeHash;
+        contents->Hash = hash;
+
+        return contents;
     }
 
     VulkanRenderer::VulkanRenderer(Ref<VulkanDevice> device, uint32_t frames) {
@@ -388,22 +507,42 @@ namespace fuujin {
         m_Device = device;
         m_FrameCount = frames;
         m_CurrentFrame = 0;
+        m_FrameIndex = 0;
+        m_UseUpdateTemplates = false;
+        m_CurrentPool = 0;
+        m_SetDemand = 0;
+
+        m_SetAllocations = m_SetUpdates = 0;
+        m_CachedSets = m_PoolCount = 0;
 
         Renderer::Submit([this]() { RT_CreatePools(); }, "Create renderer descriptor pools");
+        Renderer::Submit([this]() { RT_QueryDeviceSupport(); }, "Query renderer device support");
     }
 
     VulkanRenderer::~VulkanRenderer() {
         ZoneScoped;
         Renderer::GetGraphicsQueue()->Clear();
 
+        // destroying the pools frees every set allocated from them
         std::vector<VkDescriptorPool> pools;
         for (const auto& pool : m_DescriptorPools) {
-            pools.push_back(pool.DescriptorPool);
+            pools.push_back(pool.Pool);
+        }
+
+        m_DescriptorSets.clear();
+
+        std::vector<VkDescriptorUpdateTemplate> updateTemplates;
+        for (const auto& [shapeHash, updateTemplate] : m_UpdateTemplates) {
+            updateTemplates.push_back(updateTemplate);
         }
 
         auto device = m_Device->GetDevice();
         Renderer::Submit([=]() {
             auto callbacks = &VulkanContext::GetAllocCallbacks();
+            for (auto updateTemplate : updateTemplates) {
+                vkDestroyDescriptorUpdateTemplate(device, updateTemplate, callbacks);
+            }
+
             for (auto pool : pools) {
                 vkDestroyDescriptorPool(device, pool, callbacks);
             }
@@ -414,7 +553,14 @@ namespace fuujin {
         ZoneScoped;
 
         m_CurrentFrame = frame;
-        m_DescriptorPools[frame].MarkedForReset = true;
+
+        {
+            // render targets may be recorded from several threads at once
+            std::lock_guard lock(m_PoolMutex);
+
+            m_FrameIndex++;
+            RT_EvictDescriptorSets();
+        }
 
         auto context = Renderer::GetContext().As<VulkanContext>();
         if (context) {
@@ -433,43 +579,63 @@ namespace fuujin {
         }
     }
 
-    void VulkanRenderer::RT_RenderIndexed(CommandList& cmdlist, const IndexedRenderCall& data) {
+    void VulkanRenderer::RT_BindRenderCall(VulkanCommandBuffer& cmdBuffer,
+                                           const IndexedRenderCall& data) {
         ZoneScoped;
 
         std::vector<VkBuffer> vertexBuffers;
         for (const auto& buffer : data.VertexBuffers) {
             vertexBuffers.push_back(buffer.As<VulkanBuffer>()->Get());
-            cmdlist.AddDependency(buffer);
+            cmdBuffer.AddDependency(buffer);
         }
 
-        cmdlist.AddDependency(data.IndexBuffer);
-        cmdlist.AddDependency(data.RenderPipeline);
-        cmdlist.AddDependency(data.RenderPipeline);
+        cmdBuffer.AddDependency(data.IndexBuffer);
+        cmdBuffer.AddDependency(data.RenderPipeline);
 
         auto indexBuffer = data.IndexBuffer.As<VulkanBuffer>()->Get();
         auto vkPipeline = data.RenderPipeline.As<VulkanPipeline>();
         auto shader = vkPipeline->GetSpec().PipelineShader.As<VulkanShader>();
 
-        auto& cmdBuffer = (VulkanCommandBuffer&)cmdlist;
         auto vkCmdBuffer = cmdBuffer.Get();
+        if (data.BindVertexBuffers) {
+            uint32_t bufferCount = (uint32_t)vertexBuffers.size();
+            std::vector<VkDeviceSize> offsets(bufferCount, 0);
+            vkCmdBindVertexBuffers(vkCmdBuffer, 0, bufferCount, vertexBuffers.data(),
+                                   offsets.data());
+        }
 
-        TracyVkZone(m_TracyContext, vkCmdBuffer, "RT_RenderIndexed");
+        if (data.BindIndexBuffer) {
+            vkCmdBindIndexBuffer(vkCmdBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        }
 
-        uint32_t bufferCount = (uint32_t)vertexBuffers.size();
-        std::vector<VkDeviceSize> offsets(bufferCount, 0);
-        vkCmdBindVertexBuffers(vkCmdBuffer, 0, bufferCount, vertexBuffers.data(), offsets.data());
-        vkCmdBindIndexBuffer(vkCmdBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdBindPipeline(vkCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vkPipeline->GetPipeline());
+        if (data.BindPipeline) {
+            vkCmdBindPipeline(vkCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              vkPipeline->GetPipeline());
+        }
 
         std::set<uint32_t> boundSets;
-        for (const auto& allocation : data.Resources) {
+        const uint32_t* dynamicOffsets = data.DynamicOffsets;
+
+        for (size_t i = 0; i < data.Resources.size(); i++) {
+            const auto& allocation = data.Resources[i];
             if (!allocation) {
                 FUUJIN_ERROR("Attempted to bind nullptr allocation! Skipping");
                 continue;
             }
 
+            // the offsets of skipped resources are still stepped over
+            const uint32_t* allocationOffsets = dynamicOffsets;
+            if (dynamicOffsets != nullptr) {
+                dynamicOffsets += allocation->GetDynamicOffsetCount();
+            }
+
+            if (i < 32 && (data.BoundResources & (1u << i)) != 0) {
+                continue;
+            }
+
             auto rendererAlloc = allocation.As<VulkanRendererAllocation>();
-            RT_BindAllocation(cmdBuffer, rendererAlloc, VK_PIPELINE_BIND_POINT_GRAPHICS, boundSets);
+            RT_BindAllocation(cmdBuffer, rendererAlloc, allocationOffsets,
+                              VK_PIPELINE_BIND_POINT_GRAPHICS, boundSets);
         }
 
         if (data.PushConstants) {
@@ -486,8 +652,19 @@ namespace fuujin {
                                    data.PushConstants.Get());
             }
         }
+    }
 
-        vkCmdDrawIndexed(vkCmdBuffer, data.IndexCount, 1, data.IndexOffset, data.VertexOffset, 0);
+    void VulkanRenderer::RT_RenderIndexed(CommandList& cmdlist, const IndexedRenderCall& data) {
+        ZoneScoped;
+
+        auto& cmdBuffer = (VulkanCommandBuffer&)cmdlist;
+        auto vkCmdBuffer = cmdBuffer.Get();
+
+        TracyVkZone(m_TracyContext, vkCmdBuffer, "RT_RenderIndexed");
+        RT_BindRenderCall(cmdBuffer, data);
+
+        vkCmdDrawIndexed(vkCmdBuffer, data.IndexCount, data.InstanceCount, data.IndexOffset,
+                         data.VertexOffset, data.FirstInstance);
     }
 
     void VulkanRenderer::RT_SetViewport(CommandList& cmdlist, Ref<RenderTarget> target,
@@ -560,54 +737,393 @@ namespace fuujin {
         vkCmdEndDebugUtilsLabelEXT(cmdBuffer->Get());
     }
 
+    void VulkanRenderer::RT_ClearLayers(CommandList& cmdlist, Ref<RenderTarget> target,
+                                        uint32_t layerMask, const glm::vec4& clearColor) const {
+        ZoneScoped;
+
+        if (target->GetType() != RenderTargetType::Framebuffer) {
+            throw std::runtime_error("Only framebuffer layers can be cleared!");
+        }
+
+        const auto& spec = target.As<Framebuffer>()->GetSpec();
+
+        std::set<size_t> resolveAttachments;
+        for (const auto& [color, resolve] : spec.ResolveAttachments) {
+            resolveAttachments.insert(resolve);
+        }
+
+        // color attachments are indexed by their position in the subpass
+        std::vector<VkClearAttachment> attachments;
+        uint32_t colorAttachment = 0;
+
+        for (size_t i = 0; i < spec.Attachments.size(); i++) {
+            if (resolveAttachments.contains(i)) {
+                continue;
+            }
+
+            auto& attachment = attachments.emplace_back();
+            switch (spec.Attachments[i].Type) {
+            case Framebuffer::AttachmentType::Color:
+                attachment.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                attachment.colorAttachment = colorAttachment++;
+                std::memcpy(attachment.clearValue.color.float32, &clearColor.x, sizeof(float) * 4);
+
+                break;
+            case Framebuffer::AttachmentType::Depth:
+                attachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+                attachment.clearValue.depthStencil = { 1.f, 0 };
+
+                break;
+            default:
+                throw std::runtime_error("Invalid attachment type!");
+            }
+        }
+
+        std::vector<VkClearRect> rects;
+        for (uint32_t i = 0; i < spec.Layers; i++) {
+            if ((layerMask & (1u << i)) == 0) {
+                continue;
+            }
+
+            auto& rect = rects.emplace_back();
+            rect.rect.offset = { 0, 0 };
+            rect.rect.extent = { target->GetWidth(), target->GetHeight() };
+            rect.baseArrayLayer = i;
+            rect.layerCount = 1;
+        }
+
+        if (attachments.empty() || rects.empty()) {
+            return;
+        }
+
+        auto cmdBuffer = ((VulkanCommandBuffer&)cmdlist).Get();
+        vkCmdClearAttachments(cmdBuffer, (uint32_t)attachments.size(), attachments.data(),
+                              (uint32_t)rects.size(), rects.data());
+    }
+
     Ref<RendererAllocation> VulkanRenderer::CreateAllocation(const Ref<Shader>& shader) const {
         ZoneScoped;
 
         return Ref<VulkanRendererAllocation>::Create(shader.As<VulkanShader>());
     }
 
+    RendererAPI::DescriptorCounts VulkanRenderer::GetDescriptorCounts() const {
+        ZoneScoped;
+
+        DescriptorCounts counts;
+        counts.SetAllocations = m_SetAllocations.load();
+        counts.SetUpdates = m_SetUpdates.load();
+        counts.CachedSets = m_CachedSets.load();
+        counts.Pools = m_PoolCount.load();
+
+        return counts;
+    }
+
+    void VulkanRenderer::RT_QueryDeviceSupport() {
+        ZoneScoped;
+
+        VkPhysicalDeviceProperties2 properties{};
+        m_Device->RT_GetProperties(properties);
+
+        // update templates are core as of 1.1
+        uint32_t instanceVersion = m_Device->GetInstance()->GetSpec().API;
+        uint32_t deviceVersion = properties.properties.apiVersion;
+
+        m_UseUpdateTemplates = instanceVersion >= VK_API_VERSION_1_1 &&
+                               deviceVersion >= VK_API_VERSION_1_1 &&
+                               vkUpdateDescriptorSetWithTemplate != nullptr;
+    }
+
+    // descriptors of each type per set, for the first pool
+    static const std::vector<VkDescriptorPoolSize> s_DefaultPoolRatios = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 4 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+    };
+
+    static constexpr uint32_t s_MinPoolSets = 256;
+    static constexpr uint32_t s_MaxPoolSets = 4096;
+
     void VulkanRenderer::RT_CreatePools() {
         ZoneScoped;
+        std::lock_guard lock(m_PoolMutex);
 
-        static const std::vector<VkDescriptorPoolSize> poolSizes = {
-            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 100 },
-            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 100 },
-        };
+        m_CurrentPool = RT_CreatePool(nullptr);
+    }
+
+    void VulkanRenderer::RT_EvictDescriptorSets() {
+        ZoneScoped;
+
+        // the frame that last used a set is done once its slot comes around again
+        std::map<size_t, std::vector<VkDescriptorSet>> evicted;
+        for (auto it = m_DescriptorSets.begin(); it != m_DescriptorSets.end();) {
+            if (it->second.LastUsed + m_FrameCount > m_FrameIndex) {
+                it++;
+                continue;
+            }
+
+            evicted[it->second.Pool].push_back(it->second.Set);
+            it = m_DescriptorSets.erase(it);
+        }
+
+        for (const auto& [index, sets] : evicted) {
+            auto& pool = m_DescriptorPools[index];
+            pool.LiveSets -= sets.size();
+
+            // resetting a pool frees everything in it at once
+            if (pool.LiveSets == 0 && index != m_CurrentPool) {
+                RT_RecyclePool(index);
+                continue;
+            }
+
+            vkFreeDescriptorSets(m_Device->GetDevice(), pool.Pool, (uint32_t)sets.size(),
+                                 sets.data());
+        }
+
+        m_CachedSets = m_DescriptorSets.size();
+    }
+
+    size_t VulkanRenderer::RT_CreatePool(const VulkanSetContents* contents) {
+        ZoneScoped;
+
+        // each pool can hold about as many sets as are already cached, doubling the capacity
+        uint32_t maxSets = (uint32_t)std::min<size_t>(m_DescriptorSets.size(), s_MaxPoolSets);
+        maxSets = std::max(maxSets, s_MinPoolSets);
+
+        std::unordered_map<VkDescriptorType, uint32_t> descriptorCounts;
+        if (m_SetDemand > 0) {
+            for (const auto& [descriptorType, demand] : m_DescriptorDemand) {
+                uint64_t descriptorCount = (demand * maxSets + m_SetDemand - 1) / m_SetDemand;
+                descriptorCounts[descriptorType] = (uint32_t)descriptorCount;
+            }
+        } else {
+            for (const auto& ratio : s_DefaultPoolRatios) {
+                descriptorCounts[ratio.type] = ratio.descriptorCount * maxSets;
+            }
+        }
+
+        if (contents != nullptr) {
+            for (const auto& size : contents->PoolSizes) {
+                auto& descriptorCount = descriptorCounts[size.type];
+                descriptorCount = std::max(descriptorCount, size.descriptorCount);
+            }
+        }
+
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (const auto& [descriptorType, descriptorCount] : descriptorCounts) {
+            poolSizes.push_back({ descriptorType, descriptorCount });
+        }
 
         VkDescriptorPoolCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        createInfo.maxSets = 30;
+        createInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        createInfo.maxSets = maxSets;
         createInfo.poolSizeCount = (uint32_t)poolSizes.size();
         createInfo.pPoolSizes = poolSizes.data();
 
+        auto& pool = m_DescriptorPools.emplace_back();
+        pool.MaxSets = maxSets;
+        pool.LiveSets = 0;
+
         auto callbacks = &VulkanContext::GetAllocCallbacks();
-        m_DescriptorPools.resize(m_FrameCount);
-        for (auto& pool : m_DescriptorPools) {
-            pool.MarkedForReset = false;
+        if (vkCreateDescriptorPool(m_Device->GetDevice(), &createInfo, callbacks, &pool.Pool) !=
+            VK_SUCCESS) {
+            m_DescriptorPools.pop_back();
+            throw std::runtime_error("Failed to create descriptor pool!");
+        }
 
-            if (vkCreateDescriptorPool(m_Device->GetDevice(), &createInfo, callbacks,
-                                       &pool.DescriptorPool) != VK_SUCCESS) {
-                throw std::runtime_error("Failed to create descriptor pool!");
+        m_PoolCount = m_DescriptorPools.size();
+        return m_DescriptorPools.size() - 1;
+    }
+
+    void VulkanRenderer::RT_RecyclePool(size_t index) {
+        ZoneScoped;
+
+        auto& pool = m_DescriptorPools[index];
+        if (pool.LiveSets > 0) {
+            return;
+        }
+
+        vkResetDescriptorPool(m_Device->GetDevice(), pool.Pool, 0);
+        m_FreePools.push_back(index);
+    }
+
+    size_t VulkanRenderer::RT_AllocateDescriptorSet(const VulkanSetContents& contents,
+                                                    VkDescriptorSet& set) {
+        ZoneScoped;
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &contents.Layout;
+
+        VkDescriptorSetVariableDescriptorCountAllocateInfo variableInfo{};
+        if (contents.VariableCount > 0) {
+            variableInfo.sType =
+                VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+
+            variableInfo.descriptorSetCount = 1;
+            variableInfo.pDescriptorCounts = &contents.VariableCount;
+
+            allocInfo.pNext = &variableInfo;
+        }
+
+        // the current pool is tried first, then a recycled one, then a new one that fits the set
+        bool triedFreePool = false;
+        bool createdPool = false;
+
+        while (true) {
+            allocInfo.descriptorPool = m_DescriptorPools[m_CurrentPool].Pool;
+
+            VkResult result = vkAllocateDescriptorSets(m_Device->GetDevice(), &allocInfo, &set);
+            if (result == VK_SUCCESS) {
+                break;
             }
+
+            if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) ||
+                createdPool) {
+                throw std::runtime_error("Failed to allocate descriptor set!");
+            }
+
+            // the exhausted pool is recycled once every set in it has been evicted
+            size_t exhausted = m_CurrentPool;
+            if (!triedFreePool && !m_FreePools.empty()) {
+                m_CurrentPool = m_FreePools.back();
+                m_FreePools.pop_back();
+
+                triedFreePool = true;
+            } else {
+                m_CurrentPool = RT_CreatePool(&contents);
+                createdPool = true;
+            }
+
+            RT_RecyclePool(exhausted);
+        }
+
+        m_DescriptorPools[m_CurrentPool].LiveSets++;
+        m_SetDemand++;
+
+        for (const auto& size : contents.PoolSizes) {
+            m_DescriptorDemand[size.type] += size.descriptorCount;
+        }
+
+        return m_CurrentPool;
+    }
+
+    VkDescriptorSet VulkanRenderer::RT_GetDescriptorSet(
+        const std::shared_ptr<const VulkanSetContents>& contents) {
+        ZoneScoped;
+
+        auto [begin, end] = m_DescriptorSets.equal_range(contents->Hash);
+        for (auto it = begin; it != end; it++) {
+            auto& cached = it->second;
+            if (cached.Contents != contents && !cached.Contents->Matches(*contents)) {
+                continue;
+            }
+
+            cached.LastUsed = m_FrameIndex;
+            return cached.Set;
         }
+
+        CachedDescriptorSet cached;
+        cached.Pool = RT_AllocateDescriptorSet(*contents, cached.Set);
+        cached.LastUsed = m_FrameIndex;
+        cached.Contents = contents;
+
+        m_SetAllocations++;
+        RT_WriteDescriptorSet(cached.Set, *contents);
+
+        auto set = cached.Set;
+        m_DescriptorSets.emplace(contents->Hash, std::move(cached));
+        m_CachedSets = m_DescriptorSets.size();
+
+        return set;
     }
 
-    void VulkanRenderer::RT_ResetCurrentPool() {
+    void VulkanRenderer::RT_WriteDescriptorSet(VkDescriptorSet set,
+                                               const VulkanSetContents& contents) {
         ZoneScoped;
 
-        auto& pool = m_DescriptorPools[m_CurrentFrame];
-        if (!pool.MarkedForReset) {
+        auto device = m_Device->GetDevice();
+        m_SetUpdates++;
+
+        if (m_UseUpdateTemplates) {
+            auto updateTemplate = RT_GetUpdateTemplate(contents);
+            vkUpdateDescriptorSetWithTemplate(device, set, updateTemplate, contents.Data.Get());
+
             return;
         }
 
-        vkResetDescriptorPool(m_Device->GetDevice(), pool.DescriptorPool, 0);
+        auto& writes = s_DescriptorWrites;
+        writes.clear();
+
+        for (const auto& range : contents.Ranges) {
+            auto rangeSlice = contents.Data.Slice(range.Offset);
+
+            auto& write = writes.emplace_back();
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.pNext = nullptr;
+            write.dstSet = set;
+            write.dstBinding = range.Binding;
+            write.dstArrayElement = range.FirstElement;
+            write.descriptorCount = range.Count;
+            write.descriptorType = range.DescriptorType;
+            write.pImageInfo = nullptr;
+            write.pBufferInfo = nullptr;
+            write.pTexelBufferView = nullptr;
+
+            if (IsImageDescriptor(range.DescriptorType)) {
+                write.pImageInfo = rangeSlice.As<VkDescriptorImageInfo>();
+            } else {
+                write.pBufferInfo = rangeSlice.As<VkDescriptorBufferInfo>();
+            }
+        }
 
-        pool.Allocations.clear();
-        pool.MarkedForReset = false;
+        vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+    }
+
+    VkDescriptorUpdateTemplate VulkanRenderer::RT_GetUpdateTemplate(
+        const VulkanSetContents& contents) {
+        ZoneScoped;
+
+        auto it = m_UpdateTemplates.find(contents.ShapeHash);
+        if (it != m_UpdateTemplates.end()) {
+            return it->second;
+        }
+
+        std::vector<VkDescriptorUpdateTemplateEntry> entries;
+        for (const auto& range : contents.Ranges) {
+            auto& entry = entries.emplace_back();
+            entry.dstBinding = range.Binding;
+            entry.dstArrayElement = range.FirstElement;
+            entry.descriptorCount = range.Count;
+            entry.descriptorType = range.DescriptorType;
+            entry.offset = range.Offset;
+            entry.stride = range.Stride;
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        createInfo.descriptorUpdateEntryCount = (uint32_t)entries.size();
+        createInfo.pDescriptorUpdateEntries = entries.data();
+        createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        createInfo.descriptorSetLayout = contents.Layout;
+
+        VkDescriptorUpdateTemplate updateTemplate;
+        auto callbacks = &VulkanContext::GetAllocCallbacks();
+
+        if (vkCreateDescriptorUpdateTemplate(m_Device->GetDevice(), &createInfo, callbacks,
+                                             &updateTemplate) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create descriptor update template!");
+        }
+
+        m_UpdateTemplates[contents.ShapeHash] = updateTemplate;
+        return updateTemplate;
     }
 
     void VulkanRenderer::RT_BindAllocation(VulkanCommandBuffer& cmdBuffer,
                                            Ref<VulkanRendererAllocation> allocation,
+                                           const uint32_t* dynamicOffsets,
                                            VkPipelineBindPoint bindPoint,
                                            std::set<uint32_t>& boundSets) {
         ZoneScoped;
@@ -615,45 +1131,57 @@ namespace fuujin {
         auto vkCmdBuffer = cmdBuffer.Get();
         TracyVkZone(m_TracyContext, vkCmdBuffer, "RT_BindAllocation");
 
-        RT_ResetCurrentPool();
+        // sets with matching contents are reused across frames and allocations
+        auto contents = allocation->RT_GetSetContents();
+        for (const auto& setContents : *contents) {
+            if (boundSets.contains(setContents->Set)) {
+                FUUJIN_ERROR(
+                    "Set {} already bound for this render call! Aborting binding of allocation {}",
+                    setContents->Set, allocation->GetID());
 
-        uint64_t allocID = allocation->GetID();
-        auto& pool = m_DescriptorPools[m_CurrentFrame];
+                return;
+            }
+        }
 
-        FrameAllocationData* allocData = nullptr;
-        if (!pool.Allocations.contains(allocID)) {
-            allocData = &pool.Allocations[allocID];
+        auto& sets = s_DescriptorSets;
+        sets.clear();
 
-            // for ref counting
-            allocData->Allocation = allocation;
-            allocData->Bindings = allocation->GetBindings(); // intentionally copy
+        {
+            // render targets may be recorded from several threads at once
+            std::lock_guard lock(m_PoolMutex);
 
-            allocation->RT_AllocateDescriptorSets(m_Device, pool.DescriptorPool, allocData->Sets);
+            for (const auto& setContents : *contents) {
+                sets.push_back(RT_GetDescriptorSet(setContents));
+            }
         }
 
-        allocData = &pool.Allocations.at(allocID);
         auto pipelineLayout = allocation->GetShader()->GetPipelineLayout();
+        auto& setOffsets = s_DynamicOffsets;
 
-        std::set<uint32_t> currentSets;
-        for (const auto& [id, setBindings] : allocData->Sets) {
-            if (boundSets.contains(id)) {
-                FUUJIN_ERROR(
-                    "Set {} already bound for this render call! Aborting binding of allocation {}",
-                    id, allocID);
+        // consecutive sets are bound with a single call
+        for (size_t first = 0; first < contents->size();) {
+            uint32_t firstSet = contents->at(first)->Set;
 
-                return;
+            size_t count = 1;
+            while (first + count < contents->size() &&
+                   contents->at(first + count)->Set == firstSet + count) {
+                count++;
             }
 
-            currentSets.insert(id);
-        }
+            setOffsets.clear();
+            for (uint32_t i = 0; i < (uint32_t)count; i++) {
+                allocation->GetDynamicOffsets(firstSet + i, dynamicOffsets, setOffsets);
+            }
 
-        for (const auto& [firstSet, sets] : allocData->Sets) {
             vkCmdBindDescriptorSets(vkCmdBuffer, bindPoint, pipelineLayout, firstSet,
-                                    (uint32_t)sets.size(), sets.data(), 0, nullptr);
+                                    (uint32_t)count, sets.data() + first,
+                                    (uint32_t)setOffsets.size(), setOffsets.data());
+
+            first += count;
         }
 
-        for (const auto& [setIndex, setBindings] : allocData->Bindings) {
-            for (const auto& [bindingIndex, bindingData] : setBindings) {
+        for (const auto& setContents : *contents) {
+            for (const auto& [bindingIndex, bindingData] : setContents->Bindings) {
                 if (bindingData.ImageType == VulkanImageType::None) {
                     continue;
                 }
@@ -685,6 +1213,8 @@ namespace fuujin {
             }
         }
 
-        boundSets.insert(currentSets.begin(), currentSets.end());
+        for (const auto& setContents : *contents) {
+            boundSets.insert(setContents->Set);
+        }
     }
 } // namespace fuujin
@@ -11,6 +11,9 @@ namespace fuujin {
         Ref<RefCounted> Object;
         VkDescriptorType DescriptorType;
         std::function<void(Buffer&)> Binder;
+
+        // the bound range of a buffer; 0 for images
+        size_t Offset, Range;
     };
 
     enum class VulkanBindingType { Buffer, Image };
@@ -29,16 +32,47 @@ namespace fuujin {
         VulkanImageType ImageType;
     };
 
+    struct VulkanDescriptorRange {
+        uint32_t Binding, FirstElement, Count;
+        VkDescriptorType DescriptorType;
+
+        // where the range's descriptor info is in VulkanSetContents::Data
+        size_t Offset, Stride;
+    };
+
+    // everything written to a single descriptor set
+    // sets written with matching contents are interchangeable, and are shared between allocations
+    struct VulkanSetContents {
+        uint64_t ShaderID;
+        uint32_t Set;
+        VkDescriptorSetLayout Layout;
+        uint32_t VariableCount;
+
+        std::vector<VulkanDescriptorRange> Ranges;
+        Buffer Data;
+
+        // descriptors the set takes from its pool, including unbound array elements
+        std::vector<VkDescriptorPoolSize> PoolSizes;
+
+        // the shape hash leaves out the descriptor info and the variable count
+        uint64_t Hash, ShapeHash;
+
+        // keeps the written objects alive for as long as the set may be in use
+        std::map<uint32_t, VulkanBinding> Bindings;
+
+        bool Matches(const VulkanSetContents& other) const;
+    };
+
     class VulkanRendererAllocation : public RendererAllocation {
     public:
-        using DescriptorSetArray = std::map<uint32_t, std::vector<VkDescriptorSet>>;
+        using SetContents = std::vector<std::shared_ptr<const VulkanSetContents>>;
         using Bindings = std::map<uint32_t, std::map<uint32_t, VulkanBinding>>;
 
         VulkanRendererAllocation(const Ref<VulkanShader>& shader);
         ~VulkanRendererAllocation();
 
         Ref<VulkanShader> GetShader() const { return m_Shader; }
-        uint64_t GetID() const { return m_ID; }
+        virtual uint64_t GetID() const override { return m_ID; }
         const Bindings& GetBindings() const { return m_Bindings; }
 
         virtual bool Bind(const std::string& name, Ref<DeviceBuffer> buffer, uint32_t index = 0,
@@ -47,12 +81,23 @@ namespace fuujin {
         virtual bool Bind(const std::string& name, Ref<Texture> texture,
                           uint32_t index = 0) override;
 
-        void RT_AllocateDescriptorSets(const Ref<VulkanDevice>& device, VkDescriptorPool pool,
-                                       DescriptorSetArray& sets);
+        // one entry per bound set, ordered by set index
+        // rebuilt when a descriptor changes, but not when only a dynamic offset does
+        std::shared_ptr<const SetContents> RT_GetSetContents();
+
+        virtual uint32_t GetDynamicOffsetCount() const override { return m_DynamicOffsetCount; }
+
+        // ordered by set, then in the order vulkan expects them
+        virtual void GetDynamicOffsets(uint32_t* offsets) override;
+
+        // appends the set's dynamic offsets from a copy made by the above
+        void GetDynamicOffsets(uint32_t set, const uint32_t* copy,
+                               std::vector<uint32_t>& offsets) const;
 
     private:
+        // compares everything but the binder
         bool IsDescriptorCurrent(uint32_t set, uint32_t binding, uint32_t index,
-                                 void* object) const;
+                                 const VulkanDescriptor& data) const;
 
         void SetDescriptor(uint32_t set, uint32_t binding, uint32_t index,
                            const VulkanDescriptor& data, VulkanBindingType type,
@@ -60,8 +105,7 @@ namespace fuujin {
 
         void RecalculateGroups();
 
-        void BindSet(VkDescriptorSet set, uint32_t index, std::vector<VkWriteDescriptorSet>& writes,
-                     Buffer& descriptorInfo) const;
+        std::shared_ptr<const VulkanSetContents> BuildSetContents(uint32_t index) const;
 
         Ref<VulkanShader> m_Shader;
 
@@ -69,25 +113,31 @@ namespace fuujin {
         Bindings m_Bindings;
 
         bool m_BindingsChanged;
-        std::map<uint32_t, uint32_t> m_SetGroups;
+        uint64_t m_Revision, m_ContentsRevision;
+        std::shared_ptr<const SetContents> m_Contents;
+
+        // by set, then by binding and array index
+        // only the offsets change after construction
+        std::map<uint32_t, std::map<std::pair<uint32_t, uint32_t>, uint32_t>> m_DynamicOffsets;
+        uint32_t m_DynamicOffsetCount;
 
         std::mutex m_Mutex;
     };
 
     class VulkanRenderer : public RendererAPI {
     public:
-        struct FrameAllocationData {
-            Ref<VulkanRendererAllocation> Allocation;
-
-            VulkanRendererAllocation::Bindings Bindings; // we keep references until frame reset
-            VulkanRendererAllocation::DescriptorSetArray Sets;
+        struct DescriptorPool {
+            VkDescriptorPool Pool;
+            uint32_t MaxSets;
+            size_t LiveSets;
         };
 
-        struct DescriptorPool {
-            VkDescriptorPool DescriptorPool;
-            bool MarkedForReset;
+        struct CachedDescriptorSet {
+            VkDescriptorSet Set;
+            size_t Pool;
+            uint64_t LastUsed; // frame index
 
-            std::unordered_map<uint64_t, FrameAllocationData> Allocations;
+            std::shared_ptr<const VulkanSetContents> Contents;
         };
 
         VulkanRenderer(Ref<VulkanDevice> device, uint32_t frames);
@@ -107,21 +157,66 @@ namespace fuujin {
 
         virtual void RT_EndRenderLabel(CommandList& cmdlist) const override;
 
+        virtual void RT_ClearLayers(CommandList& cmdlist, Ref<RenderTarget> target,
+                                    uint32_t layerMask, const glm::vec4& clearColor) const override;
+
         virtual Ref<RendererAllocation> CreateAllocation(const Ref<Shader>& shader) const override;
 
+        virtual DescriptorCounts GetDescriptorCounts() const override;
+
     private:
         void RT_CreatePools();
-        void RT_ResetCurrentPool();
+        void RT_QueryDeviceSupport();
+
+        // m_PoolMutex must be held for the following
+        // frees sets that no frame in flight can still be using
+        void RT_EvictDescriptorSets();
+
+        // sized after the descriptors allocated so far, and large enough to fit the passed set
+        size_t RT_CreatePool(const VulkanSetContents* contents);
+
+        // empty pools other than the current one are reset and reused
+        void RT_RecyclePool(size_t index);
+
+        // returns the index of the pool the set was allocated from
+        size_t RT_AllocateDescriptorSet(const VulkanSetContents& contents, VkDescriptorSet& set);
+
+        VkDescriptorSet RT_GetDescriptorSet(
+            const std::shared_ptr<const VulkanSetContents>& contents);
+        void RT_WriteDescriptorSet(VkDescriptorSet set, const VulkanSetContents& contents);
+        VkDescriptorUpdateTemplate RT_GetUpdateTemplate(const VulkanSetContents& contents);
+
+        // binds everything a draw needs, skipping what the renderer reported as already bound
+        void RT_BindRenderCall(VulkanCommandBuffer& cmdBuffer, const IndexedRenderCall& data);
 
         void RT_BindAllocation(VulkanCommandBuffer& cmdBuffer,
                                Ref<VulkanRendererAllocation> allocation,
-                               VkPipelineBindPoint bindPoint, std::set<uint32_t>& boundSets);
+                               const uint32_t* dynamicOffsets, VkPipelineBindPoint bindPoint,
+                               std::set<uint32_t>& boundSets);
 
         Ref<VulkanDevice> m_Device;
         TracyVkCtx m_TracyContext;
         uint32_t m_FrameCount;
 
         uint32_t m_CurrentFrame;
+        uint64_t m_FrameIndex;
+        bool m_UseUpdateTemplates;
+
+        // sets live across frames, and are only written when first allocated
+        // pools are chained as they run out, and are never destroyed before the renderer
         std::vector<DescriptorPool> m_DescriptorPools;
+        std::vector<size_t> m_FreePools;
+        size_t m_CurrentPool;
+
+        // descriptors taken by every set allocated so far, by type
+        std::unordered_map<VkDescriptorType, uint64_t> m_DescriptorDemand;
+        uint64_t m_SetDemand;
+
+        std::unordered_multimap<uint64_t, CachedDescriptorSet> m_DescriptorSets; // by hash
+        std::unordered_map<uint64_t, VkDescriptorUpdateTemplate> m_UpdateTemplates; // by shape
+        std::mutex m_PoolMutex;
+
+        std::atomic<uint64_t> m_SetAllocations, m_SetUpdates;
+        std::atomic<size_t> m_CachedSets, m_PoolCount;
     };
 } // namespace fuujin
@@ -182,7 +182,8 @@ namespace fuujin {
 
         switch (resourceType) {
         case GPUResource::UniformBuffer:
-            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            // uniform data is suballocated from per-frame pages
+            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         case GPUResource::StorageBuffer:
             return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         case GPUResource::SampledImage:
@@ -328,6 +329,18 @@ namespace fuujin {
 
         for (auto& [set, resources] : m_Resources) {
             for (auto& [binding, resource] : resources) {
+                // runtime-sized arrays are sized to the device's texture table
+                if (!resource.Dimensions.empty() && resource.Dimensions[0] == 0) {
+                    uint32_t maxTextures = Renderer::GetAPI().MaxBindlessTextures;
+                    if (maxTextures == 0) {
+                        throw std::runtime_error(
+                            "Runtime descriptor arrays are not supported on this device!");
+                    }
+
+                    resource.Dimensions[0] = maxTextures;
+                    m_VariableBindings[set] = binding;
+                }
+
                 resource.Interface =
                     std::shared_ptr<GPUResource>(new VulkanResource(this, set, binding));
 
@@ -652,6 +665,32 @@ namespace fuujin {
             setInfo.bindingCount = (uint32_t)bindings.size();
             setInfo.pBindings = bindings.data();
 
+            // entries of a texture table past what was bound are never read
+            std::vector<VkDescriptorBindingFlags> bindingFlags;
+            VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+
+            auto variableBinding = m_VariableBindings.find(setIndex);
+            if (variableBinding != m_VariableBindings.end()) {
+                for (const auto& binding : bindings) {
+                    VkDescriptorBindingFlags flags = 0;
+                    if (binding.binding == variableBinding->second) {
+                        flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+                    } else if (binding.binding > variableBinding->second) {
+                        throw std::runtime_error(
+                            "Runtime descriptor arrays must be the last binding of their set!");
+                    }
+
+                    bindingFlags.push_back(flags);
+                }
+
+                flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+                flagsInfo.bindingCount = (uint32_t)bindingFlags.size();
+                flagsInfo.pBindingFlags = bindingFlags.data();
+
+                setInfo.pNext = &flagsInfo;
+            }
+
             VkDescriptorSetLayout setLayout;
             if (vkCreateDescriptorSetLayout(m_Device->GetDevice(), &setInfo, callbacks,
                                             &setLayout) != VK_SUCCESS) {
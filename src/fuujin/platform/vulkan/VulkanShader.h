@@ -97,6 +97,13 @@ namespace fuujin {
             return m_VertexAttributes;
         }
 
+        // runtime-sized descriptor arrays, by set
+        // each is the last binding of its set and is allocated with only as many descriptors as
+        // are bound
+        const std::map<uint32_t, uint32_t>& GetVariableBindings() const {
+            return m_VariableBindings;
+        }
+
         const Resources& GetResources() const { return m_Resources; }
         const Types& GetTypes() const { return m_Types; }
         const ShaderPushConstants& GetPushConstantData() const { return m_PushConstants; }
@@ -130,6 +137,7 @@ namespace fuujin {
         std::map<uint32_t, VertexAttribute> m_VertexAttributes;
 
         Resources m_Resources;
+        std::map<uint32_t, uint32_t> m_VariableBindings;
         Types m_Types;
         ShaderPushConstants m_PushConstants;
         std::unordered_map<std::string, ResourceDescriptor> m_ResourceMap;
@@ -88,7 +88,10 @@ namespace fuujin {
 
     void VulkanSwapchain::RequestResize(const ViewSize& viewSize) {
         ZoneScoped;
-        m_NewViewSize = viewSize;
+
+        // the render thread may be mid-frame
+        Renderer::Submit([this, viewSize]() { m_NewViewSize = viewSize; },
+                         "Request swapchain resize");
 
         FUUJIN_INFO("Requested swapchain resize from {}x{} to {}x{}", m_Extent.width,
                     m_Extent.height, viewSize.Width, viewSize.Height);
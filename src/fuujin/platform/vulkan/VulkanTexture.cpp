@@ -187,6 +187,12 @@ namespace fuujin {
             spec.ArrayLayers = 6;
             spec.Flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
             break;
+        case Type::CubeArray:
+            spec.Type = VK_IMAGE_TYPE_2D;
+            spec.ViewType = VK_IMAGE_VIEW_TYPE_CUBE_ARRAY;
+            spec.ArrayLayers = 6 * m_Spec.Layers;
+            spec.Flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+            break;
         default:
             throw std::runtime_error("Invalid texture type!");
         }
@@ -0,0 +1,189 @@
+#include "fuujinpch.h"
+#include "fuujin/renderer/Bounds.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FUUJIN_CULL_SSE
+#endif
+
+namespace fuujin {
+    AABB AABB::Transform(const glm::mat4& matrix) const {
+        ZoneScoped;
+
+        if (IsEmpty()) {
+            return *this;
+        }
+
+        // arvo's method - each column contributes its min and max along each axis
+        AABB result;
+        result.Min = result.Max = glm::vec3(matrix[3]);
+
+        for (glm::length_t i = 0; i < 3; i++) {
+            glm::vec3 a = glm::vec3(matrix[i]) * Min[i];
+            glm::vec3 b = glm::vec3(matrix[i]) * Max[i];
+
+            result.Min += glm::min(a, b);
+            result.Max += glm::max(a, b);
+        }
+
+        return result;
+    }
+
+    bool AABB::Intersects(const Ray& ray, float maxDistance, float& distance) const {
+        float near = 0.f;
+        float far = maxDistance;
+
+        // slab test; division by zero gives infinities, which compare correctly
+        for (glm::length_t i = 0; i < 3; i++) {
+            float inverse = 1.f / ray.Direction[i];
+            float t0 = (Min[i] - ray.Origin[i]) * inverse;
+            float t1 = (Max[i] - ray.Origin[i]) * inverse;
+
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+
+            near = std::max(near, t0);
+            far = std::min(far, t1);
+
+            if (near > far) {
+                return false;
+            }
+        }
+
+        distance = near;
+        return true;
+    }
+
+    BoundingSphere BoundingSphere::Transform(const glm::mat4& matrix) const {
+        ZoneScoped;
+
+        float scale = 0.f;
+        for (glm::length_t i = 0; i < 3; i++) {
+            scale = std::max(scale, glm::length(glm::vec3(matrix[i])));
+        }
+
+        BoundingSphere result;
+        result.Center = glm::vec3(matrix * glm::vec4(Center, 1.f));
+        result.Radius = Radius * scale;
+
+        return result;
+    }
+
+    Frustum::Frustum(const glm::mat4& viewProjection, const GraphicsDevice::APISpec& api) {
+        ZoneScoped;
+
+        glm::mat4 transposed = glm::transpose(viewProjection);
+        const auto& x = transposed[0];
+        const auto& y = transposed[1];
+        const auto& z = transposed[2];
+        const auto& w = transposed[3];
+
+        glm::vec4 planes[s_PlaneCount] = { w + x, w - x, w + y, w - y, w - z, z };
+        if (api.Depth == GraphicsDevice::DepthRange::NegativeOneToOne) {
+            planes[5] += w;
+        }
+
+        for (size_t i = 0; i < 8; i++) {
+            glm::vec4 plane(0.f, 0.f, 0.f, 1.f);
+            if (i < s_PlaneCount) {
+                plane = planes[i] / glm::length(glm::vec3(planes[i]));
+            }
+
+            size_t group = (i / 4) * 4;
+            for (glm::length_t j = 0; j < 4; j++) {
+                m_Planes[group + j][i % 4] = plane[j];
+            }
+        }
+    }
+
+    bool Frustum::Intersects(const BoundingSphere& sphere) const {
+        uint32_t mask = 0;
+        TestSpheres(&sphere, 1, 1, &mask);
+
+        return mask != 0;
+    }
+
+    bool Frustum::Intersects(const AABB& box) const {
+        ZoneScoped;
+
+        glm::vec3 center = box.GetCenter();
+        glm::vec3 extents = box.GetExtents();
+
+        for (size_t i = 0; i < s_PlaneCount; i++) {
+            size_t group = (i / 4) * 4;
+            size_t lane = i % 4;
+
+            glm::vec3 normal(m_Planes[group][lane], m_Planes[group + 1][lane],
+                             m_Planes[group + 2][lane]);
+
+            // the projected radius of the box onto the plane normal
+            float radius = glm::dot(extents, glm::abs(normal));
+            float distance = glm::dot(normal, center) + m_Planes[group + 3][lane];
+
+            if (distance < -radius) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void Frustum::TestSpheres(const BoundingSphere* spheres, size_t count, uint32_t bit,
+                              uint32_t* masks) const {
+        ZoneScoped;
+
+#ifdef FUUJIN_CULL_SSE
+        __m128 planes[8];
+        for (size_t i = 0; i < 8; i++) {
+            planes[i] = _mm_load_ps(m_Planes[i]);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            __m128 sphere = _mm_loadu_ps(&spheres[i].Center.x);
+
+            __m128 cx = _mm_shuffle_ps(sphere, sphere, _MM_SHUFFLE(0, 0, 0, 0));
+            __m128 cy = _mm_shuffle_ps(sphere, sphere, _MM_SHUFFLE(1, 1, 1, 1));
+            __m128 cz = _mm_shuffle_ps(sphere, sphere, _MM_SHUFFLE(2, 2, 2, 2));
+            __m128 radius = _mm_shuffle_ps(sphere, sphere, _MM_SHUFFLE(3, 3, 3, 3));
+            __m128 threshold = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+            // signed distance from four planes at once
+            int outside = 0;
+            for (size_t group = 0; group < 8; group += 4) {
+                __m128 distance = _mm_mul_ps(planes[group], cx);
+                distance = _mm_add_ps(distance, _mm_mul_ps(planes[group + 1], cy));
+                distance = _mm_add_ps(distance, _mm_mul_ps(planes[group + 2], cz));
+                distance = _mm_add_ps(distance, planes[group + 3]);
+
+                outside |= _mm_movemask_ps(_mm_cmplt_ps(distance, threshold));
+            }
+
+            if (outside == 0) {
+                masks[i] |= bit;
+            }
+        }
+#else
+        for (size_t i = 0; i < count; i++) {
+            const auto& sphere = spheres[i];
+
+            bool inside = true;
+            for (size_t j = 0; j < s_PlaneCount && inside; j++) {
+                size_t group = (j / 4) * 4;
+                size_t lane = j % 4;
+
+                float distance = m_Planes[group][lane] * sphere.Center.x +
+                                 m_Planes[group + 1][lane] * sphere.Center.y +
+                                 m_Planes[group + 2][lane] * sphere.Center.z +
+                                 m_Planes[group + 3][lane];
+
+                inside = distance >= -sphere.Radius;
+            }
+
+            if (inside) {
+                masks[i] |= bit;
+            }
+        }
+#endif
+    }
+} // namespace fuujin
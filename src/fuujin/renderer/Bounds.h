@@ -0,0 +1,105 @@
+#pragma once
+
+#include "fuujin/renderer/GraphicsDevice.h"
+
+namespace fuujin {
+    struct Ray {
+        glm::vec3 Origin;
+        glm::vec3 Direction;
+    };
+
+    struct AABB {
+        glm::vec3 Min, Max;
+
+        // inverted so that the first expansion sets both corners
+        static AABB Empty() {
+            AABB box;
+            box.Min = glm::vec3(std::numeric_limits<float>::max());
+            box.Max = glm::vec3(std::numeric_limits<float>::lowest());
+
+            return box;
+        }
+
+        bool IsEmpty() const { return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z; }
+
+        glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+        glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+        float GetSurfaceArea() const {
+            glm::vec3 size = Max - Min;
+            return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        bool Contains(const AABB& box) const {
+            return glm::all(glm::lessThanEqual(Min, box.Min)) &&
+                   glm::all(glm::greaterThanEqual(Max, box.Max));
+        }
+
+        bool Intersects(const AABB& box) const {
+            return glm::all(glm::lessThanEqual(Min, box.Max)) &&
+                   glm::all(glm::greaterThanEqual(Max, box.Min));
+        }
+
+        // distance is set to where the ray enters the box, or 0 if it starts inside
+        bool Intersects(const Ray& ray, float maxDistance, float& distance) const;
+
+        void Expand(const glm::vec3& point) {
+            Min = glm::min(Min, point);
+            Max = glm::max(Max, point);
+        }
+
+        void Expand(const AABB& box) {
+            Min = glm::min(Min, box.Min);
+            Max = glm::max(Max, box.Max);
+        }
+
+        static AABB Union(const AABB& lhs, const AABB& rhs) {
+            AABB box;
+            box.Min = glm::min(lhs.Min, rhs.Min);
+            box.Max = glm::max(lhs.Max, rhs.Max);
+
+            return box;
+        }
+
+        // the box containing this one after being transformed
+        AABB Transform(const glm::mat4& matrix) const;
+    };
+
+    // laid out so that a sphere can be loaded into a single 4-wide register
+    struct BoundingSphere {
+        glm::vec3 Center;
+        float Radius;
+
+        BoundingSphere Transform(const glm::mat4& matrix) const;
+
+        bool Intersects(const AABB& box) const {
+            glm::vec3 offset = glm::clamp(Center, box.Min, box.Max) - Center;
+            return glm::dot(offset, offset) <= Radius * Radius;
+        }
+    };
+
+    static_assert(sizeof(BoundingSphere) == sizeof(glm::vec4));
+
+    class Frustum {
+    public:
+        Frustum() = default;
+
+        // planes are extracted from the view-projection matrix, in world space
+        Frustum(const glm::mat4& viewProjection, const GraphicsDevice::APISpec& api);
+
+        bool Intersects(const BoundingSphere& sphere) const;
+        bool Intersects(const AABB& box) const;
+
+        // sets bit in masks[i] for every sphere that intersects the frustum
+        // masks must hold at least count entries
+        void TestSpheres(const BoundingSphere* spheres, size_t count, uint32_t bit,
+                         uint32_t* masks) const;
+
+    private:
+        static constexpr size_t s_PlaneCount = 6;
+
+        // transposed, with two planes of padding that everything passes
+        // [0-3] hold the x, y, z and w components of planes 0-3, [4-7] those of planes 4-7
+        alignas(16) float m_Planes[8][4];
+    };
+} // namespace fuujin
@@ -0,0 +1,125 @@
+#include "fuujinpch.h"
+#include "fuujin/renderer/CommandArena.h"
+
+namespace fuujin {
+    CommandArena::CommandArena(size_t blockSize) {
+        ZoneScoped;
+
+        m_BlockSize = blockSize;
+        m_UsedSize = 0;
+        m_CurrentBlock = 0;
+        m_Offset = 0;
+
+        std::memset(m_InternCache, 0, sizeof(m_InternCache));
+        AllocateBlock(m_BlockSize);
+    }
+
+    CommandArena::~CommandArena() {
+        ZoneScoped;
+
+        m_Objects.clear();
+        FreeBlocks();
+    }
+
+    void* CommandArena::Allocate(size_t size, size_t alignment) {
+        ZoneScoped;
+
+        while (true) {
+            const auto& block = m_Blocks[m_CurrentBlock];
+
+            size_t base = (size_t)block.Data;
+            size_t aligned = (base + m_Offset + alignment - 1) & ~(alignment - 1);
+            size_t end = aligned - base + size;
+
+            if (end <= block.Size) {
+                m_UsedSize += end - m_Offset;
+                m_Offset = end;
+
+                return (void*)aligned;
+            }
+
+            m_Offset = 0;
+            m_CurrentBlock++;
+
+            if (m_CurrentBlock >= m_Blocks.size()) {
+                AllocateBlock(size + alignment);
+            }
+        }
+    }
+
+    const char* CommandArena::CopyString(const std::string& value) {
+        ZoneScoped;
+
+        auto data = Allocate<char>(value.length() + 1);
+        std::memcpy(data, value.c_str(), value.length() + 1);
+
+        return data;
+    }
+
+    uint32_t CommandArena::Intern(const Ref<RefCounted>& object) {
+        ZoneScoped;
+
+        auto instance = object.Raw();
+        if (instance == nullptr) {
+            return NullHandle;
+        }
+
+        // direct-mapped cache - most draws in a frame share pipelines, buffers and allocations
+        size_t slot = (std::hash<RefCounted*>()(instance) >> 4) % s_InternCacheSize;
+        auto& entry = m_InternCache[slot];
+
+        if (entry.Object == instance) {
+            return entry.Handle;
+        }
+
+        auto handle = (uint32_t)m_Objects.size();
+        m_Objects.push_back(object);
+
+        entry.Object = instance;
+        entry.Handle = handle;
+
+        return handle;
+    }
+
+    void CommandArena::Reset() {
+        ZoneScoped;
+
+        m_Objects.clear();
+        std::memset(m_InternCache, 0, sizeof(m_InternCache));
+
+        // coalesce into a single block so that the next frame fits without spilling
+        if (m_Blocks.size() > 1) {
+            size_t totalSize = 0;
+            for (const auto& block : m_Blocks) {
+                totalSize += block.Size;
+            }
+
+            FreeBlocks();
+            AllocateBlock(totalSize);
+        }
+
+        m_UsedSize = 0;
+        m_CurrentBlock = 0;
+        m_Offset = 0;
+    }
+
+    void CommandArena::AllocateBlock(size_t minimumSize) {
+        ZoneScoped;
+
+        Block block;
+        block.Size = std::max(minimumSize, m_BlockSize);
+        block.Data = allocate(block.Size);
+
+        m_Blocks.push_back(block);
+    }
+
+    void CommandArena::FreeBlocks() {
+        ZoneScoped;
+
+        for (const auto& block : m_Blocks) {
+            freemem(block.Data);
+        }
+
+        m_Blocks.clear();
+    }
+} // namespace fuujin
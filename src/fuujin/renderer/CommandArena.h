@@ -0,0 +1,74 @@
+#pragma once
+#include "fuujin/core/Ref.h"
+
+namespace fuujin {
+    /*
+     * Linear allocator for render commands recorded over the course of a frame. Memory is only
+     * reclaimed on Reset, and blocks are kept around so that a frame of similar size does not touch
+     * the heap. Ref-counted objects referenced by commands are interned into a handle table that
+     * holds them alive until the arena is reset.
+     */
+    class CommandArena {
+    public:
+        static constexpr uint32_t NullHandle = std::numeric_limits<uint32_t>::max();
+
+        CommandArena(size_t blockSize = 64 * 1024);
+        ~CommandArena();
+
+        CommandArena(const CommandArena&) = delete;
+        CommandArena& operator=(const CommandArena&) = delete;
+
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        // allocates uninitialized storage for POD records
+        template <typename _Ty>
+        _Ty* Allocate(size_t count = 1) {
+            static_assert(std::is_trivially_destructible_v<_Ty>,
+                          "Arena records are never destructed!");
+
+            return (_Ty*)Allocate(sizeof(_Ty) * count, alignof(_Ty));
+        }
+
+        const char* CopyString(const std::string& value);
+
+        uint32_t Intern(const Ref<RefCounted>& object);
+
+        template <typename _Ty>
+        _Ty* Get(uint32_t handle) const {
+            if (handle == NullHandle) {
+                return nullptr;
+            }
+
+            return (_Ty*)m_Objects[handle].Raw();
+        }
+
+        // releases all interned objects and rewinds the arena
+        void Reset();
+
+        size_t GetUsedSize() const { return m_UsedSize; }
+        size_t GetObjectCount() const { return m_Objects.size(); }
+
+    private:
+        static constexpr size_t s_InternCacheSize = 256;
+
+        struct Block {
+            void* Data;
+            size_t Size;
+        };
+
+        struct InternEntry {
+            RefCounted* Object;
+            uint32_t Handle;
+        };
+
+        void AllocateBlock(size_t minimumSize);
+        void FreeBlocks();
+
+        size_t m_BlockSize, m_UsedSize;
+        std::vector<Block> m_Blocks;
+        size_t m_CurrentBlock, m_Offset;
+
+        std::vector<Ref<RefCounted>> m_Objects;
+        InternEntry m_InternCache[s_InternCacheSize];
+    };
+} // namespace fuujin
@@ -46,10 +46,19 @@ namespace fuujin {
     public:
         virtual QueueType GetType() const = 0;
 
-        virtual CommandList& RT_Get() = 0;
+        // command lists from different pools may be recorded on different threads at once
+        // a pool must not be used by more than one thread at a time
+        virtual CommandList& RT_Get(uint32_t pool = 0) = 0;
+
+        // submissions are batched until the queue is flushed
         virtual void RT_Submit(CommandList& cmdList, Ref<Fence> fence = {}) = 0;
+        virtual void RT_Flush() = 0;
+
+        // the number of batches actually submitted to the device
+        virtual uint64_t GetSubmitCount() const = 0;
 
-        virtual void Wait() const = 0;
+        // flushes and waits for the queue to go idle
+        virtual void Wait() = 0;
         virtual void Clear() = 0;
     };
 } // namespace fuujin
\ No newline at end of file
@@ -25,6 +25,7 @@ namespace fuujin {
         };
 
         virtual const Spec& GetSpec() const = 0;
+        virtual uint64_t GetID() const = 0;
 
         virtual Buffer RT_Map() = 0;
         virtual void RT_Unmap() = 0;
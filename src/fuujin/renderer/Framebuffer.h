@@ -40,6 +40,12 @@ namespace fuujin {
             Texture::Format Format;
             AttachmentType Type;
             Ref<Sampler> TextureSampler;
+
+            // if set, layers [BaseLayer, BaseLayer + Spec::Layers) of the texture are rendered to
+            // instead of a texture created by the framebuffer
+            // the texture must be at least as large as the framebuffer
+            Ref<Texture> Source;
+            uint32_t BaseLayer = 0;
         };
 
         struct Spec {
@@ -50,14 +56,27 @@ namespace fuujin {
             std::set<Texture::Feature> AttachmentFeatures;
 
             uint32_t Layers = 1;
+
+            // attachments keep their contents between renders instead of being cleared
+            // layers that are drawn over should be cleared with Renderer::ClearLayers
+            bool PreserveContents = false;
         };
 
+        using RenderTarget::RT_EndRender;
+
+        // bit i of readAttachments is set if attachment i is read by anything after the render
+        virtual void RT_EndRender(CommandList& cmdList, uint32_t readAttachments) = 0;
+
         virtual const Spec& GetSpec() const = 0;
 
         virtual Ref<Texture> GetTexture(size_t index) const = 0;
 
         virtual Ref<Framebuffer> Recreate(uint32_t width, uint32_t height) const = 0;
 
+        // shares this framebuffer's render pass, and so the pipelines created for it
+        // the attachments may only differ in size, layer count, and source
+        virtual Ref<Framebuffer> Recreate(const Spec& spec) const = 0;
+
         virtual RenderTargetType GetType() const override { return RenderTargetType::Framebuffer; }
     };
 } // namespace fuujin
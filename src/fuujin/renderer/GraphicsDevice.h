@@ -19,6 +19,14 @@ namespace fuujin {
             bool TransposeMatrices;
             bool LeftHanded;
             DepthRange Depth;
+
+            // size of the texture tables shaders may index into with runtime-sized arrays
+            // 0 if the device cannot index descriptor arrays that way
+            uint32_t MaxBindlessTextures;
+
+            // if shaders may select the layer they render to from the vertex stage, letting
+            // multi-camera draws skip the geometry shader
+            bool LayeredVertexOutput;
         };
 
         struct Properties {
@@ -55,6 +55,7 @@ namespace fuujin {
 
         m_Position = position;
         m_ShadowZRange = glm::vec2(0.1f, 100.f);
+        m_ShadowResolution = 1024;
 
         if (attenuation.has_value()) {
             m_Attenuation = attenuation.value();
@@ -78,6 +79,12 @@ namespace fuujin {
         m_ShadowZRange = zRange;
     }
 
+    void PointLight::SetShadowResolution(uint32_t resolution) {
+        ZoneScoped;
+
+        m_ShadowResolution = resolution;
+    }
+
     void PointLight::SetAttenuation(const Attenuation& attenuation) {
         ZoneScoped;
 
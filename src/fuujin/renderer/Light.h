@@ -45,6 +45,9 @@ namespace fuujin {
         const glm::vec3& GetPosition() const { return m_Position; }
         const glm::vec2& GetShadowZRange() const { return m_ShadowZRange; }
 
+        // the size of each face of the light's shadow map; clamped to the shadow atlas's
+        uint32_t GetShadowResolution() const { return m_ShadowResolution; }
+
         virtual const Attenuation& GetAttenuation() const override { return m_Attenuation; }
 
         virtual const std::unordered_map<Color, glm::vec3>& GetColors() const override {
@@ -53,6 +56,7 @@ namespace fuujin {
 
         void SetPosition(const glm::vec3& position);
         void SetShadowZRange(const glm::vec2& zRange);
+        void SetShadowResolution(uint32_t resolution);
 
         virtual void SetAttenuation(const Attenuation& attenuation) override;
         virtual void SetColor(Color name, const glm::vec3& color) override;
@@ -63,6 +67,7 @@ namespace fuujin {
     private:
         glm::vec3 m_Position;
         glm::vec2 m_ShadowZRange;
+        uint32_t m_ShadowResolution;
 
         Attenuation m_Attenuation;
         std::unordered_map<Color, glm::vec3> m_Colors;
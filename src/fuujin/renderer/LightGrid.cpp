@@ -0,0 +1,190 @@
+#include "fuujinpch.h"
+#include "fuujin/renderer/LightGrid.h"
+
+#include "fuujin/core/JobSystem.h"
+
+#include <algorithm>
+
+namespace fuujin {
+    // widens the clusters of each light so that rounding on the device never misses one
+    static constexpr float s_ClusterBias = 1e-3f;
+
+    // corners closer than this to the camera plane cannot be projected
+    static constexpr float s_MinProjectedDepth = 1e-4f;
+
+    static uint32_t GetTile(float ndc, uint32_t tiles, float bias) {
+        float tile = std::floor((ndc * 0.5f + 0.5f) * (float)tiles + bias);
+        return (uint32_t)std::clamp((int32_t)tile, 0, (int32_t)tiles - 1);
+    }
+
+    static uint32_t GetSlice(float depth, const glm::vec2& zRange, float bias) {
+        float t = std::log(std::max(depth, zRange.x) / zRange.x) / std::log(zRange.y / zRange.x);
+        float slice = std::floor(t * (float)LightGrid::Slices + bias);
+
+        return (uint32_t)std::clamp((int32_t)slice, 0, (int32_t)LightGrid::Slices - 1);
+    }
+
+    bool LightGrid::IsRangeSupported(const glm::vec2& zRange) {
+        ZoneScoped;
+
+        return zRange.x >= s_MinProjectedDepth && zRange.y >= zRange.x * 2.f;
+    }
+
+    void LightGrid::Build(const glm::mat4& viewProjection, const glm::vec2& zRange,
+                          const std::vector<LightVolume>& lights) {
+        ZoneScoped;
+
+        // the shaders slice the camera's own range, so the grid cannot slice a corrected one
+        if (!IsRangeSupported(zRange)) {
+            throw std::runtime_error("Camera depth range cannot be sliced into clusters!");
+        }
+
+        m_Ranges.clear();
+
+        // w of the clip position is the distance along the view direction
+        glm::vec3 depthRow(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3]);
+        float depthScale = glm::length(depthRow);
+
+        for (size_t i = 0; i < lights.size(); i++) {
+            const auto& light = lights[i];
+
+            auto& lightRange = m_Ranges.emplace_back();
+            lightRange.Index = (uint32_t)i;
+            lightRange.MinX = lightRange.MinY = lightRange.MinSlice = 0;
+            lightRange.MaxX = TilesX - 1;
+            lightRange.MaxY = TilesY - 1;
+            lightRange.MaxSlice = Slices - 1;
+
+            if (!light.Radius.has_value()) {
+                continue;
+            }
+
+            float radius = light.Radius.value();
+            float centerDepth = (viewProjection * glm::vec4(light.Center, 1.f)).w;
+            float minDepth = centerDepth - radius * depthScale;
+            float maxDepth = centerDepth + radius * depthScale;
+
+            // fragments outside of the depth range shade every light anyway
+            if (maxDepth < zRange.x || minDepth > zRange.y) {
+                m_Ranges.pop_back();
+                continue;
+            }
+
+            lightRange.MinSlice = GetSlice(minDepth, zRange, -s_ClusterBias);
+            lightRange.MaxSlice = GetSlice(maxDepth, zRange, s_ClusterBias);
+
+            // the projected corners of the light's bounding box enclose its projected sphere, as
+            // long as none of them are behind the camera
+            glm::vec2 minNDC(std::numeric_limits<float>::max());
+            glm::vec2 maxNDC(std::numeric_limits<float>::lowest());
+            bool behind = false;
+
+            for (uint32_t corner = 0; corner < 8; corner++) {
+                glm::vec3 offset((corner & 1) != 0 ? radius : -radius,
+                                 (corner & 2) != 0 ? radius : -radius,
+                                 (corner & 4) != 0 ? radius : -radius);
+
+                auto clip = viewProjection * glm::vec4(light.Center + offset, 1.f);
+                if (clip.w < s_MinProjectedDepth) {
+                    behind = true;
+                    break;
+                }
+
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                minNDC = glm::min(minNDC, ndc);
+                maxNDC = glm::max(maxNDC, ndc);
+            }
+
+            if (behind) {
+                continue;
+            }
+
+            if (glm::any(glm::greaterThan(minNDC, glm::vec2(1.f))) ||
+                glm::any(glm::lessThan(maxNDC, glm::vec2(-1.f)))) {
+                m_Ranges.pop_back();
+                continue;
+            }
+
+            lightRange.MinX = GetTile(minNDC.x, TilesX, -s_ClusterBias);
+            lightRange.MaxX = GetTile(maxNDC.x, TilesX, s_ClusterBias);
+            lightRange.MinY = GetTile(minNDC.y, TilesY, -s_ClusterBias);
+            lightRange.MaxY = GetTile(maxNDC.y, TilesY, s_ClusterBias);
+        }
+
+        m_Slices.resize(Slices);
+        auto counter = JobSystem::ParallelFor(
+            Slices,
+            [this](size_t begin, size_t end) {
+                for (size_t slice = begin; slice < end; slice++) {
+                    FillSlice((uint32_t)slice);
+                }
+            },
+            1);
+
+        JobSystem::Wait(counter);
+
+        m_IndexCount = 0;
+        for (const auto& slice : m_Slices) {
+            m_IndexCount += slice.Indices.size();
+        }
+
+        size_t offset = (size_t)ClusterCount * 2;
+        m_Data.resize(offset + m_IndexCount);
+
+        for (uint32_t i = 0; i < Slices; i++) {
+            const auto& slice = m_Slices[i];
+
+            for (uint32_t tile = 0; tile < TilesX * TilesY; tile++) {
+                const auto& cluster = slice.Clusters[tile];
+
+                size_t index = (size_t)i * TilesX * TilesY + tile;
+                m_Data[index * 2] = (uint32_t)(offset + cluster.x);
+                m_Data[index * 2 + 1] = cluster.y;
+            }
+
+            std::copy(slice.Indices.begin(), slice.Indices.end(), m_Data.begin() + offset);
+            offset += slice.Indices.size();
+        }
+    }
+
+    void LightGrid::Clear() {
+        ZoneScoped;
+
+        m_Ranges.clear();
+        m_Data.clear();
+        m_IndexCount = 0;
+    }
+
+    void LightGrid::FillSlice(uint32_t slice) {
+        ZoneScoped;
+
+        auto& data = m_Slices[slice];
+        data.Lights.clear();
+        data.Indices.clear();
+        data.Clusters.resize(TilesX * TilesY);
+
+        for (uint32_t i = 0; i < (uint32_t)m_Ranges.size(); i++) {
+            const auto& range = m_Ranges[i];
+            if (slice >= range.MinSlice && slice <= range.MaxSlice) {
+                data.Lights.push_back(i);
+            }
+        }
+
+        for (uint32_t y = 0; y < TilesY; y++) {
+            for (uint32_t x = 0; x < TilesX; x++) {
+                auto& cluster = data.Clusters[y * TilesX + x];
+                cluster.x = (uint32_t)data.Indices.size();
+
+                for (uint32_t light : data.Lights) {
+                    const auto& range = m_Ranges[light];
+                    if (x >= range.MinX && x <= range.MaxX && y >= range.MinY &&
+                        y <= range.MaxY) {
+                        data.Indices.push_back(range.Index);
+                    }
+                }
+
+                cluster.y = (uint32_t)data.Indices.size() - cluster.x;
+            }
+        }
+    }
+} // namespace fuujin
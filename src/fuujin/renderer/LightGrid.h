@@ -0,0 +1,62 @@
+#pragma once
+
+namespace fuujin {
+    /*
+     * Splits the view of a camera into clusters - screen tiles sliced exponentially in depth - and
+     * lists the lights whose influence reaches each one, so that a fragment only shades the lights
+     * of its cluster. Slices are filled in parallel on the job system. The layout of the data, and
+     * the way fragments find their cluster, must match assets/shaders/include/Scene.glsl.
+     */
+    class LightGrid {
+    public:
+        static constexpr uint32_t TilesX = 16;
+        static constexpr uint32_t TilesY = 9;
+        static constexpr uint32_t Slices = 24;
+        static constexpr uint32_t ClusterCount = TilesX * TilesY * Slices;
+
+        // lights without a radius reach every cluster
+        struct LightVolume {
+            glm::vec3 Center;
+            std::optional<float> Radius;
+        };
+
+        LightGrid() = default;
+        ~LightGrid() = default;
+
+        // cameras with a near plane too close to project from, or a range too short to slice
+        // exponentially, cannot be clustered
+        static bool IsRangeSupported(const glm::vec2& zRange);
+
+        void Build(const glm::mat4& viewProjection, const glm::vec2& zRange,
+                   const std::vector<LightVolume>& lights);
+
+        void Clear();
+
+        // an offset and count per cluster, indexing the light indices that follow
+        // empty if the grid has not been built
+        const std::vector<uint32_t>& GetData() const { return m_Data; }
+
+        // light indices written across every cluster
+        size_t GetIndexCount() const { return m_IndexCount; }
+
+    private:
+        // inclusive
+        struct LightRange {
+            uint32_t MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice;
+            uint32_t Index;
+        };
+
+        struct SliceData {
+            std::vector<uint32_t> Lights; // into m_Ranges
+            std::vector<uint32_t> Indices;
+            std::vector<glm::uvec2> Clusters; // offset into Indices and count, per tile
+        };
+
+        void FillSlice(uint32_t slice);
+
+        std::vector<LightRange> m_Ranges;
+        std::vector<SliceData> m_Slices;
+        std::vector<uint32_t> m_Data;
+        size_t m_IndexCount = 0;
+    };
+} // namespace fuujin
@@ -135,6 +135,7 @@ namespace fuujin {
         SetProperty(Property::Shininess, 256.f);
 
         m_Pipeline.Wireframe = false;
+        m_Pipeline.Blended = true;
     }
 
     Material::~Material() {
@@ -247,6 +248,11 @@ namespace fuujin {
             if (wireframeNode.IsDefined()) {
                 spec.Wireframe = wireframeNode.as<bool>();
             }
+
+            auto blendedNode = pipelineNode["Blended"];
+            if (blendedNode.IsDefined()) {
+                spec.Blended = blendedNode.as<bool>();
+            }
         }
 
         return material;
@@ -323,6 +329,7 @@ namespace fuujin {
         YAML::Node pipelineNode;
         auto& spec = material->GetPipeline();
         pipelineNode["Wireframe"] = spec.Wireframe;
+        pipelineNode["Blended"] = spec.Blended;
 
         YAML::Node node;
         node["Textures"] = texturesNode;
@@ -24,6 +24,9 @@ namespace fuujin {
 
         struct PipelineProperties {
             bool Wireframe;
+
+            // blended draws are sorted back to front after everything opaque
+            bool Blended;
             // todo: others
         };
 
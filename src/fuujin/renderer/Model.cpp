@@ -16,9 +16,32 @@ namespace fuujin {
 
     static const std::vector<std::string> s_ModelExtensions = { "model" };
 
+    Mesh::Bounds Mesh::CalculateBounds(const std::vector<Vertex>& vertices) {
+        ZoneScoped;
+
+        Bounds bounds;
+        bounds.Box = AABB::Empty();
+        for (const auto& vertex : vertices) {
+            bounds.Box.Expand(vertex.Position);
+        }
+
+        // centered on the box, but only as large as the farthest vertex
+        float radius2 = 0.f;
+        glm::vec3 center = bounds.Box.GetCenter();
+        for (const auto& vertex : vertices) {
+            glm::vec3 offset = vertex.Position - center;
+            radius2 = std::max(radius2, glm::dot(offset, offset));
+        }
+
+        bounds.Sphere.Center = center;
+        bounds.Sphere.Radius = glm::sqrt(radius2);
+
+        return bounds;
+    }
+
     Mesh::Mesh(const Ref<Material>& material, const std::vector<Vertex>& vertices,
                const std::vector<uint32_t>& indices, const std::vector<BoneReference>& bones,
-               size_t armature) {
+               size_t armature, const Bounds& bounds) {
         ZoneScoped;
 
         if (material.IsEmpty()) {
@@ -44,6 +67,7 @@ namespace fuujin {
         m_Indices = indices;
         m_Bones = bones;
         m_ArmatureIndex = armature;
+        m_Bounds = bounds;
     }
 
     Mesh::~Mesh() {
@@ -110,6 +134,7 @@ namespace fuujin {
         ZoneScoped;
 
         m_Meshes.push_back(std::move(mesh));
+        m_Bounds.reset();
     }
 
     void Model::AddArmature(std::unique_ptr<Armature>&& armature) {
@@ -143,11 +168,46 @@ namespace fuujin {
         m_NodeMap[name] = index;
         if (!meshes.empty()) {
             m_MeshNodes.insert(index);
+            m_Bounds.reset();
         }
 
         return index;
     }
 
+    const AABB& Model::GetBounds() const {
+        ZoneScoped;
+
+        if (m_Bounds.has_value()) {
+            return m_Bounds.value();
+        }
+
+        auto& bounds = m_Bounds.emplace(AABB::Empty());
+        for (size_t index : m_MeshNodes) {
+            const auto& node = m_Nodes[index];
+
+            // same order as Renderer::RenderModel
+            glm::mat4 nodeTransform(1.f);
+            std::optional<size_t> currentNode = index;
+            while (currentNode.has_value()) {
+                const auto& currentNodeData = m_Nodes[currentNode.value()];
+
+                nodeTransform *= currentNodeData.Transform;
+                currentNode = currentNodeData.Parent;
+            }
+
+            for (size_t meshIndex : node.Meshes) {
+                if (meshIndex >= m_Meshes.size()) {
+                    continue;
+                }
+
+                const auto& meshBounds = m_Meshes[meshIndex]->GetBounds();
+                bounds.Expand(meshBounds.Box.Transform(nodeTransform));
+            }
+        }
+
+        return bounds;
+    }
+
     std::optional<size_t> Model::FindNode(const std::string& name) {
         ZoneScoped;
 
@@ -239,7 +299,20 @@ namespace fuujin {
             FUUJIN_DEBUG("Either armature or bone references weren't specified - skipping rigging");
         }
 
-        return std::make_unique<Mesh>(material, vertices, indices, bones, armature);
+        Mesh::Bounds bounds;
+        const auto& boundsNode = node["Bounds"];
+
+        if (boundsNode.IsDefined()) {
+            bounds.Box.Min = boundsNode["Min"].as<glm::vec3>();
+            bounds.Box.Max = boundsNode["Max"].as<glm::vec3>();
+            bounds.Sphere.Center = boundsNode["Center"].as<glm::vec3>();
+            bounds.Sphere.Radius = boundsNode["Radius"].as<float>();
+        } else {
+            FUUJIN_DEBUG("Mesh bounds not serialized - calculating from vertices");
+            bounds = Mesh::CalculateBounds(vertices);
+        }
+
+        return std::make_unique<Mesh>(material, vertices, indices, bones, armature, bounds);
     }
 
     static std::unique_ptr<Armature> DeserializeArmature(const YAML::Node& node) {
@@ -400,6 +473,14 @@ namespace fuujin {
         node["Faces"] = indices.size() / Mesh::IndicesPerFace;
         node["Offset"] = offset;
 
+        const auto& bounds = mesh->GetBounds();
+        YAML::Node boundsNode;
+        boundsNode["Min"] = bounds.Box.Min;
+        boundsNode["Max"] = bounds.Box.Max;
+        boundsNode["Center"] = bounds.Sphere.Center;
+        boundsNode["Radius"] = bounds.Sphere.Radius;
+        node["Bounds"] = boundsNode;
+
         const auto& bones = mesh->GetBones();
         if (!bones.empty()) {
             YAML::Node bonesNode;
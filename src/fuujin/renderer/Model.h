@@ -4,6 +4,7 @@
 #include "fuujin/asset/ModelSource.h"
 
 #include "fuujin/renderer/Material.h"
+#include "fuujin/renderer/Bounds.h"
 
 namespace fuujin {
     struct Vertex {
@@ -27,9 +28,16 @@ namespace fuujin {
     public:
         static constexpr uint32_t IndicesPerFace = 3;
 
+        struct Bounds {
+            AABB Box;
+            BoundingSphere Sphere;
+        };
+
+        static Bounds CalculateBounds(const std::vector<Vertex>& vertices);
+
         Mesh(const Ref<Material>& material, const std::vector<Vertex>& vertices,
              const std::vector<uint32_t>& indices, const std::vector<BoneReference>& bones,
-             size_t armature);
+             size_t armature, const Bounds& bounds);
 
         ~Mesh();
 
@@ -45,6 +53,9 @@ namespace fuujin {
         const std::vector<BoneReference>& GetBones() const { return m_Bones; }
         size_t GetArmatureIndex() const { return m_ArmatureIndex; }
 
+        // in the space of the mesh, before node transforms and skinning
+        const Bounds& GetBounds() const { return m_Bounds; }
+
     private:
         uint64_t m_ID;
 
@@ -54,6 +65,8 @@ namespace fuujin {
 
         std::vector<BoneReference> m_Bones;
         size_t m_ArmatureIndex;
+
+        Bounds m_Bounds;
     };
 
     class Armature {
@@ -117,6 +130,9 @@ namespace fuujin {
         const std::vector<Node>& GetNodes() const { return m_Nodes; }
         const std::unordered_set<size_t>& GetMeshNodes() const { return m_MeshNodes; }
 
+        // bounds of every mesh in its bind pose, in model space
+        const AABB& GetBounds() const;
+
     private:
         fs::path m_Path;
 
@@ -126,6 +142,8 @@ namespace fuujin {
         std::vector<Node> m_Nodes;
         std::unordered_map<std::string, size_t> m_NodeMap;
         std::unordered_set<size_t> m_MeshNodes;
+
+        mutable std::optional<AABB> m_Bounds;
     };
 
     template <>
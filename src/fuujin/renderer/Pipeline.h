@@ -1,5 +1,6 @@
 #pragma once
 #include "fuujin/core/Ref.h"
+#include "fuujin/core/JobSystem.h"
 
 #include "fuujin/renderer/Shader.h"
 #include "fuujin/renderer/Framebuffer.h"
@@ -42,8 +43,19 @@ namespace fuujin {
 
             Ref<Shader> PipelineShader;
             Ref<RenderTarget> Target;
+
+            // compiled on the job system's background thread rather than on the render thread
+            // the renderer skips draws with the pipeline until it is ready
+            bool Async = false;
         };
 
         virtual const Spec& GetSpec() const = 0;
+        virtual uint64_t GetID() const = 0;
+
+        // false while an asynchronous pipeline is still compiling
+        virtual bool IsReady() const = 0;
+
+        // the job compiling an asynchronous pipeline, once the render thread has started it
+        virtual Ref<JobCounter> GetCompileJob() const = 0;
     };
 } // namespace fuujin
\ No newline at end of file
@@ -5,13 +5,19 @@
 #include "fuujin/renderer/ShaderBuffer.h"
 #include "fuujin/renderer/Model.h"
 #include "fuujin/renderer/Framebuffer.h"
+#include "fuujin/renderer/CommandArena.h"
+#include "fuujin/renderer/LightGrid.h"
 
 #include "fuujin/core/Events.h"
+#include "fuujin/core/RingQueue.h"
+#include "fuujin/core/JobSystem.h"
 
 #include <thread>
-#include <queue>
 #include <mutex>
+#include <condition_variable>
 #include <stack>
+#include <algorithm>
+#include <bit>
 
 #include <spdlog/stopwatch.h>
 #include <spdlog/fmt/chrono.h>
@@ -39,41 +45,239 @@ namespace fuujin {
           "fuujin/shaders/PointLightSkinned.glsl" },
     };
 
+    // used in place of the above while bindless textures are enabled
+    static const std::unordered_map<uint32_t, std::string> s_BindlessShaders = {
+        { GetShaderHash(ShaderName::Material, false),
+          "fuujin/shaders/MaterialStaticBindless.glsl" },
+        { GetShaderHash(ShaderName::Material, true),
+          "fuujin/shaders/MaterialSkinnedBindless.glsl" },
+    };
+
+    // used in place of the above while layered cameras are enabled
+    // see assets/shaders/include/VertexOutput.glsl
+    static const std::unordered_map<uint32_t, std::string> s_LayeredShaders = {
+        { GetShaderHash(ShaderName::Material, false), "fuujin/shaders/MaterialStaticLayered.glsl" },
+        { GetShaderHash(ShaderName::Material, true), "fuujin/shaders/MaterialSkinnedLayered.glsl" },
+
+        { GetShaderHash(ShaderName::PointLightDepth, false),
+          "fuujin/shaders/PointLightStaticLayered.glsl" },
+        { GetShaderHash(ShaderName::PointLightDepth, true),
+          "fuujin/shaders/PointLightSkinnedLayered.glsl" },
+    };
+
+    static const std::unordered_map<uint32_t, std::string> s_LayeredBindlessShaders = {
+        { GetShaderHash(ShaderName::Material, false),
+          "fuujin/shaders/MaterialStaticBindlessLayered.glsl" },
+        { GetShaderHash(ShaderName::Material, true),
+          "fuujin/shaders/MaterialSkinnedBindlessLayered.glsl" },
+    };
+
+    // see assets/shaders/include/Material.glsl
+    static const std::string s_BindlessTableName = "u_Textures";
+
+    using RenderClock = std::chrono::steady_clock;
+
+    // must be a power of two
+    static constexpr size_t s_RenderQueueCapacity = 8192;
+
     struct QueueCallback {
         std::function<void()> Callback;
         std::string Label;
+        RenderClock::time_point Submitted;
+    };
+
+    enum class RenderCommandType : uint32_t {
+        Draw = 0,
+        PushLabel,
+        PopLabel,
+        Clear,
+    };
+
+    // commands are recorded into the frame's CommandArena and must stay POD
+    struct RenderCommand {
+        RenderCommandType Type;
+        RenderCommand* Next;
+    };
+
+    struct DrawCommand : RenderCommand {
+        bool HasFlip, Flip, HasScissor;
+        Scissor ScissorRect;
+
+        // only draws with a depth are sorted
+        bool Sortable;
+        uint64_t SortKey;
+
+        uint32_t Pipeline, IndexBuffer;
+        int32_t VertexOffset;
+        uint32_t IndexOffset, IndexCount;
+        uint32_t FirstInstance, InstanceCount;
+
+        uint32_t VertexBufferCount, ResourceCount;
+        const uint32_t* VertexBuffers;
+        const uint32_t* Resources;
+
+        uint32_t DynamicOffsetCount;
+        const uint32_t* DynamicOffsets;
+
+        size_t PushConstantSize;
+        const void* PushConstants;
+    };
+
+    struct LabelCommand : RenderCommand {
+        const char* Label;
+    };
+
+    struct ClearCommand : RenderCommand {
+        uint32_t LayerMask;
+    };
+
+    // copied into the frame's instance buffer before the target's commands are executed
+    struct InstanceUpload {
+        uint32_t Buffer;
+        uint32_t FirstInstance, InstanceCount;
+        const glm::mat4* Transforms;
+
+        InstanceUpload* Next;
     };
 
     struct ActiveRenderTarget {
         Ref<RenderTarget> Target;
+        Renderer::TargetUsage Usage;
         CommandList* CmdList;
         bool ResetViewport;
         std::stack<std::string> RenderLabels;
+
+        // recorded on the calling thread, executed when the target is popped
+        CommandArena* Arena;
+        RenderCommand* FirstCommand;
+        RenderCommand* LastCommand;
+
+        InstanceUpload* FirstUpload;
+        InstanceUpload* LastUpload;
+    };
+
+    // a framebuffer target being recorded on a job worker
+    struct PendingRecording {
+        std::shared_ptr<ActiveRenderTarget> Target;
+        Ref<JobCounter> Counter;
+    };
+
+    struct BindCounts {
+        uint64_t Pipelines, Buffers, Resources;
     };
 
     struct ObjectAllocation {
         Ref<RendererAllocation> Allocation;
-        Ref<DeviceBuffer> Buffer;
         uint64_t State;
         bool IsNew;
+
+        // the FrameUniforms epoch the uniform block was last written in
+        uint64_t UniformEpoch;
+    };
+
+    // a uniform buffer that stays mapped for as long as it lives
+    struct UniformPage {
+        Ref<DeviceBuffer> UniformBuffer;
+        Buffer Mapped; // render thread only
+        size_t Size;
+    };
+
+    // uniform data of a single frame, suballocated linearly and bound with dynamic offsets
+    struct FrameUniforms {
+        std::shared_ptr<UniformPage> Page;
+        size_t Used, Demand;
+
+        // incremented whenever the page is reset, invalidating everything written to it
+        uint64_t Epoch;
+
+        // pages outgrown during the frame, released once the frame comes around again
+        std::vector<std::shared_ptr<UniformPage>> Retired;
+    };
+
+    // staged in the frame's CommandArena, copied into its page by the render thread
+    struct UniformUpload {
+        UniformPage* Page;
+        size_t Offset, Size;
+        void* Data;
+
+        UniformUpload* Next;
     };
 
+    // staged in the frame's CommandArena like uniform uploads, for buffers mapped only to copy
+    struct StorageUpload {
+        DeviceBuffer* Buffer; // interned into the same arena
+        size_t Size;
+        void* Data;
+
+        StorageUpload* Next;
+    };
+
+    // one allocation per frame, so that a frame in flight is never written to
+    using FrameAllocations = std::vector<ObjectAllocation>;
+
     struct RendererShaderData {
-        std::unordered_map<uint64_t, ObjectAllocation> Materials, Scenes, Animators;
+        std::unordered_map<uint64_t, FrameAllocations> Materials, Scenes, Animators;
         std::unordered_map<size_t, Ref<Pipeline>> MaterialPipelines;
     };
 
+    // transforms of static mesh instances for a single frame
+    struct FrameInstances {
+        Ref<DeviceBuffer> Buffer;
+        uint32_t Count, Capacity;
+
+        // by shader ID
+        // replaced when the buffer grows; draws recorded before then keep the old ones alive
+        std::unordered_map<uint64_t, Ref<RendererAllocation>> Allocations;
+    };
+
+    struct BindlessTexture {
+        Ref<Texture> TableTexture;
+        uint32_t Users;
+    };
+
+    // table indices of a material's textures, held until its textures change
+    struct BindlessMaterial {
+        uint64_t State;
+        glm::ivec4 Indices;
+    };
+
+    static_assert((uint32_t)Material::TextureSlot::MAX == 4);
+
+    // lights and their clusters, bound as storage buffers; see assets/shaders/include/Scene.glsl
+    struct SceneStorage {
+        Ref<DeviceBuffer> Buffer;
+        size_t Capacity;
+
+        // the scene state and FrameUniforms epoch the buffer was written in
+        uint64_t State, Epoch;
+
+        size_t LightSize, ClusterOffset, ClusterSize;
+    };
+
     struct RendererSceneState {
         uint64_t State;
         Renderer::SceneData Data;
+
+        LightGrid Clusters;
+        std::vector<SceneStorage> Storage; // per frame
     };
 
     struct RendererData {
         struct {
             std::thread Thread;
             std::thread::id ID;
-            std::mutex Mutex;
-            std::queue<QueueCallback> Queue;
+            std::atomic<bool> Running;
+
+            std::unique_ptr<RingQueue<QueueCallback>> Queue;
+            std::atomic<uint64_t> Submitted, Completed;
+
+            // only touched by Renderer::Wait
+            std::atomic<uint32_t> Waiters;
+            std::mutex WaitMutex;
+            std::condition_variable WaitCondition;
+
+            // nanoseconds
+            std::atomic<uint64_t> Wakeups, TotalWakeLatency, MaxWakeLatency, BusyTime;
         } RenderThread;
 
         GraphicsDevice::Properties DeviceProperties;
@@ -84,57 +288,174 @@ namespace fuujin {
 
         Ref<Sampler> DefaultSampler;
         Ref<Texture> WhiteTexture;
-        Ref<Texture> WhiteCubemap;
+        Ref<Texture> WhiteCubeArray;
 
         std::unordered_map<uint64_t, RendererSceneState> SceneState;
         std::unordered_map<uint64_t, RendererShaderData> ShaderData;
         std::unordered_map<uint64_t, Renderer::MeshBuffers> MeshBuffers;
+        std::vector<FrameInstances> Instances;
+        std::vector<FrameUniforms> Uniforms;
+
+        // flushed to the render thread before the next target is executed
+        UniformUpload* FirstUniformUpload;
+        UniformUpload* LastUniformUpload;
+        StorageUpload* FirstStorageUpload;
+        StorageUpload* LastStorageUpload;
 
-        uint32_t FrameCount;
+        uint32_t FrameCount, FrameLead;
         std::optional<uint32_t> CurrentFrame;
 
+        // render queue positions at the start of each frame not yet waited on
+        std::queue<uint64_t> FrameJobs;
+
+        // one per frame
+        // each arena may only be reset once the job that executes its commands has finished
+        std::vector<std::unique_ptr<CommandArena>> CommandArenas;
+        std::vector<uint64_t> ArenaJobs;
+
+        // render thread only
+        // submitted in order once they finish recording, before anything else is submitted
+        std::vector<PendingRecording> PendingRecordings;
+
+        Renderer::FrameStatistics Statistics, LastStatistics;
+        uint64_t SubmitCount;
+
+        // tallied by whichever thread executes a target's commands
+        std::atomic<uint64_t> PipelineBinds, BufferBinds, ResourceBinds;
+        BindCounts LastBindCounts;
+
+        RendererAPI::DescriptorCounts LastDescriptorCounts;
+
+        // texture table shared by every material drawn with a bindless shader
+        // index 0 always holds the white texture, and freed indices are rebound to it
+        struct {
+            bool Enabled;
+
+            std::vector<BindlessTexture> Textures;
+            std::unordered_map<uint64_t, uint32_t> Indices; // by texture ID
+            std::vector<uint32_t> FreeIndices;
+
+            std::unordered_map<uint64_t, BindlessMaterial> Materials;
+            std::unordered_map<uint64_t, Ref<RendererAllocation>> Allocations; // by shader ID
+        } Bindless;
+
+        // material pipelines compiling in the background, checked at the start of each frame
+        bool AsyncPipelines;
+        bool LayeredCameras;
+        std::vector<Ref<Pipeline>> PendingPipelines;
+
         // use shared_ptr to keep structure in same place in memory
         std::stack<std::shared_ptr<ActiveRenderTarget>> Targets;
     };
 
     static std::unique_ptr<RendererData> s_Data;
+
+    static void ReleaseUniformPages(FrameUniforms& uniforms, bool releaseCurrent);
+
+    // decoded from draw commands, kept around per recording thread to reuse vector capacity
+    static thread_local IndexedRenderCall s_DecodedCall;
+    static thread_local BindCounts s_BindCounts;
+    static uint64_t GetNanoseconds(RenderClock::duration duration) {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
     static void RenderThread() {
         tracy::SetThreadName("Render thread");
-        s_Data->RenderThread.ID = std::this_thread::get_id();
+
+        auto& renderThread = s_Data->RenderThread;
+        auto& queue = *renderThread.Queue;
+        renderThread.ID = std::this_thread::get_id();
 
         FUUJIN_DEBUG("Render thread starting...");
 
-        while (s_Data) {
-            bool doSleep = false;
+        QueueCallback callback;
+        bool woken = false;
+        auto awakeSince = RenderClock::now();
 
-            {
-                auto& queue = s_Data->RenderThread.Queue;
-                std::optional<QueueCallback> callback;
+        while (renderThread.Running.load(std::memory_order_acquire)) {
+            // read the signal before checking the queue, so that a push in between wakes us
+            uint32_t signal = queue.GetSignal();
+            if (!queue.TryPop(callback)) {
+                renderThread.BusyTime += GetNanoseconds(RenderClock::now() - awakeSince);
 
-                {
-                    std::lock_guard lock(s_Data->RenderThread.Mutex);
-                    if (!queue.empty()) {
-                        callback = queue.front();
-                    }
-                }
+                queue.Sleep(signal);
+                awakeSince = RenderClock::now();
+                woken = true;
+
+                continue;
+            }
 
-                if (callback.has_value()) {
-                    FUUJIN_TRACE("Render thread: {}", callback->Label.c_str());
-                    callback->Callback();
+            if (woken) {
+                uint64_t latency = GetNanoseconds(awakeSince - callback.Submitted);
+                renderThread.Wakeups++;
+                renderThread.TotalWakeLatency += latency;
 
-                    {
-                        std::lock_guard lock(s_Data->RenderThread.Mutex);
-                        queue.pop();
-                    }
-                } else {
-                    doSleep = true;
+                uint64_t maxLatency = renderThread.MaxWakeLatency.load();
+                while (latency > maxLatency &&
+                       !renderThread.MaxWakeLatency.compare_exchange_weak(maxLatency, latency)) {
                 }
+
+                woken = false;
             }
 
-            if (doSleep) {
-                std::this_thread::sleep_for(1ms);
+            FUUJIN_TRACE("Render thread: {}", callback.Label.c_str());
+            callback.Callback();
+
+            // release captured references before anyone is told the job is done
+            callback = QueueCallback();
+
+            renderThread.Completed++;
+            if (renderThread.Waiters.load() > 0) {
+                std::lock_guard lock(renderThread.WaitMutex);
+                renderThread.WaitCondition.notify_all();
+            }
+        }
+
+        FUUJIN_DEBUG("Render thread exiting...");
+    }
+
+    static void LogRenderQueueStatistics() {
+        ZoneScoped;
+
+        auto stats = Renderer::GetQueueStatistics();
+        FUUJIN_INFO("Render queue:");
+        FUUJIN_INFO("\tJobs executed: {} ({} wakeups)", stats.JobsExecuted, stats.Wakeups);
+        FUUJIN_INFO("\tThroughput: {:.0f} jobs/s", stats.JobsPerSecond);
+
+        FUUJIN_INFO("\tWake latency: {:.1f} us average, {:.1f} us max",
+                    stats.AverageWakeLatency.count() * 1e6, stats.MaxWakeLatency.count() * 1e6);
+    }
+
+    // uploads are flushed before the graphics work that may depend on them
+    static const QueueType s_FlushOrder[] = { QueueType::Transfer, QueueType::Compute,
+                                              QueueType::Graphics };
+
+    static void RT_FlushQueues() {
+        ZoneScoped;
+
+        for (auto type : s_FlushOrder) {
+            auto queue = s_Data->Context->GetQueue(type);
+            if (queue.IsPresent()) {
+                queue->RT_Flush();
+            }
+        }
+    }
+
+    static uint64_t GetQueueSubmitCount() {
+        ZoneScoped;
+
+        // queue types may share a queue
+        std::unordered_set<CommandQueue*> queues;
+        uint64_t count = 0;
+
+        for (auto type : s_FlushOrder) {
+            auto queue = s_Data->Context->GetQueue(type);
+            if (queue.IsPresent() && queues.insert(queue.Raw()).second) {
+                count += queue->GetSubmitCount();
             }
         }
+
+        return count;
     }
 
     static void LogGraphicsContext() {
@@ -222,7 +543,7 @@ namespace fuujin {
         Buffer Data;
     };
 
-    static void RT_UpdateWhiteCubemap(const CubemapData* data) {
+    static void RT_UpdateWhiteCubeArray(const CubemapData* data) {
         ZoneScoped;
 
         DeviceBuffer::Spec bufferSpec;
@@ -241,32 +562,34 @@ namespace fuujin {
         loadInfo.CopyRect.Width = textureSpec.Width;
         loadInfo.CopyRect.Height = textureSpec.Height;
 
-        for (uint32_t i = 0; i < 6; i++) {
+        for (uint32_t i = 0; i < 6 * textureSpec.Layers; i++) {
             loadInfo.Layer = i;
             RT_LoadTextureData(&loadInfo);
         }
     }
 
-    static void CreateWhiteCubemap(const Buffer& data) {
+    // bound in place of a scene's shadow atlas, so that every light is lit
+    static void CreateWhiteCubeArray(const Buffer& data) {
         ZoneScoped;
 
         Texture::Spec spec;
         spec.Samples = 1;
         spec.TextureSampler = s_Data->DefaultSampler;
-        spec.TextureType = Texture::Type::Cube;
+        spec.TextureType = Texture::Type::CubeArray;
+        spec.Layers = 1;
         spec.ImageFormat = Texture::Format::RGBA8;
         spec.MipLevels = 1;
         spec.Width = spec.Height = 1;
         spec.Depth = 1;
 
-        s_Data->WhiteCubemap = s_Data->Context->CreateTexture(spec);
+        s_Data->WhiteCubeArray = s_Data->Context->CreateTexture(spec);
 
         auto loadData = new CubemapData;
-        loadData->Cubemap = s_Data->WhiteCubemap;
+        loadData->Cubemap = s_Data->WhiteCubeArray;
         loadData->Data = data;
 
         Renderer::Submit([loadData]() {
-            RT_UpdateWhiteCubemap(loadData);
+            RT_UpdateWhiteCubeArray(loadData);
             delete loadData;
         });
     }
@@ -281,7 +604,11 @@ namespace fuujin {
         std::memset(whiteData.Get(), 0xFF, whiteData.GetSize());
         s_Data->WhiteTexture = CreateTexture(1, 1, Texture::Format::RGBA8, whiteData);
 
-        CreateWhiteCubemap(whiteData);
+        if (GetAPI().MaxBindlessTextures > 0) {
+            s_Data->Bindless.Textures.push_back({ s_Data->WhiteTexture, 1 });
+        }
+
+        CreateWhiteCubeArray(whiteData);
     }
 
     void Renderer::Init() {
@@ -293,13 +620,21 @@ namespace fuujin {
         }
 
         s_Data = std::make_unique<RendererData>();
-        s_Data->RenderThread.Thread = std::thread(RenderThread);
-        s_Data->RenderThread.Thread.detach();
 
-        s_Data->Context = GraphicsContext::Get();
-        s_Data->Library = std::make_unique<ShaderLibrary>(s_Data->Context);
+        auto& renderThread = s_Data->RenderThread;
+        renderThread.Queue = std::make_unique<RingQueue<QueueCallback>>(s_RenderQueueCapacity);
+        renderThread.Running = true;
+        renderThread.Submitted = renderThread.Completed = 0;
+        renderThread.Waiters = 0;
+        renderThread.Wakeups = renderThread.TotalWakeLatency = 0;
+        renderThread.MaxWakeLatency = renderThread.BusyTime = 0;
+        renderThread.Thread = std::thread(RenderThread);
 
+        s_Data->Context = GraphicsContext::Get();
         s_Data->Context->GetDevice()->GetProperties(s_Data->DeviceProperties);
+
+        // embedded shaders are loaded depending on what the device supports
+        s_Data->Library = std::make_unique<ShaderLibrary>(s_Data->Context);
         Renderer::Submit([]() { LogGraphicsContext(); });
         Renderer::Wait();
 
@@ -312,6 +647,36 @@ namespace fuujin {
 
         s_Data->API = s_Data->Context->CreateRendererAPI(frameCount);
         s_Data->FrameCount = frameCount;
+        s_Data->FrameLead = std::min<uint32_t>(1, frameCount);
+
+        for (uint32_t i = 0; i < frameCount; i++) {
+            s_Data->CommandArenas.push_back(std::make_unique<CommandArena>());
+        }
+
+        s_Data->ArenaJobs.resize(frameCount, 0);
+        s_Data->Instances.resize(frameCount);
+        for (auto& instances : s_Data->Instances) {
+            instances.Count = instances.Capacity = 0;
+        }
+
+        s_Data->Uniforms.resize(frameCount);
+        for (auto& uniforms : s_Data->Uniforms) {
+            uniforms.Used = uniforms.Demand = 0;
+            uniforms.Epoch = 1;
+        }
+
+        s_Data->FirstUniformUpload = s_Data->LastUniformUpload = nullptr;
+        s_Data->FirstStorageUpload = s_Data->LastStorageUpload = nullptr;
+
+        s_Data->Statistics = s_Data->LastStatistics = {};
+        s_Data->SubmitCount = 0;
+        s_Data->PipelineBinds = s_Data->BufferBinds = s_Data->ResourceBinds = 0;
+        s_Data->LastBindCounts = {};
+
+        s_Data->LastDescriptorCounts = {};
+        s_Data->Bindless.Enabled = false;
+        s_Data->AsyncPipelines = true;
+        s_Data->LayeredCameras = GetAPI().LayeredVertexOutput;
 
         Renderer::Submit(
             []() { s_Data->GraphicsQueue = s_Data->Context->GetQueue(QueueType::Graphics); },
@@ -327,13 +692,45 @@ namespace fuujin {
             return;
         }
 
+        Renderer::Submit(
+            []() {
+                RT_FlushRecordings();
+                RT_FlushQueues();
+            },
+            "Flush recordings");
+
         Wait();
+
+        // pipelines still compiling in the background need the context until they finish
+        // the render thread has started every compile job by now
+        for (const auto& pipeline : s_Data->PendingPipelines) {
+            JobSystem::Wait(pipeline->GetCompileJob());
+        }
+
+        s_Data->PendingPipelines.clear();
+
         delete s_Data->API;
 
+        // staged in the arenas about to be freed
+        s_Data->FirstUniformUpload = s_Data->LastUniformUpload = nullptr;
+        s_Data->FirstStorageUpload = s_Data->LastStorageUpload = nullptr;
+        s_Data->CommandArenas.clear();
+
+        for (auto& uniforms : s_Data->Uniforms) {
+            ReleaseUniformPages(uniforms, true);
+        }
+
+        s_Data->Uniforms.clear();
+
+        s_Data->Instances.clear();
         s_Data->MeshBuffers.clear();
         s_Data->ShaderData.clear();
 
-        s_Data->WhiteCubemap.Reset();
+        s_Data->Bindless.Allocations.clear();
+        s_Data->Bindless.Materials.clear();
+        s_Data->Bindless.Textures.clear();
+
+        s_Data->WhiteCubeArray.Reset();
         s_Data->WhiteTexture.Reset();
         s_Data->DefaultSampler.Reset();
 
@@ -342,6 +739,13 @@ namespace fuujin {
         s_Data->Context.Reset();
 
         Wait();
+        LogRenderQueueStatistics();
+
+        auto& renderThread = s_Data->RenderThread;
+        renderThread.Running.store(false, std::memory_order_release);
+        renderThread.Queue->Wake();
+        renderThread.Thread.join();
+
         s_Data.reset();
     }
 
@@ -399,758 +803,1991 @@ namespace fuujin {
         return s_Data->FrameCount;
     }
 
-    void Renderer::ProcessEvent(Event& event) {
+    void Renderer::SetFrameLead(uint32_t frames) {
         ZoneScoped;
+        if (!s_Data) {
+            return;
+        }
 
-        if (event.GetType() == EventType::ViewResized) {
-            auto swapchain = s_Data->Context->GetSwapchain();
-            if (swapchain.IsPresent()) {
-                auto& resizeEvent = (ViewResizedEvent&)event;
-                auto view = swapchain->GetView();
+        if (frames > s_Data->FrameCount) {
+            FUUJIN_WARN("Frame lead of {} exceeds frame count - clamping to {}", frames,
+                        s_Data->FrameCount);
 
-                if (resizeEvent.GetView() == view->GetID()) {
-                    swapchain->RequestResize(resizeEvent.GetFramebufferSize());
-                }
-            }
+            frames = s_Data->FrameCount;
         }
-    }
 
-    Ref<RendererAllocation> Renderer::CreateAllocation(const Ref<Shader>& shader) {
-        ZoneScoped;
-        return s_Data->API->CreateAllocation(shader);
+        s_Data->FrameLead = frames;
     }
 
-    void Renderer::FreeShader(uint64_t id) {
+    uint32_t Renderer::GetFrameLead() {
         ZoneScoped;
         if (!s_Data) {
-            return;
+            return 0;
         }
 
-        s_Data->ShaderData.erase(id);
+        return s_Data->FrameLead;
     }
 
-    void Renderer::FreeMaterial(uint64_t id) {
+    void Renderer::SetBindlessTextures(bool enabled) {
         ZoneScoped;
         if (!s_Data) {
             return;
         }
 
-        for (auto& [shaderID, data] : s_Data->ShaderData) {
-            data.Materials.erase(id);
+        bool supported = GetAPI().MaxBindlessTextures > 0;
+        if (enabled && !supported) {
+            FUUJIN_WARN("Bindless textures are not supported on this device - ignoring");
         }
+
+        s_Data->Bindless.Enabled = enabled && supported;
     }
 
-    void Renderer::FreeScene(uint64_t id) {
+    bool Renderer::GetBindlessTextures() {
         ZoneScoped;
         if (!s_Data) {
-            return;
+            return false;
         }
 
-        s_Data->SceneState.erase(id);
-        for (auto& [shaderID, data] : s_Data->ShaderData) {
-            data.Scenes.erase(id);
-        }
+        return s_Data->Bindless.Enabled;
     }
 
-    void Renderer::FreeMesh(uint64_t id) {
+    void Renderer::SetAsyncPipelines(bool enabled) {
         ZoneScoped;
-        if (!s_Data || !s_Data->MeshBuffers.contains(id)) {
+        if (!s_Data) {
             return;
         }
 
-        s_Data->MeshBuffers.erase(id);
+        s_Data->AsyncPipelines = enabled;
     }
 
-    void Renderer::FreeAnimator(uint64_t id) {
+    bool Renderer::GetAsyncPipelines() {
         ZoneScoped;
         if (!s_Data) {
-            return;
+            return false;
         }
 
-        for (auto& [shaderID, shaderData] : s_Data->ShaderData) {
-            shaderData.Animators.erase(id);
-        }
+        return s_Data->AsyncPipelines;
     }
 
-    void Renderer::UpdateScene(uint64_t id, const SceneData& data) {
+    void Renderer::SetLayeredCameras(bool enabled) {
         ZoneScoped;
         if (!s_Data) {
             return;
         }
 
-        if (!s_Data->SceneState.contains(id)) {
-            s_Data->SceneState[id].State = 0;
+        bool supported = GetAPI().LayeredVertexOutput;
+        if (enabled && !supported) {
+            FUUJIN_WARN("Layered vertex output is not supported on this device - ignoring");
         }
 
-        auto& state = s_Data->SceneState[id];
-        state.Data = data;
-        state.State++;
+        s_Data->LayeredCameras = enabled && supported;
     }
 
-    static void CreateObjectAllocation(const Ref<Shader>& shader, const std::string& bufferName,
-                                       ObjectAllocation& allocation) {
+    bool Renderer::GetLayeredCameras() {
         ZoneScoped;
+        if (!s_Data) {
+            return false;
+        }
 
-        allocation.Allocation = Renderer::CreateAllocation(shader);
-        allocation.State = 0;
-        allocation.IsNew = true;
+        return s_Data->LayeredCameras;
+    }
+
+    void Renderer::ProcessEvent(Event& event) {
+        ZoneScoped;
 
-        auto resource = shader->GetResourceByName(bufferName);
-        if (resource) {
-            DeviceBuffer::Spec bufferSpec;
-            bufferSpec.QueueOwnership = { QueueType::Graphics };
-            bufferSpec.Size = resource->GetType()->GetSize();
-            bufferSpec.BufferUsage = DeviceBuffer::Usage::Uniform;
+        if (event.GetType() == EventType::ViewResized) {
+            auto swapchain = s_Data->Context->GetSwapchain();
+            if (swapchain.IsPresent()) {
+                auto& resizeEvent = (ViewResizedEvent&)event;
+                auto view = swapchain->GetView();
 
-            allocation.Buffer = s_Data->Context->CreateBuffer(bufferSpec);
-            allocation.Allocation->Bind(bufferName, allocation.Buffer);
+                if (resizeEvent.GetView() == view->GetID()) {
+                    swapchain->RequestResize(resizeEvent.GetFramebufferSize());
+                }
+            }
         }
     }
 
-    struct AllocationUniformSet {
-        ShaderBuffer Data;
-        Ref<DeviceBuffer> UniformBuffer;
-    };
-
-    template <typename _Ty>
-    static bool UpdateObjectAllocation(const Ref<Shader>& shader, const std::string& bufferName,
-                                       ObjectAllocation& allocation, uint64_t currentState,
-                                       const _Ty& bufferCallback) {
+    Ref<RendererAllocation> Renderer::CreateAllocation(const Ref<Shader>& shader) {
         ZoneScoped;
+        return s_Data->API->CreateAllocation(shader);
+    }
 
-        if (currentState != allocation.State || allocation.IsNew) {
-            allocation.State = currentState;
-            allocation.IsNew = false;
+    static void BindTableTexture(uint32_t index) {
+        ZoneScoped;
 
-            auto bufferResource = shader->GetResourceByName(bufferName);
-            if (bufferResource) {
-                auto uniformSet = new AllocationUniformSet;
-                uniformSet->UniformBuffer = allocation.Buffer;
+        const auto& texture = s_Data->Bindless.Textures[index].TableTexture;
+        for (const auto& [shaderID, allocation] : s_Data->Bindless.Allocations) {
+            allocation->Bind(s_BindlessTableName, texture, index);
+        }
+    }
 
-                uniformSet->Data = ShaderBuffer(bufferResource->GetType());
-                auto& dataBuffer = uniformSet->Data.GetBuffer();
-                std::memset(dataBuffer.Get(), 0, dataBuffer.GetSize());
-                bufferCallback(uniformSet->Data);
+    static uint32_t AcquireTableTexture(const Ref<Texture>& texture) {
+        ZoneScoped;
 
-                Renderer::Submit([uniformSet]() {
-                    auto mapped = uniformSet->UniformBuffer->RT_Map();
-                    Buffer::Copy(uniformSet->Data.GetBuffer(), mapped);
-                    uniformSet->UniformBuffer->RT_Unmap();
+        auto& bindless = s_Data->Bindless;
+        uint64_t id = texture->GetID();
 
-                    delete uniformSet;
-                });
-            }
+        auto it = bindless.Indices.find(id);
+        if (it != bindless.Indices.end()) {
+            bindless.Textures[it->second].Users++;
+            return it->second;
+        }
 
-            return true;
+        uint32_t index;
+        if (!bindless.FreeIndices.empty()) {
+            index = bindless.FreeIndices.back();
+            bindless.FreeIndices.pop_back();
+        } else if (bindless.Textures.size() < Renderer::GetAPI().MaxBindlessTextures) {
+            index = (uint32_t)bindless.Textures.size();
+            bindless.Textures.emplace_back();
+        } else {
+            FUUJIN_WARN("Texture table is full - sampling white instead");
+            return 0;
         }
 
-        return false;
+        auto& entry = bindless.Textures[index];
+        entry.TableTexture = texture;
+        entry.Users = 1;
+
+        bindless.Indices[id] = index;
+        BindTableTexture(index);
+
+        return index;
     }
 
-    Ref<RendererAllocation> Renderer::GetSceneAllocation(uint64_t id, const Ref<Shader>& shader) {
+    static void ReleaseTableTexture(uint32_t index) {
         ZoneScoped;
-        if (!s_Data || !s_Data->SceneState.contains(id)) {
-            return nullptr;
+
+        auto& bindless = s_Data->Bindless;
+        if (index == 0 || --bindless.Textures[index].Users > 0) {
+            return;
         }
 
-        // see assets/shaders/include/Scene.glsl
-        static const std::string sceneBufferName = "Scene";
+        // frames in flight keep reading the descriptor sets they were recorded with
+        auto& entry = bindless.Textures[index];
+        bindless.Indices.erase(entry.TableTexture->GetID());
+        bindless.FreeIndices.push_back(index);
 
-        uint64_t shaderID = shader->GetID();
-        auto& shaderData = s_Data->ShaderData[shaderID];
+        entry.TableTexture = s_Data->WhiteTexture;
+        BindTableTexture(index);
+    }
 
-        if (!shaderData.Scenes.contains(id)) {
-            auto& newAllocation = shaderData.Scenes[id];
-            CreateObjectAllocation(shader, sceneBufferName, newAllocation);
-        }
+    static const glm::ivec4& GetTableIndices(const Ref<Material>& material) {
+        ZoneScoped;
 
-        const auto& scene = s_Data->SceneState.at(id);
-        auto callback = [&](ShaderBuffer& buffer) {
-            const auto& data = scene.Data;
+        auto& materials = s_Data->Bindless.Materials;
+        uint64_t id = material->GetID();
+        uint64_t state = material->GetState();
 
-            // see assets/shaders/include/Scene.glsl
-            for (size_t i = 0; i < data.Cameras.size(); i++) {
-                const auto& camera = data.Cameras[i];
-                std::string basePath = "Cameras[" + std::to_string(i) + "]";
-
-                ShaderBuffer cameraSlice;
-                if (!buffer.Slice(basePath, cameraSlice)) {
-                    continue;
-                }
+        auto it = materials.find(id);
+        if (it != materials.end() && it->second.State == state) {
+            return it->second.Indices;
+        }
 
-                cameraSlice.Set("Position", camera.Position);
-                cameraSlice.Set("ViewProjection", camera.ViewProjection);
-                cameraSlice.Set("ZRange", camera.ZRange);
+        // acquired before the previous indices are released, so that unchanged textures keep
+        // their place in the table
+        glm::ivec4 indices(0);
+        for (const auto& [slot, texture] : material->GetTextures()) {
+            if (texture.IsPresent()) {
+                indices[(glm::length_t)slot] = (int32_t)AcquireTableTexture(texture);
             }
+        }
 
-            size_t lightCount = data.Lights.size();
-            buffer.Set("LightCount", (int32_t)lightCount);
-
-            for (size_t i = 0; i < lightCount; i++) {
-                const auto& light = data.Lights[i];
-                std::string basePath = "Lights[" + std::to_string(i) + "]";
-
-                ShaderBuffer lightSlice;
-                if (!buffer.Slice(basePath, lightSlice)) {
-                    continue;
-                }
+        if (it != materials.end()) {
+            for (glm::length_t i = 0; i < 4; i++) {
+                ReleaseTableTexture((uint32_t)it->second.Indices[i]);
+            }
+        }
 
-                light.LightData->SetUniforms(lightSlice, light.TransformMatrix);
+        auto& entry = materials[id];
+        entry.State = state;
+        entry.Indices = indices;
 
-                lightSlice.Set("ShadowIndex", (int32_t)light.ShadowIndex);
-            }
-        };
+        return entry.Indices;
+    }
 
-        auto& allocation = shaderData.Scenes[id];
-        if (UpdateObjectAllocation(shader, sceneBufferName, allocation, scene.State, callback)) {
-            static const std::string shadowMapsName = "u_ShadowCubeMaps";
+    static Ref<RendererAllocation> GetTableAllocation(const Ref<Shader>& shader) {
+        ZoneScoped;
 
-            auto resource = shader->GetResourceByName(shadowMapsName);
-            if (resource) {
-                size_t shadowMapCount = resource->GetDimensions()[0];
+        auto& bindless = s_Data->Bindless;
+        uint64_t id = shader->GetID();
 
-                for (size_t i = 0; i < shadowMapCount; i++) {
-                    Ref<Texture> cubeMap;
-                    if (i >= scene.Data.ShadowCubeMaps.size()) {
-                        cubeMap = s_Data->WhiteCubemap;
-                    } else {
-                        cubeMap = scene.Data.ShadowCubeMaps[i];
-                    }
+        auto it = bindless.Allocations.find(id);
+        if (it != bindless.Allocations.end()) {
+            return it->second;
+        }
 
-                    allocation.Allocation->Bind(shadowMapsName, cubeMap, (uint32_t)i);
-                }
-            }
+        auto allocation = Renderer::CreateAllocation(shader);
+        for (uint32_t i = 0; i < (uint32_t)bindless.Textures.size(); i++) {
+            allocation->Bind(s_BindlessTableName, bindless.Textures[i].TableTexture, i);
         }
 
-        return allocation.Allocation;
+        bindless.Allocations[id] = allocation;
+        return allocation;
     }
 
-    Ref<RendererAllocation> Renderer::GetMaterialAllocation(const Ref<Material>& material,
-                                                            const Ref<Shader>& shader) {
+    void Renderer::FreeShader(uint64_t id) {
         ZoneScoped;
+        if (!s_Data) {
+            return;
+        }
 
-        // see assets/shaders/include/Material.glsl
-        static const std::string materialBufferName = "Material";
-
-        uint64_t shaderID = shader->GetID();
-        auto& shaderData = s_Data->ShaderData[shaderID];
+        s_Data->ShaderData.erase(id);
+        s_Data->Bindless.Allocations.erase(id);
+    }
 
-        uint64_t materialID = material->GetID();
-        if (!shaderData.Materials.contains(materialID)) {
-            auto& newAllocation = shaderData.Materials[materialID];
-            CreateObjectAllocation(shader, materialBufferName, newAllocation);
+    void Renderer::FreeMaterial(uint64_t id) {
+        ZoneScoped;
+        if (!s_Data) {
+            return;
         }
 
-        auto& allocation = shaderData.Materials[materialID];
-        uint64_t currentState = material->GetState();
+        for (auto& [shaderID, data] : s_Data->ShaderData) {
+            data.Materials.erase(id);
+        }
 
-        auto callback = [&](ShaderBuffer& buffer) { material->MapProperties(buffer); };
-        if (UpdateObjectAllocation(shader, materialBufferName, allocation, currentState,
-                                   callback)) {
-            const auto& textures = material->GetTextures();
-            for (uint32_t i = 0; i < (uint32_t)Material::TextureSlot::MAX; i++) {
-                auto slot = (Material::TextureSlot)i;
-                auto name = Material::GetTextureName(slot);
+        auto& materials = s_Data->Bindless.Materials;
+        auto it = materials.find(id);
 
-                auto texture = textures.contains(slot) ? textures.at(slot) : s_Data->WhiteTexture;
-                allocation.Allocation->Bind(name, texture);
+        if (it != materials.end()) {
+            for (glm::length_t i = 0; i < 4; i++) {
+                ReleaseTableTexture((uint32_t)it->second.Indices[i]);
             }
+
+            materials.erase(it);
         }
+    }
 
-        return allocation.Allocation;
+    void Renderer::FreeScene(uint64_t id) {
+        ZoneScoped;
+        if (!s_Data) {
+            return;
+        }
+
+        s_Data->SceneState.erase(id);
+        for (auto& [shaderID, data] : s_Data->ShaderData) {
+            data.Scenes.erase(id);
+        }
     }
 
-    size_t Renderer::HashMaterialPipelineSpec(const Material::PipelineProperties& spec,
-                                              uint32_t renderTarget) {
+    void Renderer::FreeMesh(uint64_t id) {
         ZoneScoped;
-        size_t hash = 0;
+        if (!s_Data || !s_Data->MeshBuffers.contains(id)) {
+            return;
+        }
 
-        hash |= renderTarget;
+        s_Data->MeshBuffers.erase(id);
+    }
 
-        if (spec.Wireframe) {
-            hash |= (1 << 8);
+    void Renderer::FreeAnimator(uint64_t id) {
+        ZoneScoped;
+        if (!s_Data) {
+            return;
         }
 
-        return hash;
+        for (auto& [shaderID, shaderData] : s_Data->ShaderData) {
+            shaderData.Animators.erase(id);
+        }
     }
 
-    Ref<Pipeline> Renderer::GetMaterialPipeline(const Ref<Shader>& shader,
-                                                const Ref<RenderTarget>& target,
-                                                const Material::PipelineProperties& spec) {
+    void Renderer::UpdateScene(uint64_t id, const SceneData& data) {
         ZoneScoped;
         if (!s_Data) {
-            return nullptr;
+            return;
         }
 
-        uint64_t shaderID = shader->GetID();
-        auto& shaderData = s_Data->ShaderData[shaderID];
+        if (!s_Data->SceneState.contains(id)) {
+            s_Data->SceneState[id].State = 0;
+        }
 
-        size_t hash = HashMaterialPipelineSpec(spec, target->GetID());
-        if (shaderData.MaterialPipelines.contains(hash)) {
-            return shaderData.MaterialPipelines.at(hash);
+        auto& state = s_Data->SceneState[id];
+        state.Data = data;
+        state.State++;
+
+        // fragments of cameras that cannot be clustered shade every light
+        if (!data.ClusterCamera.has_value() || data.ClusterCamera.value() >= data.Cameras.size() ||
+            !LightGrid::IsRangeSupported(data.Cameras[data.ClusterCamera.value()].ZRange)) {
+            state.Clusters.Clear();
+            return;
         }
 
-        Pipeline::Spec pipelineSpec;
-        pipelineSpec.PipelineType = Pipeline::Type::Graphics;
-        pipelineSpec.PipelineShader = shader;
-        pipelineSpec.Target = target;
-        pipelineSpec.PolygonFrontFace = FrontFace::CCW;
-        pipelineSpec.Wireframe = spec.Wireframe;
+        std::vector<LightGrid::LightVolume> volumes;
+        for (const auto& light : data.Lights) {
+            auto& volume = volumes.emplace_back();
+            volume.Center = glm::vec3(light.TransformMatrix[3]);
 
-        // skinning attributes (bone IDs, weights)
-        pipelineSpec.AttributeBindings[4] = 1;
-        pipelineSpec.AttributeBindings[5] = 1;
+            // attenuation is 0 past the influence radius of a point light
+            if (light.LightData->GetType() == Light::Type::Point) {
+                auto pointLight = light.LightData.As<PointLight>();
 
-        return shaderData.MaterialPipelines[hash] = s_Data->Context->CreatePipeline(pipelineSpec);
-    }
+                auto position = light.TransformMatrix * glm::vec4(pointLight->GetPosition(), 1.f);
+                volume.Center = glm::vec3(position);
+                volume.Radius = pointLight->GetAttenuation().InfluenceRadius;
+            }
+        }
 
-    template <glm::length_t L>
-    struct SizedBoneVertex {
-        static constexpr glm::length_t MaxBones = L;
+        const auto& camera = data.Cameras[data.ClusterCamera.value()];
+        state.Clusters.Build(camera.ViewProjection, camera.ZRange, volumes);
 
-        glm::vec<L, int32_t, glm::defaultp> Indices;
-        glm::vec<L, float, glm::defaultp> Weights;
-    };
+        s_Data->Statistics.ClusteredLights += state.Clusters.GetIndexCount();
+    }
 
-    using BoneVertex = SizedBoneVertex<4>;
+    static void CreateObjectAllocation(const Ref<Shader>& shader, ObjectAllocation& allocation) {
+        ZoneScoped;
 
-    struct MeshLoadData {
-        Renderer::MeshBuffers Actual, Staging;
-        std::vector<Buffer> Vertices;
-        std::vector<uint32_t> Indices;
-    };
+        allocation.Allocation = Renderer::CreateAllocation(shader);
+        allocation.State = 0;
+        allocation.IsNew = true;
+        allocation.UniformEpoch = 0;
+    }
 
-    static void RT_PopulateMeshBuffers(MeshLoadData* data) {
+    static ObjectAllocation& GetFrameAllocation(std::unordered_map<uint64_t, FrameAllocations>& map,
+                                                uint64_t id, const Ref<Shader>& shader) {
         ZoneScoped;
 
-        auto queue = s_Data->Context->GetQueue(QueueType::Transfer);
-        auto& cmdlist = queue->RT_Get();
-        cmdlist.RT_Begin();
+        auto& frames = map[id];
+        if (frames.empty()) {
+            frames.resize(s_Data->FrameCount);
+        }
 
-        auto mapped = data->Staging.IndexBuffer->RT_Map();
-        Buffer::Copy(Buffer::Wrapper(data->Indices), mapped);
-        data->Staging.IndexBuffer->RT_Unmap();
+        auto& allocation = frames[Renderer::GetCurrentFrame()];
+        if (allocation.Allocation.IsEmpty()) {
+            CreateObjectAllocation(shader, allocation);
+        }
 
-        data->Staging.IndexBuffer->RT_CopyToBuffer(cmdlist, data->Actual.IndexBuffer);
-        cmdlist.AddDependency(data->Staging.IndexBuffer);
-        cmdlist.AddDependency(data->Actual.IndexBuffer);
+        return allocation;
+    }
 
-        for (size_t i = 0; i < data->Vertices.size(); i++) {
-            const auto& vertexData = data->Vertices[i];
-            const auto& staging = data->Staging.VertexBuffers[i];
-            const auto& actual = data->Actual.VertexBuffers[i];
+    // the largest minUniformBufferOffsetAlignment vulkan allows
+    static constexpr size_t s_UniformAlignment = 256;
+    static constexpr size_t s_MinUniformPageSize = 64 * 1024;
 
-            mapped = staging->RT_Map();
-            Buffer::Copy(vertexData, mapped);
-            staging->RT_Unmap();
+    static std::shared_ptr<UniformPage> CreateUniformPage(size_t size) {
+        ZoneScoped;
 
-            staging->RT_CopyToBuffer(cmdlist, actual);
-            cmdlist.AddDependency(staging);
-            cmdlist.AddDependency(actual);
-        }
+        auto page = std::make_shared<UniformPage>();
+        page->Size = size;
 
-        cmdlist.RT_End();
-        queue->RT_Submit(cmdlist);
+        DeviceBuffer::Spec bufferSpec;
+        bufferSpec.QueueOwnership = { QueueType::Graphics };
+        bufferSpec.Size = size;
+        bufferSpec.BufferUsage = DeviceBuffer::Usage::Uniform;
+        page->UniformBuffer = s_Data->Context->CreateBuffer(bufferSpec);
 
-        delete data;
+        Renderer::Submit([page]() { page->Mapped = page->UniformBuffer->RT_Map(); },
+                         "Map uniform page");
+
+        return page;
     }
 
-    const Renderer::MeshBuffers& Renderer::GetMeshBuffers(const std::unique_ptr<Mesh>& mesh) {
+    static void ReleaseUniformPage(std::shared_ptr<UniformPage>&& page) {
         ZoneScoped;
 
-        uint64_t id = mesh->GetID();
-        if (!s_Data->MeshBuffers.contains(id)) {
-            FUUJIN_INFO("Creating vertex and index buffers for mesh {}", id);
+        // the last reference goes with the job
+        Renderer::Submit([page = std::move(page)]() { page->UniformBuffer->RT_Unmap(); },
+                         "Unmap uniform page");
+    }
 
-            const auto& vertices = mesh->GetVertices();
+    static void ReleaseUniformPages(FrameUniforms& uniforms, bool releaseCurrent) {
+        ZoneScoped;
 
-            auto data = new MeshLoadData;
-            data->Vertices.push_back(Buffer::Wrapper(vertices).Copy());
-            data->Indices = mesh->GetIndices();
+        for (auto& page : uniforms.Retired) {
+            ReleaseUniformPage(std::move(page));
+        }
 
-            const auto& bones = mesh->GetBones();
-            if (!bones.empty()) {
-                FUUJIN_INFO("Generating bone vertices for mesh {}", id);
+        uniforms.Retired.clear();
+        if (releaseCurrent && uniforms.Page) {
+            ReleaseUniformPage(std::move(uniforms.Page));
+        }
+    }
 
-                size_t vertexCount = vertices.size();
-                std::vector<size_t> boneCount(vertexCount, 0);
-                std::vector<BoneVertex> boneVertices(vertexCount, BoneVertex{});
+    // called once the render thread is done with the frame's previous uploads
+    static void ResetFrameUniforms(uint32_t frame) {
+        ZoneScoped;
 
-                for (const auto& bone : bones) {
-                    for (const auto& [index, weight] : bone.Weights) {
-                        auto& vertexBoneCount = boneCount[index];
-                        auto& vertex = boneVertices[index];
+        auto& uniforms = s_Data->Uniforms[frame];
+        ReleaseUniformPages(uniforms, false);
 
-                        if (vertexBoneCount >= BoneVertex::MaxBones) {
-                            throw std::runtime_error("Cannot have more than " +
-                                                     std::to_string(BoneVertex::MaxBones) +
-                                                     " bones per vertex!");
-                        }
+        // a page that was outgrown last time is replaced with one that fits the whole frame
+        if (uniforms.Page && uniforms.Demand > uniforms.Page->Size) {
+            ReleaseUniformPage(std::move(uniforms.Page));
+            uniforms.Page = CreateUniformPage(uniforms.Demand + uniforms.Demand / 2);
+        }
 
-                        vertex.Indices[vertexBoneCount] = (int32_t)bone.Index;
-                        vertex.Weights[vertexBoneCount] = weight;
-                        vertexBoneCount++;
-                    }
-                }
+        uniforms.Used = uniforms.Demand = 0;
+        uniforms.Epoch++;
+    }
 
-                data->Vertices.push_back(Buffer::Wrapper(boneVertices).Copy());
-            }
+    // reserves space for a uniform block in the current frame's page
+    // the returned upload's data is staged in the frame's command arena
+    static UniformUpload* ReserveUniforms(size_t size) {
+        ZoneScoped;
 
-            DeviceBuffer::Spec staging, actual;
-            staging.QueueOwnership = { QueueType::Transfer };
-            staging.BufferUsage = DeviceBuffer::Usage::Staging;
-            actual.QueueOwnership = { QueueType::Transfer, QueueType::Graphics };
-            actual.BufferUsage = DeviceBuffer::Usage::Index;
-            actual.Size = staging.Size = data->Indices.size() * sizeof(uint32_t);
+        uint32_t frame = Renderer::GetCurrentFrame();
+        auto& uniforms = s_Data->Uniforms[frame];
 
-            data->Staging.IndexBuffer = s_Data->Context->CreateBuffer(staging);
-            data->Actual.IndexBuffer = s_Data->Context->CreateBuffer(actual);
+        size_t alignedSize = (size + s_UniformAlignment - 1) & ~(s_UniformAlignment - 1);
+        size_t offset = uniforms.Used;
 
-            actual.BufferUsage = DeviceBuffer::Usage::Vertex;
-            for (const auto& vertices : data->Vertices) {
-                actual.Size = staging.Size = vertices.GetSize();
+        if (!uniforms.Page || offset + alignedSize > uniforms.Page->Size) {
+            size_t pageSize = std::max(s_MinUniformPageSize, alignedSize);
+            if (uniforms.Page) {
+                pageSize = std::max(pageSize, uniforms.Page->Size * 2);
 
-                data->Actual.VertexBuffers.push_back(s_Data->Context->CreateBuffer(actual));
-                data->Staging.VertexBuffers.push_back(s_Data->Context->CreateBuffer(staging));
+                // draws recorded earlier in the frame still read from the old page
+                uniforms.Retired.push_back(std::move(uniforms.Page));
             }
 
-            s_Data->MeshBuffers[id] = data->Actual;
-            Renderer::Submit([data] { RT_PopulateMeshBuffers(data); });
+            uniforms.Page = CreateUniformPage(pageSize);
+            offset = 0;
         }
 
-        return s_Data->MeshBuffers[id];
-    }
+        uniforms.Used = offset + alignedSize;
+        uniforms.Demand += alignedSize;
+        s_Data->Statistics.UniformMemory += alignedSize;
 
-    Ref<RendererAllocation> Renderer::GetAnimatorAllocation(const Ref<Animator>& animator,
-                                                            const Ref<Shader>& shader) {
-        ZoneScoped;
+        auto& arena = *s_Data->CommandArenas[frame];
+        auto upload = arena.Allocate<UniformUpload>();
+        upload->Page = uniforms.Page.get();
+        upload->Offset = offset;
+        upload->Size = size;
+        upload->Data = arena.Allocate(size, alignof(glm::vec4));
+        upload->Next = nullptr;
 
-        const auto& boneTransforms = animator->GetBoneTransforms();
-        if (boneTransforms.empty()) {
-            return nullptr; // no point
+        if (s_Data->LastUniformUpload != nullptr) {
+            s_Data->LastUniformUpload->Next = upload;
+        } else {
+            s_Data->FirstUniformUpload = upload;
         }
 
-        // see assets/shaders/MaterialSkinned.glsl
-        static const std::string boneBufferName = "Bones";
-
-        if (!shader->GetResourceByName(boneBufferName)) {
-            return nullptr;
-        }
+        s_Data->LastUniformUpload = upload;
+        return upload;
+    }
 
-        uint64_t shaderID = shader->GetID();
-        auto& shaderData = s_Data->ShaderData[shaderID];
+    // stages a copy of size bytes into the passed buffer, and returns the data to copy
+    static void* ReserveStorageUpload(const Ref<DeviceBuffer>& buffer, size_t size) {
+        ZoneScoped;
 
-        uint64_t animatorID = animator->GetID();
-        if (!shaderData.Animators.contains(animatorID)) {
-            auto& newAllocation = shaderData.Animators[animatorID];
-            CreateObjectAllocation(shader, boneBufferName, newAllocation);
-        }
+        auto& arena = *s_Data->CommandArenas[Renderer::GetCurrentFrame()];
+        arena.Intern(buffer);
 
-        auto callback = [&](ShaderBuffer& buffer) {
-            for (size_t i = 0; i < boneTransforms.size(); i++) {
-                buffer.Set("Transforms[" + std::to_string(i) + "]", boneTransforms[i]);
-            }
-        };
+        auto upload = arena.Allocate<StorageUpload>();
+        upload->Buffer = buffer.Raw();
+        upload->Size = size;
+        upload->Data = arena.Allocate(size, alignof(glm::vec4));
+        upload->Next = nullptr;
 
-        auto& allocation = shaderData.Animators[animatorID];
-        UpdateObjectAllocation(shader, boneBufferName, allocation, animator->GetState(), callback);
+        if (s_Data->LastStorageUpload != nullptr) {
+            s_Data->LastStorageUpload->Next = upload;
+        } else {
+            s_Data->FirstStorageUpload = upload;
+        }
 
-        return allocation.Allocation;
+        s_Data->LastStorageUpload = upload;
+        return upload->Data;
     }
 
-    Ref<Texture> Renderer::CreateTexture(uint32_t width, uint32_t height, Texture::Format format,
-                                         const Buffer& data, const Ref<Sampler>& sampler,
-                                         const fs::path& path) {
+    static void RT_UploadUniforms(const UniformUpload* first, const StorageUpload* firstStorage) {
         ZoneScoped;
-        if (!s_Data) {
-            FUUJIN_ERROR(
-                "Attempted to create texture with renderer not initialized! Returning null");
 
-            return nullptr;
+        for (auto upload = first; upload != nullptr; upload = upload->Next) {
+            auto destination = upload->Page->Mapped.Slice(upload->Offset, upload->Size);
+            Buffer::Copy(Buffer::Wrapper(upload->Data, upload->Size), destination);
         }
 
-        if (data.IsEmpty()) {
-            FUUJIN_ERROR("Attempted to create texture with an empty buffer! Returning null");
-            return nullptr;
+        for (auto upload = firstStorage; upload != nullptr; upload = upload->Next) {
+            auto mapped = upload->Buffer->RT_Map();
+            Buffer::Copy(Buffer::Wrapper(upload->Data, upload->Size), mapped, upload->Size);
+            upload->Buffer->RT_Unmap();
         }
+    }
 
-        Texture::Spec textureSpec;
-        textureSpec.TextureSampler = sampler.IsPresent() ? sampler : s_Data->DefaultSampler;
-        textureSpec.Path = path;
+    // pages are host coherent, so uploads only need to land before the work reading them is
+    // submitted
+    static void FlushUniformUploads() {
+        ZoneScoped;
+
+        auto first = s_Data->FirstUniformUpload;
+        auto firstStorage = s_Data->FirstStorageUpload;
+        if (first == nullptr && firstStorage == nullptr) {
+            return;
+        }
+
+        Renderer::Submit([first, firstStorage]() { RT_UploadUniforms(first, firstStorage); },
+                         "Upload uniforms");
+
+        s_Data->FirstUniformUpload = s_Data->LastUniformUpload = nullptr;
+        s_Data->FirstStorageUpload = s_Data->LastStorageUpload = nullptr;
+    }
+
+    template <typename _Ty>
+    static bool UpdateObjectAllocation(const Ref<Shader>& shader, const std::string& bufferName,
+                                       ObjectAllocation& allocation, uint64_t currentState,
+                                       const _Ty& bufferCallback) {
+        ZoneScoped;
+
+        // blocks written in an earlier trip through the frame have since been overwritten
+        const auto& uniforms = s_Data->Uniforms[Renderer::GetCurrentFrame()];
+        bool stale = allocation.UniformEpoch != uniforms.Epoch;
+
+        if (currentState != allocation.State || allocation.IsNew || stale) {
+            allocation.State = currentState;
+            allocation.IsNew = false;
+            allocation.UniformEpoch = uniforms.Epoch;
+
+            auto bufferResource = shader->GetResourceByName(bufferName);
+            if (bufferResource) {
+                auto type = bufferResource->GetType();
+                size_t size = type->GetSize();
+
+                // earlier draws this frame keep reading what was written before
+                auto upload = ReserveUniforms(size);
+                auto data = Buffer::Wrapper(upload->Data, size);
+                std::memset(data.Get(), 0, size);
+
+                ShaderBuffer uniformData(std::move(data), type);
+                bufferCallback(uniformData);
+
+                allocation.Allocation->Bind(bufferName, upload->Page->UniformBuffer, 0,
+                                            upload->Offset, size);
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    // see assets/shaders/include/Scene.glsl
+    static const std::string s_LightBufferName = "Lights";
+    static const std::string s_LightClusterBufferName = "LightClusters";
+
+    // the largest minStorageBufferOffsetAlignment vulkan allows
+    static constexpr size_t s_StorageAlignment = 256;
+
+    // writes the scene's lights and clusters for the current frame, if they have changed
+    // the buffer is left empty if the shader does not read either of them
+    static const SceneStorage& GetSceneStorage(RendererSceneState& scene,
+                                               const Ref<Shader>& shader) {
+        ZoneScoped;
+
+        uint32_t frame = Renderer::GetCurrentFrame();
+        const auto& uniforms = s_Data->Uniforms[frame];
+
+        if (scene.Storage.empty()) {
+            scene.Storage.resize(s_Data->FrameCount);
+            for (auto& storage : scene.Storage) {
+                storage.Capacity = 0;
+                storage.State = storage.Epoch = 0;
+            }
+        }
+
+        auto& storage = scene.Storage[frame];
+        if (storage.Buffer.IsPresent() && storage.State == scene.State) {
+            return storage;
+        }
+
+        auto lightResource = shader->GetResourceByName(s_LightBufferName);
+        if (!lightResource || !shader->GetResourceByName(s_LightClusterBufferName)) {
+            return storage;
+        }
+
+        const auto& fields = lightResource->GetType()->GetFields();
+        auto lightField = fields.find("Data");
+        if (lightField == fields.end()) {
+            throw std::runtime_error("Malformed light buffer!");
+        }
+
+        const auto& lightType = lightField->second.Type;
+        size_t lightOffset = lightField->second.Offset;
+        size_t lightStride = lightField->second.Stride;
+
+        // empty ranges cannot be bound
+        const auto& data = scene.Data;
+        const auto& clusters = scene.Clusters.GetData();
+        size_t lightCount = std::max<size_t>(data.Lights.size(), 1);
+        size_t clusterCount = std::max<size_t>(clusters.size(), 1);
+
+        storage.LightSize = lightOffset + lightCount * lightStride;
+        storage.ClusterOffset =
+            (storage.LightSize + s_StorageAlignment - 1) & ~(s_StorageAlignment - 1);
+        storage.ClusterSize = clusterCount * sizeof(uint32_t);
+
+        // draws recorded earlier this frame still read what was written before
+        size_t size = storage.ClusterOffset + storage.ClusterSize;
+        if (storage.Capacity < size || storage.Epoch == uniforms.Epoch) {
+            size_t capacity = storage.Capacity;
+            if (capacity < size) {
+                capacity = std::max(size, capacity * 2);
+            }
+
+            DeviceBuffer::Spec spec;
+            spec.QueueOwnership = { QueueType::Graphics };
+            spec.Size = capacity;
+            spec.BufferUsage = DeviceBuffer::Usage::Storage;
+
+            storage.Buffer = s_Data->Context->CreateBuffer(spec);
+            storage.Capacity = capacity;
+        }
+
+        storage.State = scene.State;
+        storage.Epoch = uniforms.Epoch;
+
+        // staged in the frame's arena, so that rewriting the scene does not touch the heap
+        auto contents = Buffer::Wrapper(ReserveStorageUpload(storage.Buffer, size), size);
+        std::memset(contents.Get(), 0, size);
+
+        for (size_t i = 0; i < data.Lights.size(); i++) {
+            const auto& light = data.Lights[i];
+
+            size_t offset = lightOffset + i * lightStride;
+            ShaderBuffer lightBuffer(contents.Slice(offset, lightType->GetSize()), lightType);
+            light.LightData->SetUniforms(lightBuffer, light.TransformMatrix);
+
+            // lights without a shadow map are never shadowed
+            int32_t shadowIndex = -1;
+            if (data.ShadowAtlas.IsPresent() && light.ShadowIndex.has_value()) {
+                shadowIndex = (int32_t)light.ShadowIndex.value();
+            }
+
+            lightBuffer.Set("ShadowIndex", shadowIndex);
+            lightBuffer.Set("ShadowScale", light.ShadowScale);
+        }
+
+        if (!clusters.empty()) {
+            Buffer::Copy(Buffer::Wrapper(clusters), contents.Slice(storage.ClusterOffset));
+        }
+
+        return storage;
+    }
+
+    Ref<RendererAllocation> Renderer::GetSceneAllocation(uint64_t id, const Ref<Shader>& shader) {
+        ZoneScoped;
+        if (!s_Data || !s_Data->SceneState.contains(id)) {
+            return nullptr;
+        }
+
+        // see assets/shaders/include/Scene.glsl
+        static const std::string sceneBufferName = "Scene";
+
+        uint64_t shaderID = shader->GetID();
+        auto& shaderData = s_Data->ShaderData[shaderID];
+        auto& allocation = GetFrameAllocation(shaderData.Scenes, id, shader);
+
+        auto& scene = s_Data->SceneState.at(id);
+        auto callback = [&](ShaderBuffer& buffer) {
+            const auto& data = scene.Data;
+
+            // see assets/shaders/include/Scene.glsl
+            ShaderBuffer::FieldHandle cameras, position, viewProjection, zRange;
+            if (buffer.GetFieldHandle("Cameras", cameras)) {
+                ShaderBuffer::GetFieldHandle(cameras.Type, "Position", position);
+                ShaderBuffer::GetFieldHandle(cameras.Type, "ViewProjection", viewProjection);
+                ShaderBuffer::GetFieldHandle(cameras.Type, "ZRange", zRange);
+
+                size_t cameraCount = std::min(data.Cameras.size(), cameras.Count);
+                for (size_t i = 0; i < cameraCount; i++) {
+                    const auto& camera = data.Cameras[i];
+
+                    ShaderBuffer cameraSlice;
+                    buffer.Slice(cameras, i, cameraSlice);
+
+                    cameraSlice.Set(position, 0, camera.Position);
+                    cameraSlice.Set(viewProjection, 0, camera.ViewProjection);
+                    cameraSlice.Set(zRange, 0, camera.ZRange);
+                }
+            }
+
+            buffer.Set("LightCount", (int32_t)data.Lights.size());
+
+            // without clusters, fragments shade every light
+            int32_t clusterCamera = -1;
+            if (!scene.Clusters.GetData().empty()) {
+                clusterCamera = (int32_t)data.ClusterCamera.value();
+            }
+
+            buffer.Set("ClusterCamera", clusterCamera);
+        };
+
+        if (UpdateObjectAllocation(shader, sceneBufferName, allocation, scene.State, callback)) {
+            static const std::string shadowAtlasName = "u_ShadowAtlas";
+
+            if (shader->GetResourceByName(shadowAtlasName)) {
+                auto atlas = scene.Data.ShadowAtlas;
+                if (atlas.IsEmpty()) {
+                    atlas = s_Data->WhiteCubeArray;
+                }
+
+                allocation.Allocation->Bind(shadowAtlasName, atlas);
+            }
+
+            const auto& storage = GetSceneStorage(scene, shader);
+            if (storage.Buffer.IsPresent()) {
+                allocation.Allocation->Bind(s_LightBufferName, storage.Buffer, 0, 0,
+                                            storage.LightSize);
+
+                allocation.Allocation->Bind(s_LightClusterBufferName, storage.Buffer, 0,
+                                            storage.ClusterOffset, storage.ClusterSize);
+            }
+        }
+
+        return allocation.Allocation;
+    }
+
+    Ref<RendererAllocation> Renderer::GetMaterialAllocation(const Ref<Material>& material,
+                                                            const Ref<Shader>& shader) {
+        ZoneScoped;
+
+        // see assets/shaders/include/Material.glsl
+        static const std::string materialBufferName = "Material";
+
+        uint64_t shaderID = shader->GetID();
+        auto& shaderData = s_Data->ShaderData[shaderID];
+
+        auto& allocation = GetFrameAllocation(shaderData.Materials, material->GetID(), shader);
+
+        uint64_t currentState = material->GetState();
+
+        // bindless shaders index into the texture table instead of binding textures per material
+        bool bindless = shader->GetResourceByName(s_BindlessTableName) != nullptr;
+        glm::ivec4 tableIndices(0);
+
+        if (bindless) {
+            tableIndices = GetTableIndices(material);
+        }
+
+        auto callback = [&](ShaderBuffer& buffer) {
+            material->MapProperties(buffer);
+
+            if (bindless) {
+                buffer.Set("TextureIndices", tableIndices);
+            }
+        };
+
+        if (UpdateObjectAllocation(shader, materialBufferName, allocation, currentState,
+                                   callback) &&
+            !bindless) {
+            const auto& textures = material->GetTextures();
+            for (uint32_t i = 0; i < (uint32_t)Material::TextureSlot::MAX; i++) {
+                auto slot = (Material::TextureSlot)i;
+                auto name = Material::GetTextureName(slot);
+
+                auto texture = textures.contains(slot) ? textures.at(slot) : s_Data->WhiteTexture;
+                allocation.Allocation->Bind(name, texture);
+            }
+        }
+
+        return allocation.Allocation;
+    }
+
+    size_t Renderer::HashMaterialPipelineSpec(const Material::PipelineProperties& spec,
+                                              uint32_t renderTarget) {
+        ZoneScoped;
+        size_t hash = 0;
+
+        hash |= renderTarget;
+
+        if (spec.Wireframe) {
+            hash |= (1 << 8);
+        }
+
+        if (!spec.Blended) {
+            hash |= (1 << 9);
+        }
+
+        return hash;
+    }
+
+    Ref<Pipeline> Renderer::GetMaterialPipeline(const Ref<Shader>& shader,
+                                                const Ref<RenderTarget>& target,
+                                                const Material::PipelineProperties& spec,
+                                                bool async) {
+        ZoneScoped;
+        if (!s_Data) {
+            return nullptr;
+        }
+
+        uint64_t shaderID = shader->GetID();
+        auto& shaderData = s_Data->ShaderData[shaderID];
+
+        size_t hash = HashMaterialPipelineSpec(spec, target->GetID());
+        if (shaderData.MaterialPipelines.contains(hash)) {
+            return shaderData.MaterialPipelines.at(hash);
+        }
+
+        Pipeline::Spec pipelineSpec;
+        pipelineSpec.PipelineType = Pipeline::Type::Graphics;
+        pipelineSpec.PipelineShader = shader;
+        pipelineSpec.Target = target;
+        pipelineSpec.PolygonFrontFace = FrontFace::CCW;
+        pipelineSpec.Wireframe = spec.Wireframe;
+        pipelineSpec.Blending = spec.Blended ? ColorBlending::Default : ColorBlending::None;
+        pipelineSpec.Async = async && s_Data->AsyncPipelines;
+
+        // skinning attributes (bone IDs, weights)
+        pipelineSpec.AttributeBindings[4] = 1;
+        pipelineSpec.AttributeBindings[5] = 1;
+
+        auto pipeline = s_Data->Context->CreatePipeline(pipelineSpec);
+        if (pipelineSpec.Async) {
+            s_Data->PendingPipelines.push_back(pipeline);
+        }
+
+        return shaderData.MaterialPipelines[hash] = pipeline;
+    }
+
+    template <glm::length_t L>
+    struct SizedBoneVertex {
+        static constexpr glm::length_t MaxBones = L;
+
+        glm::vec<L, int32_t, glm::defaultp> Indices;
+        glm::vec<L, float, glm::defaultp> Weights;
+    };
+
+    using BoneVertex = SizedBoneVertex<4>;
+
+    struct MeshLoadData {
+        Renderer::MeshBuffers Actual, Staging;
+        std::vector<Buffer> Vertices;
+        std::vector<uint32_t> Indices;
+    };
+
+    static void RT_PopulateMeshBuffers(MeshLoadData* data) {
+        ZoneScoped;
+
+        auto queue = s_Data->Context->GetQueue(QueueType::Transfer);
+        auto& cmdlist = queue->RT_Get();
+        cmdlist.RT_Begin();
+
+        auto mapped = data->Staging.IndexBuffer->RT_Map();
+        Buffer::Copy(Buffer::Wrapper(data->Indices), mapped);
+        data->Staging.IndexBuffer->RT_Unmap();
+
+        data->Staging.IndexBuffer->RT_CopyToBuffer(cmdlist, data->Actual.IndexBuffer);
+        cmdlist.AddDependency(data->Staging.IndexBuffer);
+        cmdlist.AddDependency(data->Actual.IndexBuffer);
+
+        for (size_t i = 0; i < data->Vertices.size(); i++) {
+            const auto& vertexData = data->Vertices[i];
+            const auto& staging = data->Staging.VertexBuffers[i];
+            const auto& actual = data->Actual.VertexBuffers[i];
+
+            mapped = staging->RT_Map();
+            Buffer::Copy(vertexData, mapped);
+            staging->RT_Unmap();
+
+            staging->RT_CopyToBuffer(cmdlist, actual);
+            cmdlist.AddDependency(staging);
+            cmdlist.AddDependency(actual);
+        }
+
+        cmdlist.RT_End();
+        queue->RT_Submit(cmdlist);
+
+        delete data;
+    }
+
+    const Renderer::MeshBuffers& Renderer::GetMeshBuffers(const std::unique_ptr<Mesh>& mesh) {
+        ZoneScoped;
+
+        uint64_t id = mesh->GetID();
+        if (!s_Data->MeshBuffers.contains(id)) {
+            FUUJIN_INFO("Creating vertex and index buffers for mesh {}", id);
+
+            const auto& vertices = mesh->GetVertices();
+
+            auto data = new MeshLoadData;
+            data->Vertices.push_back(Buffer::Wrapper(vertices).Copy());
+            data->Indices = mesh->GetIndices();
+
+            const auto& bones = mesh->GetBones();
+            if (!bones.empty()) {
+                FUUJIN_INFO("Generating bone vertices for mesh {}", id);
+
+                size_t vertexCount = vertices.size();
+                std::vector<size_t> boneCount(vertexCount, 0);
+                std::vector<BoneVertex> boneVertices(vertexCount, BoneVertex{});
+
+                for (const auto& bone : bones) {
+                    for (const auto& [index, weight] : bone.Weights) {
+                        auto& vertexBoneCount = boneCount[index];
+                        auto& vertex = boneVertices[index];
+
+                        if (vertexBoneCount >= BoneVertex::MaxBones) {
+                            throw std::runtime_error("Cannot have more than " +
+                                                     std::to_string(BoneVertex::MaxBones) +
+                                                     " bones per vertex!");
+                        }
+
+                        vertex.Indices[vertexBoneCount] = (int32_t)bone.Index;
+                        vertex.Weights[vertexBoneCount] = weight;
+                        vertexBoneCount++;
+                    }
+                }
+
+                data->Vertices.push_back(Buffer::Wrapper(boneVertices).Copy());
+            }
+
+            DeviceBuffer::Spec staging, actual;
+            staging.QueueOwnership = { QueueType::Transfer };
+            staging.BufferUsage = DeviceBuffer::Usage::Staging;
+            actual.QueueOwnership = { QueueType::Transfer, QueueType::Graphics };
+            actual.BufferUsage = DeviceBuffer::Usage::Index;
+            actual.Size = staging.Size = data->Indices.size() * sizeof(uint32_t);
+
+            data->Staging.IndexBuffer = s_Data->Context->CreateBuffer(staging);
+            data->Actual.IndexBuffer = s_Data->Context->CreateBuffer(actual);
+
+            actual.BufferUsage = DeviceBuffer::Usage::Vertex;
+            for (const auto& vertices : data->Vertices) {
+                actual.Size = staging.Size = vertices.GetSize();
+
+                data->Actual.VertexBuffers.push_back(s_Data->Context->CreateBuffer(actual));
+                data->Staging.VertexBuffers.push_back(s_Data->Context->CreateBuffer(staging));
+            }
+
+            s_Data->MeshBuffers[id] = data->Actual;
+            Renderer::Submit([data] { RT_PopulateMeshBuffers(data); });
+        }
+
+        return s_Data->MeshBuffers[id];
+    }
+
+    Ref<RendererAllocation> Renderer::GetAnimatorAllocation(const Ref<Animator>& animator,
+                                                            const Ref<Shader>& shader) {
+        ZoneScoped;
+
+        const auto& boneTransforms = animator->GetBoneTransforms();
+        if (boneTransforms.empty()) {
+            return nullptr; // no point
+        }
+
+        // see assets/shaders/MaterialSkinned.glsl
+        static const std::string boneBufferName = "Bones";
+
+        if (!shader->GetResourceByName(boneBufferName)) {
+            return nullptr;
+        }
+
+        uint64_t shaderID = shader->GetID();
+        auto& shaderData = s_Data->ShaderData[shaderID];
+
+        auto& allocation = GetFrameAllocation(shaderData.Animators, animator->GetID(), shader);
+
+        auto callback = [&](ShaderBuffer& buffer) {
+            ShaderBuffer::FieldHandle transforms;
+            if (!buffer.GetFieldHandle("Transforms", transforms)) {
+                return;
+            }
+
+            size_t count = std::min(boneTransforms.size(), transforms.Count);
+            buffer.SetArray(transforms, 0, boneTransforms.data(), count);
+        };
+
+        UpdateObjectAllocation(shader, boneBufferName, allocation, animator->GetState(), callback);
+
+        return allocation.Allocation;
+    }
+
+    Ref<Texture> Renderer::CreateTexture(uint32_t width, uint32_t height, Texture::Format format,
+                                         const Buffer& data, const Ref<Sampler>& sampler,
+                                         const fs::path& path) {
+        ZoneScoped;
+        if (!s_Data) {
+            FUUJIN_ERROR(
+                "Attempted to create texture with renderer not initialized! Returning null");
+
+            return nullptr;
+        }
+
+        if (data.IsEmpty()) {
+            FUUJIN_ERROR("Attempted to create texture with an empty buffer! Returning null");
+            return nullptr;
+        }
+
+        Texture::Spec textureSpec;
+        textureSpec.TextureSampler = sampler.IsPresent() ? sampler : s_Data->DefaultSampler;
+        textureSpec.Path = path;
+
+        textureSpec.Width = width;
+        textureSpec.Height = height;
+        textureSpec.Depth = 1;
+        textureSpec.MipLevels = 1; // todo: mipmaps
+        textureSpec.Samples = 1;
+        textureSpec.ImageFormat = format;
+        textureSpec.TextureType = Texture::Type::_2D;
+
+        Scissor scissor;
+        scissor.X = 0;
+        scissor.Y = 0;
+        scissor.Width = width;
+        scissor.Height = height;
+
+        auto texture = s_Data->Context->CreateTexture(textureSpec);
+        UpdateTexture(texture, data, scissor);
+
+        return texture;
+    }
+
+    void Renderer::UpdateTexture(const Ref<Texture>& texture, const Buffer& data,
+                                 const Scissor& scissor) {
+        ZoneScoped;
+
+        DeviceBuffer::Spec stagingSpec;
+        stagingSpec.QueueOwnership = { QueueType::Transfer };
+        stagingSpec.Size = data.GetSize();
+        stagingSpec.BufferUsage = DeviceBuffer::Usage::Staging;
+
+        auto loadInfo = new TextureLoadInfo;
+        loadInfo->StagingBuffer = s_Data->Context->CreateBuffer(stagingSpec);
+        loadInfo->Instance = texture;
+        loadInfo->ImageData = data;
+        loadInfo->CopyRect = scissor;
+        loadInfo->Layer = 0;
+
+        Renderer::Submit([loadInfo]() {
+            RT_LoadTextureData(loadInfo);
+            delete loadInfo;
+        });
+    }
+
+    void Renderer::Submit(const std::function<void()>& callback,
+                          const std::optional<std::string>& label) {
+        auto jobLabel = label.value_or("<unnamed render task>");
+        if (IsRenderThread()) {
+            FUUJIN_TRACE("Render thread: inline sub-job {}", jobLabel.c_str());
+            callback();
+
+            return;
+        }
+
+        QueueCallback data;
+        data.Callback = callback;
+        data.Label = std::move(jobLabel);
+        data.Submitted = RenderClock::now();
+
+        auto& renderThread = s_Data->RenderThread;
+        renderThread.Submitted++;
+        renderThread.Queue->Push(std::move(data));
+    }
+
+    // waits for the first n jobs submitted to the render thread to finish
+    static bool WaitForJobs(uint64_t target, std::optional<std::chrono::milliseconds> timeout) {
+        ZoneScoped;
+        spdlog::stopwatch timer;
+
+        auto& renderThread = s_Data->RenderThread;
+        auto finished = [&]() { return renderThread.Completed.load() >= target; };
+
+        if (!finished()) {
+            renderThread.Waiters++;
+
+            bool succeeded = true;
+            {
+                std::unique_lock lock(renderThread.WaitMutex);
+                if (timeout.has_value()) {
+                    succeeded =
+                        renderThread.WaitCondition.wait_for(lock, timeout.value(), finished);
+                } else {
+                    renderThread.WaitCondition.wait(lock, finished);
+                }
+            }
+
+            renderThread.Waiters--;
+            if (!succeeded) {
+                FUUJIN_WARN("Waited {} to clear render queue - timed out", timer.elapsed_ms());
+                return false;
+            }
+        }
+
+        FUUJIN_TRACE("Waited {} to clear render queue", timer.elapsed_ms());
+        return true;
+    }
+
+    bool Renderer::Wait(std::optional<std::chrono::milliseconds> timeout) {
+        FUUJIN_TRACE("Waiting for render queue to finish...");
+
+        return WaitForJobs(s_Data->RenderThread.Submitted.load(), timeout);
+    }
+
+    Renderer::QueueStatistics Renderer::GetQueueStatistics() {
+        ZoneScoped;
+
+        QueueStatistics stats{};
+        if (!s_Data) {
+            return stats;
+        }
+
+        const auto& renderThread = s_Data->RenderThread;
+        stats.JobsExecuted = renderThread.Completed.load();
+        stats.Wakeups = renderThread.Wakeups.load();
+
+        uint64_t busyTime = renderThread.BusyTime.load();
+        if (busyTime > 0) {
+            stats.JobsPerSecond = (double)stats.JobsExecuted * 1e9 / (double)busyTime;
+        }
 
-        textureSpec.Width = width;
-        textureSpec.Height = height;
-        textureSpec.Depth = 1;
-        textureSpec.MipLevels = 1; // todo: mipmaps
-        textureSpec.Samples = 1;
-        textureSpec.ImageFormat = format;
-        textureSpec.TextureType = Texture::Type::_2D;
+        if (stats.Wakeups > 0) {
+            auto totalLatency = (double)renderThread.TotalWakeLatency.load() / 1e9;
+            stats.AverageWakeLatency = Duration(totalLatency / (double)stats.Wakeups);
+        }
 
-        Scissor scissor;
-        scissor.X = 0;
-        scissor.Y = 0;
-        scissor.Width = width;
-        scissor.Height = height;
+        stats.MaxWakeLatency = Duration((double)renderThread.MaxWakeLatency.load() / 1e9);
+        return stats;
+    }
+
+    const Renderer::FrameStatistics& Renderer::GetFrameStatistics() {
+        ZoneScoped;
+        if (!s_Data) {
+            throw std::runtime_error("Renderer has not been initialized!");
+        }
+
+        return s_Data->LastStatistics;
+    }
+
+    bool Renderer::IsRenderThread() {
+        ZoneScoped;
+
+        return std::this_thread::get_id() == s_Data->RenderThread.ID;
+    }
+
+    static void RT_FlushRecordings();
+
+    static void RT_NewFrame(uint32_t frame) {
+        ZoneScoped;
+
+        // descriptor pools are about to be reset
+        RT_FlushRecordings();
+        RT_FlushQueues();
+
+        s_Data->API->RT_NewFrame(frame);
+    }
+
+    static const glm::vec4 s_ClearColor = glm::vec4(glm::vec3(0.1f), 1.f);
+
+    static void RT_BeginRenderTarget(std::shared_ptr<ActiveRenderTarget> target,
+                                     uint32_t pool = 0) {
+        ZoneScoped;
+        if (target->CmdList != nullptr) {
+            return; // nothing to do
+        }
+
+        target->CmdList = &s_Data->GraphicsQueue->RT_Get(pool);
+        target->CmdList->RT_Begin();
+
+        target->Target->RT_BeginRender(*target->CmdList, s_ClearColor);
+    }
+
+    static void RT_EndRenderTarget(std::shared_ptr<ActiveRenderTarget> target) {
+        ZoneScoped;
+
+        if (target->Target->GetType() == RenderTargetType::Framebuffer) {
+            auto framebuffer = target->Target.As<Framebuffer>();
+            framebuffer->RT_EndRender(*target->CmdList, target->Usage.ReadAttachments);
+        } else {
+            target->Target->RT_EndRender(*target->CmdList);
+        }
+
+        if (target->Target->GetType() == RenderTargetType::Swapchain) {
+            s_Data->API->RT_PrePresent(*target->CmdList);
+        }
+
+        auto fence = target->Target->GetCurrentFence();
+        if (fence.IsPresent()) {
+            fence->Reset();
+        }
+
+        target->CmdList->RT_End();
+        s_Data->GraphicsQueue->RT_Submit(*target->CmdList, fence);
+
+        // presentation waits on what was just submitted
+        if (target->Target->GetType() == RenderTargetType::Swapchain) {
+            RT_FlushQueues();
+        }
+
+        target->CmdList = nullptr;
+        target->Target->RT_EndFrame();
+    }
+
+    static void RT_PushRenderTarget(std::shared_ptr<ActiveRenderTarget> target) {
+        ZoneScoped;
+
+        if (target->Target->GetType() == RenderTargetType::Swapchain) {
+            RT_BeginRenderTarget(target);
+        }
+    }
+
+    static void RT_ExecuteCommands(const std::shared_ptr<ActiveRenderTarget>& target);
+
+    static void RT_PopRenderTarget(std::shared_ptr<ActiveRenderTarget> target) {
+        ZoneScoped;
+
+        if (!target->RenderLabels.empty()) {
+            throw std::runtime_error(
+                "Not all render labels have been pushed from this render target!");
+        }
+
+        if (target->CmdList != nullptr) {
+            RT_EndRenderTarget(target);
+        }
+    }
+
+    static bool CanRecordInParallel(const std::shared_ptr<ActiveRenderTarget>& target) {
+        ZoneScoped;
+
+        // swapchains are begun as soon as they are pushed, and must acquire on the render thread
+        // targets sampling earlier ones wait for those to signal before binding their attachments
+        return target->Target->GetType() == RenderTargetType::Framebuffer &&
+               target->CmdList == nullptr && target->FirstCommand != nullptr &&
+               !target->Usage.ReadsPreviousTargets && JobSystem::GetWorkerCount() > 0;
+    }
+
+    static void RT_RecordInParallel(const std::shared_ptr<ActiveRenderTarget>& target) {
+        ZoneScoped;
+
+        // pool 0 belongs to the render thread
+        // pools are only reused after a flush, so no two jobs ever share one
+        auto pool = (uint32_t)s_Data->PendingRecordings.size() + 1;
+        RT_BeginRenderTarget(target, pool);
+
+        auto& pending = s_Data->PendingRecordings.emplace_back();
+        pending.Target = target;
+        pending.Counter = JobSystem::Submit([target]() { RT_ExecuteCommands(target); });
+    }
+
+    static void RT_FlushRecordings() {
+        ZoneScoped;
+
+        for (const auto& pending : s_Data->PendingRecordings) {
+            JobSystem::Wait(pending.Counter);
+            RT_PopRenderTarget(pending.Target);
+        }
+
+        s_Data->PendingRecordings.clear();
+    }
+
+    void Renderer::NewFrame() {
+        ZoneScoped;
+
+        if (!s_Data->Targets.empty()) {
+            throw std::runtime_error(
+                "Must close all render targets before initiating a new frame!");
+        }
+
+        // uploads staged outside of any render target go out with the frame they were staged in
+        FlushUniformUploads();
+
+        // targets recorded in parallel read from this frame's arena until their jobs finish, after
+        // the render thread has already moved on
+        Renderer::Submit([]() { RT_FlushRecordings(); }, "Flush recordings");
+        s_Data->ArenaJobs[GetCurrentFrame()] = s_Data->RenderThread.Submitted.load();
+
+        auto& stats = s_Data->Statistics;
+        stats.CommandMemory = s_Data->CommandArenas[GetCurrentFrame()]->GetUsedSize();
+
+        uint64_t submitCount = GetQueueSubmitCount();
+        stats.QueueSubmits = (uint32_t)(submitCount - s_Data->SubmitCount);
+        s_Data->SubmitCount = submitCount;
+
+        BindCounts binds;
+        binds.Pipelines = s_Data->PipelineBinds.load();
+        binds.Buffers = s_Data->BufferBinds.load();
+        binds.Resources = s_Data->ResourceBinds.load();
+
+        const auto& lastBinds = s_Data->LastBindCounts;
+        stats.PipelineBinds = (uint32_t)(binds.Pipelines - lastBinds.Pipelines);
+        stats.BufferBinds = (uint32_t)(binds.Buffers - lastBinds.Buffers);
+        stats.ResourceBinds = (uint32_t)(binds.Resources - lastBinds.Resources);
+        s_Data->LastBindCounts = binds;
+
+        auto descriptors = s_Data->API->GetDescriptorCounts();
+        const auto& lastDescriptors = s_Data->LastDescriptorCounts;
+        stats.DescriptorSetAllocations =
+            (uint32_t)(descriptors.SetAllocations - lastDescriptors.SetAllocations);
+        stats.DescriptorSetUpdates =
+            (uint32_t)(descriptors.SetUpdates - lastDescriptors.SetUpdates);
+        stats.CachedDescriptorSets = descriptors.CachedSets;
+        stats.DescriptorPools = descriptors.Pools;
+
+        auto& pendingPipelines = s_Data->PendingPipelines;
+        auto compiled =
+            std::remove_if(pendingPipelines.begin(), pendingPipelines.end(),
+                           [](const Ref<Pipeline>& pipeline) { return pipeline->IsReady(); });
+
+        stats.PipelinesCompiled = (uint32_t)(pendingPipelines.end() - compiled);
+        pendingPipelines.erase(compiled, pendingPipelines.end());
+        stats.PipelinesPending = (uint32_t)pendingPipelines.size();
+        s_Data->LastDescriptorCounts = descriptors;
+
+        s_Data->LastStatistics = stats;
+        stats = {};
+
+        // throttle if the render thread is more than FrameLead frames behind
+        auto& frameJobs = s_Data->FrameJobs;
+        frameJobs.push(s_Data->RenderThread.Submitted.load());
+
+        auto waitStart = RenderClock::now();
+        while (frameJobs.size() > s_Data->FrameLead) {
+            WaitForJobs(frameJobs.front(), {});
+            frameJobs.pop();
+        }
+
+        stats.LeadWaitTime = std::chrono::duration_cast<Duration>(RenderClock::now() - waitStart);
+
+        uint32_t frame;
+        if (s_Data->CurrentFrame.has_value()) {
+            frame = s_Data->CurrentFrame.value();
+
+            frame++;
+            frame %= s_Data->FrameCount;
+
+            s_Data->CurrentFrame = frame;
+        } else {
+            s_Data->CurrentFrame = frame = 0;
+        }
+
+        // the render thread may still be reading from this arena
+        WaitForJobs(s_Data->ArenaJobs[frame], {});
+        s_Data->CommandArenas[frame]->Reset();
+        s_Data->Instances[frame].Count = 0;
+        ResetFrameUniforms(frame);
+
+        Renderer::Submit([frame]() { RT_NewFrame(frame); }, "New frame");
+    }
+
+    void Renderer::PushRenderTarget(Ref<RenderTarget> target) {
+        ZoneScoped;
+
+        PushRenderTarget(target, TargetUsage());
+    }
+
+    void Renderer::PushRenderTarget(Ref<RenderTarget> target, const TargetUsage& usage) {
+        ZoneScoped;
+
+        auto newTarget = std::make_shared<ActiveRenderTarget>();
+        newTarget->Target = target;
+        newTarget->Usage = usage;
+        newTarget->CmdList = nullptr;
+        newTarget->ResetViewport = true;
+        newTarget->Arena = s_Data->CommandArenas[GetCurrentFrame()].get();
+        newTarget->FirstCommand = newTarget->LastCommand = nullptr;
+        newTarget->FirstUpload = newTarget->LastUpload = nullptr;
+
+        s_Data->Targets.push(newTarget);
+        Renderer::Submit([=]() { RT_PushRenderTarget(newTarget); }, "Push render target");
+    }
+
+    void Renderer::PopRenderTarget() {
+        ZoneScoped;
+
+        if (s_Data->Targets.empty()) {
+            return;
+        }
+
+        // uniforms written while recording this target must land before it is submitted
+        FlushUniformUploads();
+
+        auto target = s_Data->Targets.top();
+        Renderer::Submit(
+            [target]() {
+                if (CanRecordInParallel(target)) {
+                    RT_RecordInParallel(target);
+                    return;
+                }
+
+                // keep submission order
+                RT_FlushRecordings();
+
+                RT_ExecuteCommands(target);
+                RT_PopRenderTarget(target);
+            },
+            "Pop render target");
+
+        s_Data->ArenaJobs[GetCurrentFrame()] = s_Data->RenderThread.Submitted.load();
+        s_Data->Targets.pop();
+    }
+
+    Ref<RenderTarget> Renderer::GetActiveRenderTarget() {
+        ZoneScoped;
+
+        if (s_Data->Targets.empty()) {
+            return nullptr;
+        }
+
+        return s_Data->Targets.top()->Target;
+    }
+
+    template <typename _Ty>
+    static _Ty* RecordCommand(ActiveRenderTarget& target, RenderCommandType type) {
+        auto command = target.Arena->Allocate<_Ty>();
+        command->Type = type;
+        command->Next = nullptr;
+
+        if (target.LastCommand != nullptr) {
+            target.LastCommand->Next = command;
+        } else {
+            target.FirstCommand = command;
+        }
+
+        target.LastCommand = command;
+        return command;
+    }
+
+    template <typename _Ty>
+    static const uint32_t* InternObjects(CommandArena& arena,
+                                         const std::vector<Ref<_Ty>>& objects) {
+        auto handles = arena.Allocate<uint32_t>(objects.size());
+        for (size_t i = 0; i < objects.size(); i++) {
+            handles[i] = arena.Intern(objects[i]);
+        }
+
+        return handles;
+    }
+
+    static void RT_RenderIndexed(const CommandArena& arena, const DrawCommand& command,
+                                 const std::shared_ptr<ActiveRenderTarget>& target) {
+        ZoneScoped;
+
+        RT_BeginRenderTarget(target);
+
+        auto& call = s_DecodedCall;
+        call.Flip = command.HasFlip ? std::optional<bool>(command.Flip) : std::nullopt;
+        call.ScissorRect =
+            command.HasScissor ? std::optional<Scissor>(command.ScissorRect) : std::nullopt;
+
+        // the previous call still holds what was bound by the last draw in this command list
+        auto pipeline = arena.Get<Pipeline>(command.Pipeline);
+        auto indexBuffer = arena.Get<DeviceBuffer>(command.IndexBuffer);
+
+        // descriptor sets stay bound across pipelines with the same layout
+        bool sameLayout = false;
+        if (call.RenderPipeline.IsPresent() && pipeline != nullptr) {
+            sameLayout = call.RenderPipeline->GetSpec().PipelineShader ==
+                         pipeline->GetSpec().PipelineShader;
+        }
+
+        call.BindPipeline = call.RenderPipeline.Raw() != pipeline;
+        call.BindIndexBuffer = call.IndexBuffer.Raw() != indexBuffer;
+        call.BindVertexBuffers = call.VertexBuffers.size() != command.VertexBufferCount;
+
+        call.VertexBuffers.resize(command.VertexBufferCount);
+        for (uint32_t i = 0; i < command.VertexBufferCount; i++) {
+            auto buffer = arena.Get<DeviceBuffer>(command.VertexBuffers[i]);
+            if (call.VertexBuffers[i].Raw() != buffer) {
+                call.VertexBuffers[i].Reset(buffer);
+                call.BindVertexBuffers = true;
+            }
+        }
+
+        auto& counts = s_BindCounts;
+        call.BoundResources = 0;
+
+        // a resource bound at another offset is bound again
+        const uint32_t* lastOffsets = call.DynamicOffsets;
+        const uint32_t* offsets = command.DynamicOffsets;
+        call.DynamicOffsets = command.DynamicOffsets;
+
+        call.Resources.resize(command.ResourceCount);
+        for (uint32_t i = 0; i < command.ResourceCount; i++) {
+            auto resource = arena.Get<RendererAllocation>(command.Resources[i]);
+            uint32_t lastOffsetCount = 0;
+            if (call.Resources[i].IsPresent()) {
+                lastOffsetCount = call.Resources[i]->GetDynamicOffsetCount();
+            }
+
+            bool bound = resource != nullptr && call.Resources[i].Raw() == resource;
+            if (bound && lastOffsetCount > 0) {
+                bound = std::memcmp(lastOffsets, offsets, lastOffsetCount * sizeof(uint32_t)) == 0;
+            }
+
+            lastOffsets += lastOffsetCount;
+            if (resource != nullptr) {
+                offsets += resource->GetDynamicOffsetCount();
+            }
+
+            if (sameLayout && bound && i < 32) {
+                call.BoundResources |= 1u << i;
+                continue;
+            }
+
+            call.Resources[i].Reset(resource);
+            if (resource != nullptr) {
+                counts.Resources++;
+            }
+        }
+
+        if (call.BindPipeline) {
+            call.RenderPipeline.Reset(pipeline);
+            counts.Pipelines++;
+        }
+
+        if (call.BindIndexBuffer) {
+            call.IndexBuffer.Reset(indexBuffer);
+            counts.Buffers++;
+        }
+
+        if (call.BindVertexBuffers) {
+            counts.Buffers++;
+        }
+
+        call.VertexOffset = command.VertexOffset;
+        call.IndexOffset = command.IndexOffset;
+        call.IndexCount = command.IndexCount;
+        call.FirstInstance = command.FirstInstance;
+        call.InstanceCount = command.InstanceCount;
+        call.PushConstants =
+            Buffer::Wrapper((void*)command.PushConstants, command.PushConstantSize);
+
+        bool customViewport = call.Flip.has_value() || call.ScissorRect.has_value();
+        if (target->ResetViewport || customViewport) {
+            s_Data->API->RT_SetViewport(*target->CmdList, target->Target, call.Flip,
+                                        call.ScissorRect);
+
+            target->ResetViewport = customViewport;
+        }
+
+        s_Data->API->RT_RenderIndexed(*target->CmdList, call);
+    }
+
+    // blended draws depend on what was drawn behind them, so they cannot be grouped by state
+    static bool IsBlended(const Pipeline* pipeline) {
+        if (pipeline == nullptr) {
+            return false;
+        }
+
+        const auto& spec = pipeline->GetSpec();
+        if (spec.Blending == ColorBlending::None || spec.Target.IsEmpty()) {
+            return false;
+        }
+
+        if (spec.Target->GetType() != RenderTargetType::Framebuffer) {
+            return true;
+        }
+
+        const auto& attachments = spec.Target.As<Framebuffer>()->GetSpec().Attachments;
+        for (const auto& attachment : attachments) {
+            if (attachment.Type == Framebuffer::AttachmentType::Color) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // the top bit is set for blended draws, so that they are drawn after everything opaque
+    // opaque: pipeline (15 bits), first resource, index buffer and depth (16 bits each)
+    // blended: inverted depth (31 bits), then pipeline and first resource (16 bits each)
+    // draws are already recorded per target, so the target needs no bits of its own
+    static uint64_t GetSortKey(const CommandArena& arena, const DrawCommand& command,
+                               float depth) {
+        auto pipeline = arena.Get<Pipeline>(command.Pipeline);
+        auto indexBuffer = arena.Get<DeviceBuffer>(command.IndexBuffer);
+
+        const RendererAllocation* resource = nullptr;
+        if (command.ResourceCount > 0) {
+            resource = arena.Get<RendererAllocation>(command.Resources[0]);
+        }
+
+        // ids rather than arena handles, as the same object may be interned under several
+        uint64_t pipelineID = pipeline != nullptr ? pipeline->GetID() & 0xFFFF : 0;
+        uint64_t resourceID = resource != nullptr ? resource->GetID() & 0xFFFF : 0;
+        uint64_t indexBufferID = indexBuffer != nullptr ? indexBuffer->GetID() & 0xFFFF : 0;
+
+        // non-negative floats order the same as their bit patterns, and leave the sign bit clear
+        float clampedDepth = depth > 0.f ? depth : 0.f;
+        uint32_t depthBits;
+        std::memcpy(&depthBits, &clampedDepth, sizeof(float));
+
+        if (IsBlended(pipeline)) {
+            // back to front
+            uint64_t invertedDepth = ~depthBits & 0x7FFFFFFF;
+            return (1ull << 63) | (invertedDepth << 32) | (pipelineID << 16) | resourceID;
+        }
+
+        return ((pipelineID & 0x7FFF) << 48) | (resourceID << 32) | (indexBufferID << 16) |
+               (uint64_t)(depthBits >> 16);
+    }
+
+    // records a draw with nothing but its pipeline set
+    // callers write everything else straight into the arena, so that recording does not allocate
+    static DrawCommand* RecordDraw(ActiveRenderTarget& target, const Ref<Pipeline>& pipeline) {
+        ZoneScoped;
+
+        auto command = RecordCommand<DrawCommand>(target, RenderCommandType::Draw);
+        command->HasFlip = command->Flip = command->HasScissor = false;
+        command->ScissorRect = Scissor{};
+
+        command->Pipeline = target.Arena->Intern(pipeline);
+        command->IndexBuffer = CommandArena::NullHandle;
+        command->VertexOffset = 0;
+        command->IndexOffset = command->IndexCount = 0;
+        command->FirstInstance = 0;
+        command->InstanceCount = 1;
 
-        auto texture = s_Data->Context->CreateTexture(textureSpec);
-        UpdateTexture(texture, data, scissor);
+        command->VertexBufferCount = command->ResourceCount = 0;
+        command->VertexBuffers = command->Resources = nullptr;
 
-        return texture;
+        command->DynamicOffsetCount = 0;
+        command->DynamicOffsets = nullptr;
+
+        command->PushConstantSize = 0;
+        command->PushConstants = nullptr;
+
+        return command;
     }
 
-    void Renderer::UpdateTexture(const Ref<Texture>& texture, const Buffer& data,
-                                 const Scissor& scissor) {
+    // called once the draw's resources are written, as they are part of its sort key
+    // the resources' dynamic offsets are copied now, as they may be rebound before the render
+    // thread gets to the draw
+    static void FinishDraw(CommandArena& arena, DrawCommand& command,
+                           const std::optional<float>& depth) {
         ZoneScoped;
 
-        DeviceBuffer::Spec stagingSpec;
-        stagingSpec.QueueOwnership = { QueueType::Transfer };
-        stagingSpec.Size = data.GetSize();
-        stagingSpec.BufferUsage = DeviceBuffer::Usage::Staging;
+        uint32_t offsetCount = 0;
+        for (uint32_t i = 0; i < command.ResourceCount; i++) {
+            auto resource = arena.Get<RendererAllocation>(command.Resources[i]);
+            if (resource != nullptr) {
+                offsetCount += resource->GetDynamicOffsetCount();
+            }
+        }
 
-        auto loadInfo = new TextureLoadInfo;
-        loadInfo->StagingBuffer = s_Data->Context->CreateBuffer(stagingSpec);
-        loadInfo->Instance = texture;
-        loadInfo->ImageData = data;
-        loadInfo->CopyRect = scissor;
-        loadInfo->Layer = 0;
+        if (offsetCount > 0) {
+            auto offsets = arena.Allocate<uint32_t>(offsetCount);
+            command.DynamicOffsetCount = offsetCount;
+            command.DynamicOffsets = offsets;
 
-        Renderer::Submit([loadInfo]() {
-            RT_LoadTextureData(loadInfo);
-            delete loadInfo;
-        });
+            for (uint32_t i = 0; i < command.ResourceCount; i++) {
+                auto resource = arena.Get<RendererAllocation>(command.Resources[i]);
+                if (resource != nullptr) {
+                    resource->GetDynamicOffsets(offsets);
+                    offsets += resource->GetDynamicOffsetCount();
+                }
+            }
+        }
+
+        command.Sortable = depth.has_value();
+        command.SortKey = command.Sortable ? GetSortKey(arena, command, depth.value()) : 0;
+
+        auto& stats = s_Data->Statistics;
+        stats.DrawCalls++;
+        stats.DrawnInstances += command.InstanceCount;
     }
 
-    void Renderer::Submit(const std::function<void()>& callback,
-                          const std::optional<std::string>& label) {
-        auto jobLabel = label.value_or("<unnamed render task>");
-        if (IsRenderThread()) {
-            FUUJIN_TRACE("Render thread: inline sub-job {}", jobLabel.c_str());
-            callback();
+    void Renderer::RenderIndexed(const IndexedRenderCall& data) {
+        ZoneScoped;
 
+        if (!data.RenderPipeline->IsReady()) {
+            s_Data->Statistics.SkippedDraws++;
             return;
         }
 
-        QueueCallback data;
-        data.Callback = callback;
-        data.Label = jobLabel;
+        uint64_t allocations = GetThreadAllocationCount();
 
-        std::lock_guard lock(s_Data->RenderThread.Mutex);
-        s_Data->RenderThread.Queue.push(data);
-    }
+        auto& target = *s_Data->Targets.top();
+        auto& arena = *target.Arena;
+        auto command = RecordDraw(target, data.RenderPipeline);
 
-    bool Renderer::Wait(std::optional<std::chrono::milliseconds> timeout) {
-        FUUJIN_TRACE("Waiting for render queue to finish...");
-        spdlog::stopwatch timer;
+        command->HasFlip = data.Flip.has_value();
+        command->Flip = data.Flip.value_or(false);
+        command->HasScissor = data.ScissorRect.has_value();
+        command->ScissorRect = data.ScissorRect.value_or(Scissor{});
 
-        while (true) {
-            {
-                std::lock_guard lock(s_Data->RenderThread.Mutex);
-                if (s_Data->RenderThread.Queue.empty()) {
-                    break;
-                }
-            }
+        command->IndexBuffer = arena.Intern(data.IndexBuffer);
+        command->VertexOffset = data.VertexOffset;
+        command->IndexOffset = data.IndexOffset;
+        command->IndexCount = data.IndexCount;
+        command->FirstInstance = data.FirstInstance;
+        command->InstanceCount = data.InstanceCount;
 
-            auto elapsed = timer.elapsed_ms();
-            if (timeout.has_value() && elapsed >= timeout.value()) {
-                FUUJIN_WARN("Waited {} to clear render queue - timed out", elapsed);
-                return false;
-            }
+        command->VertexBufferCount = (uint32_t)data.VertexBuffers.size();
+        command->VertexBuffers = InternObjects(arena, data.VertexBuffers);
+        command->ResourceCount = (uint32_t)data.Resources.size();
+        command->Resources = InternObjects(arena, data.Resources);
+
+        if (data.PushConstants) {
+            void* pushConstants = arena.Allocate(data.PushConstants.GetSize());
+            std::memcpy(pushConstants, data.PushConstants.Get(), data.PushConstants.GetSize());
 
-            std::this_thread::sleep_for(1ms);
+            command->PushConstantSize = data.PushConstants.GetSize();
+            command->PushConstants = pushConstants;
         }
 
-        FUUJIN_TRACE("Waited {} to clear render queue", timer.elapsed_ms());
-        return true;
+        FinishDraw(arena, *command, data.Depth);
+        s_Data->Statistics.DrawAllocations += GetThreadAllocationCount() - allocations;
     }
 
-    bool Renderer::IsRenderThread() {
-        ZoneScoped;
+    // see assets/shaders/include/StaticVertex.glsl
+    static const std::string s_InstanceBufferName = "Instances";
 
-        return std::this_thread::get_id() == s_Data->RenderThread.ID;
-    }
+    // a MaterialRenderCall that borrows its containers instead of owning them, so that RenderModel
+    // records draws without copying vectors or building push constant maps
+    struct MaterialDraw {
+        const std::vector<Ref<DeviceBuffer>>* VertexBuffers;
+        Ref<DeviceBuffer> IndexBuffer;
+        Ref<Pipeline> RenderPipeline;
+        uint32_t IndexCount, FirstInstance, InstanceCount;
 
-    static void RT_NewFrame(uint32_t frame) {
-        ZoneScoped;
+        glm::mat4 ModelMatrix;
+        size_t FirstCamera, CameraCount;
+        uint32_t CameraMask;
+        bool LayeredCameras;
 
-        s_Data->API->RT_NewFrame(frame);
-    }
+        uint64_t SceneID;
+        Ref<Material> RenderMaterial;
+
+        // either may be null
+        const std::vector<Ref<RendererAllocation>>* AdditionalResources;
+        Ref<RendererAllocation> MeshResource;
+
+        const std::unordered_map<std::string, Buffer>* PushConstants;
+        std::optional<int32_t> BoneOffset;
+    };
 
-    static void RT_BeginRenderTarget(std::shared_ptr<ActiveRenderTarget> target) {
+    static void RecordMaterialDraw(const MaterialDraw& data) {
         ZoneScoped;
-        if (target->CmdList != nullptr) {
-            return; // nothing to do
-        }
 
-        target->CmdList = &s_Data->GraphicsQueue->RT_Get();
-        target->CmdList->RT_Begin();
+        if (!data.RenderPipeline->IsReady()) {
+            s_Data->Statistics.SkippedDraws++;
+            return;
+        }
 
-        target->Target->RT_BeginRender(*target->CmdList, glm::vec4(glm::vec3(0.1f), 1.f));
-    }
+        uint32_t firstInstance = data.FirstInstance;
+        uint32_t instanceCount = data.InstanceCount;
 
-    static void RT_EndRenderTarget(std::shared_ptr<ActiveRenderTarget> target) {
-        ZoneScoped;
+        // see assets/shaders/include/VertexOutput.glsl
+        // the instance index is divided back down by the shader, so merged draws stay mergeable
+        if (data.LayeredCameras) {
+            uint32_t cameraMask = data.CameraMask;
+            if (data.CameraCount < 32) {
+                cameraMask &= (1u << (uint32_t)data.CameraCount) - 1;
+            }
 
-        target->Target->RT_EndRender(*target->CmdList);
+            auto visibleCameras = (uint32_t)std::popcount(cameraMask);
+            if (visibleCameras == 0) {
+                return;
+            }
 
-        if (target->Target->GetType() == RenderTargetType::Swapchain) {
-            s_Data->API->RT_PrePresent(*target->CmdList);
+            firstInstance *= visibleCameras;
+            instanceCount *= visibleCameras;
+            s_Data->Statistics.LayeredDraws++;
         }
 
-        auto fence = target->Target->GetCurrentFence();
-        if (fence.IsPresent()) {
-            fence->Reset();
-        }
+        const auto& shader = data.RenderPipeline->GetSpec().PipelineShader;
+        auto materialAllocation = Renderer::GetMaterialAllocation(data.RenderMaterial, shader);
+        auto sceneAllocation = Renderer::GetSceneAllocation(data.SceneID, shader);
 
-        target->CmdList->RT_End();
-        s_Data->GraphicsQueue->RT_Submit(*target->CmdList, fence);
+        auto& target = *s_Data->Targets.top();
+        auto& arena = *target.Arena;
+        auto command = RecordDraw(target, data.RenderPipeline);
 
-        target->CmdList = nullptr;
-        target->Target->RT_EndFrame();
-    }
+        command->IndexBuffer = arena.Intern(data.IndexBuffer);
+        command->IndexCount = data.IndexCount;
+        command->FirstInstance = firstInstance;
+        command->InstanceCount = instanceCount;
 
-    static void RT_PushRenderTarget(std::shared_ptr<ActiveRenderTarget> target) {
-        ZoneScoped;
+        command->VertexBufferCount = (uint32_t)data.VertexBuffers->size();
+        command->VertexBuffers = InternObjects(arena, *data.VertexBuffers);
 
-        if (target->Target->GetType() == RenderTargetType::Swapchain) {
-            RT_BeginRenderTarget(target);
+        size_t maxResources = 4;
+        if (data.AdditionalResources != nullptr) {
+            maxResources += data.AdditionalResources->size();
         }
-    }
 
-    static void RT_PopRenderTarget(std::shared_ptr<ActiveRenderTarget> target) {
-        ZoneScoped;
+        auto resources = arena.Allocate<uint32_t>(maxResources);
+        uint32_t resourceCount = 0;
 
-        if (!target->RenderLabels.empty()) {
-            throw std::runtime_error(
-                "Not all render labels have been pushed from this render target!");
-        }
+        resources[resourceCount++] = arena.Intern(materialAllocation);
+        resources[resourceCount++] = arena.Intern(sceneAllocation);
 
-        if (target->CmdList != nullptr) {
-            RT_EndRenderTarget(target);
+        // the same for every draw with the shader, so only bound once in a row of them
+        if (shader->GetResourceByName(s_BindlessTableName)) {
+            resources[resourceCount++] = arena.Intern(GetTableAllocation(shader));
         }
-    }
 
-    void Renderer::NewFrame() {
-        ZoneScoped;
+        if (data.AdditionalResources != nullptr) {
+            for (const auto& allocation : *data.AdditionalResources) {
+                resources[resourceCount++] = arena.Intern(allocation);
+            }
+        }
 
-        if (!s_Data->Targets.empty()) {
-            throw std::runtime_error(
-                "Must close all render targets before initiating a new frame!");
+        if (data.MeshResource.IsPresent()) {
+            resources[resourceCount++] = arena.Intern(data.MeshResource);
         }
 
-        uint32_t frame;
-        if (s_Data->CurrentFrame.has_value()) {
-            frame = s_Data->CurrentFrame.value();
+        command->ResourceCount = resourceCount;
+        command->Resources = resources;
 
-            frame++;
-            frame %= s_Data->FrameCount;
+        auto pushConstants = shader->GetPushConstants();
+        if (pushConstants) {
+            auto type = pushConstants->GetType();
+            size_t size = type->GetSize();
 
-            s_Data->CurrentFrame = frame;
+            void* pushConstantData = arena.Allocate(size);
+            std::memset(pushConstantData, 0, size);
+
+            ShaderBuffer buffer(Buffer::Wrapper(pushConstantData, size), type);
+
+            // see assets/shaders/include/Renderer.glsl
+            buffer.Set("Model", data.ModelMatrix);
+            buffer.Set("FirstCamera", (int32_t)data.FirstCamera);
+            buffer.Set("CameraCount", (int32_t)data.CameraCount);
+            buffer.Set("CameraMask", (int32_t)data.CameraMask);
+
+            if (data.BoneOffset.has_value()) {
+                buffer.Set("BoneOffset", data.BoneOffset.value());
+            }
+
+            if (data.PushConstants != nullptr) {
+                for (const auto& [name, fieldData] : *data.PushConstants) {
+                    buffer.SetData(name, fieldData);
+                }
+            }
+
+            command->PushConstantSize = size;
+            command->PushConstants = pushConstantData;
         } else {
-            s_Data->CurrentFrame = frame = 0;
+            FUUJIN_WARN("No push constants on shader! Cannot pass model matrix or camera indices!");
         }
 
-        Renderer::Submit([frame]() { RT_NewFrame(frame); }, "New frame");
+        // front to back from the first camera; squared distance sorts the same
+        float depth = 0.f;
+        auto scene = s_Data->SceneState.find(data.SceneID);
+        if (scene != s_Data->SceneState.end()) {
+            const auto& cameras = scene->second.Data.Cameras;
+            if (data.FirstCamera < cameras.size()) {
+                auto offset = glm::vec3(data.ModelMatrix[3]) - cameras[data.FirstCamera].Position;
+                depth = glm::dot(offset, offset);
+            }
+        }
+
+        FinishDraw(arena, *command, depth);
     }
 
-    void Renderer::PushRenderTarget(Ref<RenderTarget> target) {
+    void Renderer::RenderWithMaterial(const MaterialRenderCall& data) {
         ZoneScoped;
 
-        auto newTarget = std::make_shared<ActiveRenderTarget>();
-        newTarget->Target = target;
-        newTarget->CmdList = nullptr;
-        newTarget->ResetViewport = true;
-
-        s_Data->Targets.push(newTarget);
-        Renderer::Submit([=]() { RT_PushRenderTarget(newTarget); }, "Push render target");
+        uint64_t allocations = GetThreadAllocationCount();
+
+        MaterialDraw draw;
+        draw.VertexBuffers = &data.VertexBuffers;
+        draw.IndexBuffer = data.IndexBuffer;
+        draw.RenderPipeline = data.RenderPipeline;
+        draw.IndexCount = data.IndexCount;
+        draw.FirstInstance = data.FirstInstance;
+        draw.InstanceCount = data.InstanceCount;
+        draw.ModelMatrix = data.ModelMatrix;
+        draw.FirstCamera = data.FirstCamera;
+        draw.CameraCount = data.CameraCount;
+        draw.CameraMask = data.CameraMask;
+        draw.LayeredCameras = data.LayeredCameras;
+        draw.SceneID = data.SceneID;
+        draw.RenderMaterial = data.RenderMaterial;
+        draw.AdditionalResources = &data.AdditionalResources;
+        draw.PushConstants = &data.PushConstants;
+
+        RecordMaterialDraw(draw);
+        s_Data->Statistics.DrawAllocations += GetThreadAllocationCount() - allocations;
     }
 
-    void Renderer::PopRenderTarget() {
-        ZoneScoped;
+    static constexpr uint32_t s_MinInstanceCapacity = 256;
 
-        if (s_Data->Targets.empty()) {
-            return;
-        }
+    // reserves room in the frame's instance buffer and returns storage for the transforms
+    // the transforms are uploaded right before the active target's commands are executed
+    static glm::mat4* AllocateInstances(uint32_t count, uint32_t& firstInstance) {
+        ZoneScoped;
 
-        auto target = s_Data->Targets.top();
-        Renderer::Submit([target]() { RT_PopRenderTarget(target); }, "Pop render target");
+        auto& target = *s_Data->Targets.top();
+        auto& arena = *target.Arena;
+        auto& instances = s_Data->Instances[Renderer::GetCurrentFrame()];
 
-        s_Data->Targets.pop();
-    }
+        if (instances.Count + count > instances.Capacity) {
+            uint32_t capacity = std::max(s_MinInstanceCapacity, instances.Capacity * 2);
+            while (capacity < instances.Count + count) {
+                capacity *= 2;
+            }
 
-    Ref<RenderTarget> Renderer::GetActiveRenderTarget() {
-        ZoneScoped;
+            DeviceBuffer::Spec spec;
+            spec.QueueOwnership = { QueueType::Graphics };
+            spec.Size = capacity * sizeof(glm::mat4);
+            spec.BufferUsage = DeviceBuffer::Usage::Storage;
 
-        if (s_Data->Targets.empty()) {
-            return nullptr;
+            // sized so that the next frame fits in a single buffer
+            instances.Buffer = s_Data->Context->CreateBuffer(spec);
+            instances.Capacity = capacity;
+            instances.Count = 0;
+            instances.Allocations.clear();
         }
 
-        return s_Data->Targets.top()->Target;
-    }
-
-    static void RT_RenderIndexed(IndexedRenderCall* data,
-                                 std::shared_ptr<ActiveRenderTarget> target) {
-        ZoneScoped;
+        firstInstance = instances.Count;
+        instances.Count += count;
 
-        RT_BeginRenderTarget(target);
+        auto upload = arena.Allocate<InstanceUpload>();
+        upload->Buffer = arena.Intern(instances.Buffer);
+        upload->FirstInstance = firstInstance;
+        upload->InstanceCount = count;
+        upload->Next = nullptr;
 
-        bool customViewport = data->Flip.has_value() || data->ScissorRect.has_value();
-        if (target->ResetViewport || customViewport) {
-            s_Data->API->RT_SetViewport(*target->CmdList, target->Target, data->Flip,
-                                        data->ScissorRect);
+        auto transforms = arena.Allocate<glm::mat4>(count);
+        upload->Transforms = transforms;
 
-            target->ResetViewport = customViewport;
+        if (target.LastUpload != nullptr) {
+            target.LastUpload->Next = upload;
+        } else {
+            target.FirstUpload = upload;
         }
 
-        s_Data->API->RT_RenderIndexed(*target->CmdList, *data);
-        delete data;
+        target.LastUpload = upload;
+        return transforms;
     }
 
-    void Renderer::RenderIndexed(const IndexedRenderCall& data) {
+    static Ref<RendererAllocation> GetInstanceAllocation(const Ref<Shader>& shader) {
         ZoneScoped;
 
-        auto copy = new IndexedRenderCall;
-        *copy = data;
+        auto& instances = s_Data->Instances[Renderer::GetCurrentFrame()];
+        auto& allocation = instances.Allocations[shader->GetID()];
 
-        const auto& renderTarget = s_Data->Targets.top();
-        Renderer::Submit([copy, renderTarget]() { RT_RenderIndexed(copy, renderTarget); });
+        if (allocation.IsEmpty()) {
+            allocation = Renderer::CreateAllocation(shader);
+            allocation->Bind(s_InstanceBufferName, instances.Buffer);
+        }
+
+        return allocation;
     }
 
-    void Renderer::RenderWithMaterial(const MaterialRenderCall& data) {
+    // layered is set if the shader picks its cameras in the vertex stage
+    static Ref<Shader> GetModelShader(ShaderName name, bool skinned, bool& layered) {
         ZoneScoped;
 
-        IndexedRenderCall innerCall;
-        innerCall.VertexBuffers = data.VertexBuffers;
-        innerCall.IndexBuffer = data.IndexBuffer;
-        innerCall.RenderPipeline = data.RenderPipeline;
-        innerCall.IndexCount = data.IndexCount;
-
-        const auto& shader = data.RenderPipeline->GetSpec().PipelineShader;
-        innerCall.Resources = { GetMaterialAllocation(data.RenderMaterial, shader),
-                                GetSceneAllocation(data.SceneID, shader) };
+        uint32_t shaderHash = GetShaderHash(name, skinned);
+        bool bindless = s_Data->Bindless.Enabled && s_BindlessShaders.contains(shaderHash);
+        layered = s_Data->LayeredCameras && s_LayeredShaders.contains(shaderHash);
 
-        for (const auto& allocation : data.AdditionalResources) {
-            innerCall.Resources.push_back(allocation);
+        const std::unordered_map<uint32_t, std::string>* shaders;
+        if (layered) {
+            shaders = bindless ? &s_LayeredBindlessShaders : &s_LayeredShaders;
+        } else {
+            shaders = bindless ? &s_BindlessShaders : &s_RendererShaders;
         }
 
-        auto pushConstants = shader->GetPushConstants();
-        if (pushConstants) {
-            ShaderBuffer buffer(pushConstants->GetType());
+        return s_Data->Library->Get(shaders->at(shaderHash));
+    }
 
-            // see assets/shaders/include/Renderer.glsl
-            buffer.Set("Model", data.ModelMatrix);
-            buffer.Set("FirstCamera", (int32_t)data.FirstCamera);
-            buffer.Set("CameraCount", (int32_t)data.CameraCount);
+    void Renderer::PrewarmModelPipelines(const Ref<Model>& model, const Ref<RenderTarget>& target,
+                                         ShaderName shader) {
+        ZoneScoped;
 
-            for (const auto& [name, fieldData] : data.PushConstants) {
-                buffer.SetData(name, fieldData);
-            }
+        for (const auto& mesh : model->GetMeshes()) {
+            bool isSkinned = !mesh->GetBones().empty();
 
-            innerCall.PushConstants = buffer.GetBuffer().Copy();
-        } else {
-            FUUJIN_WARN("No push constants on shader! Cannot pass model matrix or camera indices!");
-        }
+            bool layered;
+            auto meshShader = GetModelShader(shader, isSkinned, layered);
 
-        RenderIndexed(innerCall);
+            // see RenderModel for why shadow pipelines are not compiled asynchronously
+            const auto& material = mesh->GetMaterial();
+            GetMaterialPipeline(meshShader, target, material->GetPipeline(),
+                                shader == ShaderName::Material);
+        }
     }
 
     void Renderer::RenderModel(const ModelRenderCall& data) {
@@ -1161,10 +2798,21 @@ namespace fuujin {
             return;
         }
 
+        // covers everything below, so that per-draw work outside of the arena is counted too
+        uint64_t allocations = GetThreadAllocationCount();
+
         if (data.ModelAnimator.IsPresent()) {
             data.ModelAnimator->Update();
         }
 
+        const glm::mat4* modelMatrices = &data.ModelMatrix;
+        uint32_t instanceCount = 1;
+
+        if (!data.InstanceMatrices.empty()) {
+            modelMatrices = data.InstanceMatrices.data();
+            instanceCount = (uint32_t)data.InstanceMatrices.size();
+        }
+
         const auto& nodes = data.RenderedModel->GetNodes();
         const auto& meshes = data.RenderedModel->GetMeshes();
         const auto& meshNodes = data.RenderedModel->GetMeshNodes();
@@ -1177,14 +2825,28 @@ namespace fuujin {
                 const auto& mesh = meshes[meshIndex];
 
                 bool isSkinned = !mesh->GetBones().empty();
-                uint32_t shaderHash = GetShaderHash(data.RenderShader, isSkinned);
-                std::string shaderIdentifier = s_RendererShaders.at(shaderHash);
 
+                bool layered;
+                auto shader = GetModelShader(data.RenderShader, isSkinned, layered);
                 const auto& buffers = GetMeshBuffers(mesh);
-                const auto& shader = s_Data->Library->Get(shaderIdentifier);
 
                 const auto& material = mesh->GetMaterial();
-                auto pipeline = GetMaterialPipeline(shader, target, material->GetPipeline());
+                // shadow maps are kept between frames, so they never draw with a missing caster
+                bool async = data.RenderShader == ShaderName::Material;
+                auto pipeline = GetMaterialPipeline(shader, target, material->GetPipeline(), async);
+
+                // drawn with the shader's default pipeline until its own has compiled
+                // the fallback blends the same way, so that the draw sorts the same way
+                if (!pipeline->IsReady()) {
+                    Material::PipelineProperties fallbackSpec{};
+                    fallbackSpec.Blended = material->GetPipeline().Blended;
+
+                    auto fallback = GetMaterialPipeline(shader, target, fallbackSpec, async);
+                    if (fallback->IsReady()) {
+                        pipeline = fallback;
+                        s_Data->Statistics.FallbackDraws++;
+                    }
+                }
 
                 glm::mat4 nodeTransform(1.f);
                 if (data.ModelAnimator.IsPresent()) {
@@ -1200,16 +2862,40 @@ namespace fuujin {
                     }
                 }
 
-                MaterialRenderCall innerCall;
-                innerCall.VertexBuffers = buffers.VertexBuffers;
+                MaterialDraw innerCall;
+                innerCall.VertexBuffers = &buffers.VertexBuffers;
                 innerCall.IndexBuffer = buffers.IndexBuffer;
                 innerCall.IndexCount = (uint32_t)mesh->GetIndices().size();
+                innerCall.FirstInstance = 0;
+                innerCall.InstanceCount = 1;
                 innerCall.RenderMaterial = material;
                 innerCall.RenderPipeline = pipeline;
                 innerCall.SceneID = data.SceneID;
-                innerCall.ModelMatrix = data.ModelMatrix * nodeTransform;
                 innerCall.FirstCamera = data.FirstCamera;
                 innerCall.CameraCount = data.CameraCount;
+                innerCall.CameraMask = data.CameraMask;
+                innerCall.LayeredCameras = layered;
+                innerCall.AdditionalResources = nullptr;
+                innerCall.PushConstants = nullptr;
+
+                // static meshes read their transforms from the instance buffer
+                // every instance of the mesh is drawn at once
+                if (!isSkinned && shader->GetResourceByName(s_InstanceBufferName)) {
+                    uint32_t firstInstance;
+                    auto transforms = AllocateInstances(instanceCount, firstInstance);
+
+                    for (uint32_t i = 0; i < instanceCount; i++) {
+                        transforms[i] = modelMatrices[i] * nodeTransform;
+                    }
+
+                    innerCall.ModelMatrix = transforms[0];
+                    innerCall.FirstInstance = firstInstance;
+                    innerCall.InstanceCount = instanceCount;
+                    innerCall.MeshResource = GetInstanceAllocation(shader);
+
+                    RecordMaterialDraw(innerCall);
+                    continue;
+                }
 
                 if (isSkinned) {
                     if (data.ModelAnimator.IsEmpty()) {
@@ -1218,30 +2904,31 @@ namespace fuujin {
                     } else {
                         const auto& boneOffsets = data.ModelAnimator->GetArmatureOffsets();
 
-                        auto allocation = GetAnimatorAllocation(data.ModelAnimator, shader);
-                        innerCall.AdditionalResources.push_back(allocation);
+                        innerCall.MeshResource = GetAnimatorAllocation(data.ModelAnimator, shader);
 
                         size_t armature = mesh->GetArmatureIndex();
-                        int32_t boneOffset = (int32_t)boneOffsets[armature];
-
-                        innerCall.PushConstants["BoneOffset"] =
-                            Buffer::CreateCopy(&boneOffset, sizeof(int32_t));
+                        innerCall.BoneOffset = (int32_t)boneOffsets[armature];
                     }
                 }
 
-                RenderWithMaterial(innerCall);
+                for (uint32_t i = 0; i < instanceCount; i++) {
+                    innerCall.ModelMatrix = modelMatrices[i] * nodeTransform;
+                    RecordMaterialDraw(innerCall);
+                }
             }
         }
+
+        s_Data->Statistics.DrawAllocations += GetThreadAllocationCount() - allocations;
     }
 
-    static void RT_PushRenderLabel(const std::string& label,
+    static void RT_PushRenderLabel(const char* label,
                                    const std::shared_ptr<ActiveRenderTarget>& target) {
         ZoneScoped;
 
         RT_BeginRenderTarget(target);
 
         target->RenderLabels.push(label);
-        s_Data->API->RT_BeginRenderLabel(*target->CmdList, label);
+        s_Data->API->RT_BeginRenderLabel(*target->CmdList, target->RenderLabels.top());
     }
 
     bool Renderer::PushRenderLabel(const std::string& label) {
@@ -1251,8 +2938,9 @@ namespace fuujin {
             return false;
         }
 
-        auto target = s_Data->Targets.top();
-        Renderer::Submit([label, target]() { RT_PushRenderLabel(label, target); });
+        auto& target = *s_Data->Targets.top();
+        auto command = RecordCommand<LabelCommand>(target, RenderCommandType::PushLabel);
+        command->Label = target.Arena->CopyString(label);
 
         return true;
     }
@@ -1275,9 +2963,165 @@ namespace fuujin {
             return false;
         }
 
-        auto target = s_Data->Targets.top();
-        Renderer::Submit([target]() { RT_PopRenderLabel(target); });
+        auto& target = *s_Data->Targets.top();
+        RecordCommand<RenderCommand>(target, RenderCommandType::PopLabel);
 
         return true;
     }
+
+    static void RT_ClearLayers(uint32_t layerMask,
+                               const std::shared_ptr<ActiveRenderTarget>& target) {
+        ZoneScoped;
+
+        RT_BeginRenderTarget(target);
+        s_Data->API->RT_ClearLayers(*target->CmdList, target->Target, layerMask, s_ClearColor);
+    }
+
+    void Renderer::ClearLayers(uint32_t layerMask) {
+        ZoneScoped;
+
+        if (!s_Data || s_Data->Targets.empty()) {
+            throw std::runtime_error("No render target to clear!");
+        }
+
+        if (layerMask == 0) {
+            return;
+        }
+
+        // draws recorded before the clear are never sorted past it
+        auto& target = *s_Data->Targets.top();
+        auto command = RecordCommand<ClearCommand>(target, RenderCommandType::Clear);
+        command->LayerMask = layerMask;
+    }
+
+    struct SortedDraw {
+        uint64_t Key;
+        uint32_t Index;
+        DrawCommand* Command;
+    };
+
+    static thread_local std::vector<SortedDraw> s_SortedDraws;
+
+    // sorts each run of consecutive sortable draws by key
+    // labels and unsorted draws stay where they were recorded
+    static void SortDrawCommands(ActiveRenderTarget& target) {
+        ZoneScoped;
+
+        auto& run = s_SortedDraws;
+        RenderCommand* previous = nullptr;
+        RenderCommand* command = target.FirstCommand;
+
+        auto isSortable = [](const RenderCommand* command) {
+            return command->Type == RenderCommandType::Draw &&
+                   ((const DrawCommand*)command)->Sortable;
+        };
+
+        while (command != nullptr) {
+            if (!isSortable(command)) {
+                previous = command;
+                command = command->Next;
+                continue;
+            }
+
+            run.clear();
+            while (command != nullptr && isSortable(command)) {
+                auto& draw = run.emplace_back();
+                draw.Command = (DrawCommand*)command;
+                draw.Key = draw.Command->SortKey;
+                draw.Index = (uint32_t)run.size();
+
+                command = command->Next;
+            }
+
+            // ties keep their recorded order
+            std::sort(run.begin(), run.end(), [](const SortedDraw& lhs, const SortedDraw& rhs) {
+                return lhs.Key != rhs.Key ? lhs.Key < rhs.Key : lhs.Index < rhs.Index;
+            });
+
+            for (const auto& draw : run) {
+                if (previous != nullptr) {
+                    previous->Next = draw.Command;
+                } else {
+                    target.FirstCommand = draw.Command;
+                }
+
+                previous = draw.Command;
+            }
+
+            previous->Next = command;
+            if (command == nullptr) {
+                target.LastCommand = previous;
+            }
+        }
+    }
+
+    static void RT_UploadInstances(const ActiveRenderTarget& target) {
+        ZoneScoped;
+
+        const auto& arena = *target.Arena;
+        DeviceBuffer* mappedBuffer = nullptr;
+        Buffer mapped;
+
+        for (auto upload = target.FirstUpload; upload != nullptr; upload = upload->Next) {
+            auto buffer = arena.Get<DeviceBuffer>(upload->Buffer);
+            if (buffer != mappedBuffer) {
+                if (mappedBuffer != nullptr) {
+                    mappedBuffer->RT_Unmap();
+                }
+
+                mapped = buffer->RT_Map();
+                mappedBuffer = buffer;
+            }
+
+            size_t offset = upload->FirstInstance * sizeof(glm::mat4);
+            size_t size = upload->InstanceCount * sizeof(glm::mat4);
+            Buffer::Copy(Buffer::Wrapper(upload->Transforms, size), mapped.Slice(offset, size));
+        }
+
+        if (mappedBuffer != nullptr) {
+            mappedBuffer->RT_Unmap();
+        }
+    }
+
+    static void RT_ExecuteCommands(const std::shared_ptr<ActiveRenderTarget>& target) {
+        ZoneScoped;
+
+        RT_UploadInstances(*target);
+        SortDrawCommands(*target);
+
+        const auto& arena = *target->Arena;
+        for (auto command = target->FirstCommand; command != nullptr; command = command->Next) {
+            switch (command->Type) {
+            case RenderCommandType::Draw:
+                RT_RenderIndexed(arena, *(const DrawCommand*)command, target);
+                break;
+            case RenderCommandType::PushLabel:
+                RT_PushRenderLabel(((const LabelCommand*)command)->Label, target);
+                break;
+            case RenderCommandType::PopLabel:
+                RT_PopRenderLabel(target);
+                break;
+            case RenderCommandType::Clear:
+                RT_ClearLayers(((const ClearCommand*)command)->LayerMask, target);
+                break;
+            default:
+                throw std::runtime_error("Invalid render command!");
+            }
+        }
+
+        // drop references but keep capacity for the next target
+        auto& call = s_DecodedCall;
+        call.VertexBuffers.clear();
+        call.Resources.clear();
+        call.IndexBuffer.Reset();
+        call.RenderPipeline.Reset();
+        call.PushConstants = nullptr;
+        call.DynamicOffsets = nullptr;
+
+        auto& counts = s_BindCounts;
+        s_Data->PipelineBinds += counts.Pipelines;
+        s_Data->BufferBinds += counts.Buffers;
+        s_Data->ResourceBinds += counts.Resources;
+        counts = {};
+    }
 }; // namespace fuujin
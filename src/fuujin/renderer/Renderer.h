@@ -25,6 +25,13 @@ namespace fuujin {
                           size_t offset = 0, size_t range = 0) = 0;
 
         virtual bool Bind(const std::string& name, Ref<Texture> texture, uint32_t index = 0) = 0;
+
+        virtual uint64_t GetID() const = 0;
+
+        // draws copy the dynamic offsets when they are recorded, so that binding a new offset
+        // later in the frame does not move draws that were already recorded
+        virtual uint32_t GetDynamicOffsetCount() const = 0;
+        virtual void GetDynamicOffsets(uint32_t* offsets) = 0;
     };
 
     struct Scissor {
@@ -45,8 +52,25 @@ namespace fuujin {
         uint32_t IndexOffset = 0;
         uint32_t IndexCount = 0;
 
+        uint32_t FirstInstance = 0;
+        uint32_t InstanceCount = 1;
+
         Buffer PushConstants;
         std::vector<Ref<RendererAllocation>> Resources;
+
+        // draws with a depth may be reordered among neighboring draws that also have one
+        // draws without one, such as UI, keep the order they were submitted in
+        std::optional<float> Depth;
+
+        // set by the renderer when the previous draw in the command list left state bound
+        // the backend may skip binding whatever is already bound
+        bool BindPipeline = true;
+        bool BindVertexBuffers = true;
+        bool BindIndexBuffer = true;
+        uint32_t BoundResources = 0; // bit i is set if Resources[i] is already bound
+
+        // the dynamic offsets of every resource in order, as copied when the draw was recorded
+        const uint32_t* DynamicOffsets = nullptr;
     };
 
     struct MaterialRenderCall {
@@ -54,11 +78,18 @@ namespace fuujin {
         Ref<DeviceBuffer> IndexBuffer;
         Ref<Pipeline> RenderPipeline;
         uint32_t IndexCount;
+        uint32_t FirstInstance = 0;
+        uint32_t InstanceCount = 1;
 
         glm::mat4 ModelMatrix;
         size_t FirstCamera, CameraCount;
+        uint32_t CameraMask = std::numeric_limits<uint32_t>::max();
         std::unordered_map<std::string, Buffer> PushConstants;
 
+        // the pipeline's shader selects each instance's camera in the vertex stage
+        // instances are repeated once per visible camera instead of in a geometry shader
+        bool LayeredCameras = false;
+
         uint64_t SceneID;
         Ref<Material> RenderMaterial;
         std::vector<Ref<RendererAllocation>> AdditionalResources;
@@ -78,10 +109,26 @@ namespace fuujin {
 
         glm::mat4 ModelMatrix;
         size_t FirstCamera, CameraCount;
+
+        // bit i is set if camera FirstCamera + i can see the model
+        // the geometry shader does not emit primitives to the other cameras
+        uint32_t CameraMask = std::numeric_limits<uint32_t>::max();
+
+        // if not empty, ModelMatrix is ignored and the model is drawn once per matrix
+        // meshes without bones are drawn with a single instanced draw
+        std::vector<glm::mat4> InstanceMatrices;
     };
 
     class RendererAPI {
     public:
+        struct DescriptorCounts {
+            // totals since the renderer was created
+            uint64_t SetAllocations, SetUpdates;
+
+            // sets currently kept around for reuse, and the pools they are allocated from
+            size_t CachedSets, Pools;
+        };
+
         virtual ~RendererAPI() = default;
 
         virtual void RT_NewFrame(uint32_t frame) = 0;
@@ -96,7 +143,14 @@ namespace fuujin {
         virtual void RT_BeginRenderLabel(CommandList& cmdlist, const std::string& label) const = 0;
         virtual void RT_EndRenderLabel(CommandList& cmdlist) const = 0;
 
+        // bit i of layerMask clears layer i of every attachment
+        virtual void RT_ClearLayers(CommandList& cmdlist, Ref<RenderTarget> target,
+                                    uint32_t layerMask, const glm::vec4& clearColor) const = 0;
+
         virtual Ref<RendererAllocation> CreateAllocation(const Ref<Shader>& shader) const = 0;
+
+        // may be called from any thread
+        virtual DescriptorCounts GetDescriptorCounts() const = 0;
     };
 
     class Renderer {
@@ -109,15 +163,23 @@ namespace fuujin {
 
         struct RendererLight {
             glm::mat4 TransformMatrix;
-            size_t ShadowIndex;
             Ref<Light> LightData;
+
+            // the cube of ShadowAtlas holding the light's shadow map, if it has one
+            // ShadowScale is the fraction of each face that the map covers
+            std::optional<uint32_t> ShadowIndex;
+            float ShadowScale;
         };
 
         struct SceneData {
             std::vector<Camera> Cameras;
             std::vector<RendererLight> Lights;
 
-            std::vector<Ref<Texture>> ShadowCubeMaps;
+            // a cube map array; see SceneRenderer
+            Ref<Texture> ShadowAtlas;
+
+            // lights are culled into clusters of this camera's view; see LightGrid
+            std::optional<size_t> ClusterCamera;
         };
 
         struct MeshBuffers {
@@ -125,6 +187,69 @@ namespace fuujin {
             Ref<DeviceBuffer> IndexBuffer;
         };
 
+        struct QueueStatistics {
+            uint64_t JobsExecuted, Wakeups;
+
+            // measured over the time the render thread was awake
+            double JobsPerSecond;
+
+            // time from submission to execution of the first job after the render thread sleeps
+            Duration AverageWakeLatency, MaxWakeLatency;
+        };
+
+        // how a pushed render target relates to the targets around it
+        struct TargetUsage {
+            // bit i is set if attachment i of a framebuffer is read after it is popped
+            // attachments that are not read are not synchronized with later targets
+            uint32_t ReadAttachments = std::numeric_limits<uint32_t>::max();
+
+            // set if the target samples attachments rendered by targets pushed before it
+            // such targets are not recorded in parallel with the targets before them
+            bool ReadsPreviousTargets = false;
+        };
+
+        struct FrameStatistics {
+            uint32_t DrawCalls, DrawnInstances;
+
+            // heap allocations made by the calling thread while recording draws
+            // should stay at 0 once the command arenas have grown to fit a frame
+            uint64_t DrawAllocations;
+
+            // bytes of command arena used
+            size_t CommandMemory;
+
+            // bytes of uniform data written, including alignment
+            size_t UniformMemory;
+
+            // batches submitted to the device by the render thread since the last frame
+            uint32_t QueueSubmits;
+
+            // binds actually recorded since the last frame, after skipping redundant ones
+            uint32_t PipelineBinds, BufferBinds, ResourceBinds;
+
+            // descriptor sets allocated and written since the last frame
+            // both should stay near 0 while the bound resources do not change
+            uint32_t DescriptorSetAllocations, DescriptorSetUpdates;
+            size_t CachedDescriptorSets, DescriptorPools;
+
+            // pipelines that finished compiling in the background since the last frame, and those
+            // still compiling
+            uint32_t PipelinesCompiled, PipelinesPending;
+
+            // draws whose pipeline was still compiling, drawn with the shader's default pipeline
+            // or skipped entirely
+            uint32_t FallbackDraws, SkippedDraws;
+
+            // multi-camera draws that selected their layers in the vertex stage
+            uint32_t LayeredDraws;
+
+            // light indices written to the clusters of every scene updated since the last frame
+            size_t ClusteredLights;
+
+            // time spent waiting on the render thread to catch up before recording
+            Duration LeadWaitTime;
+        };
+
         Renderer() = delete;
 
         static void Init();
@@ -138,6 +263,27 @@ namespace fuujin {
         static uint32_t GetCurrentFrame();
         static uint32_t GetFrameCount();
 
+        // the number of frames that may be recorded ahead of the render thread
+        // 0 waits for the render thread to finish the previous frame before starting a new one
+        static void SetFrameLead(uint32_t frames);
+        static uint32_t GetFrameLead();
+
+        // materials read their textures from a table shared across draws, rather than each
+        // binding its own
+        // ignored if the device cannot index descriptor arrays at runtime
+        static void SetBindlessTextures(bool enabled);
+        static bool GetBindlessTextures();
+
+        // main pass material pipelines compile in the background instead of stalling the frame
+        // that first needs them; on by default
+        static void SetAsyncPipelines(bool enabled);
+        static bool GetAsyncPipelines();
+
+        // multi-camera passes (e.g. point light shadows) select their layers in the vertex stage
+        // rather than in a geometry shader; on by default where supported
+        static void SetLayeredCameras(bool enabled);
+        static bool GetLayeredCameras();
+
         static void ProcessEvent(Event& event);
 
         static Ref<RendererAllocation> CreateAllocation(const Ref<Shader>& shader);
@@ -154,9 +300,16 @@ namespace fuujin {
         static Ref<RendererAllocation> GetMaterialAllocation(const Ref<Material>& material,
                                                              const Ref<Shader>& shader);
 
+        // if async, the pipeline compiles in the background and may not be ready when returned
         static Ref<Pipeline> GetMaterialPipeline(const Ref<Shader>& shader,
                                                  const Ref<RenderTarget>& target,
-                                                 const Material::PipelineProperties& spec);
+                                                 const Material::PipelineProperties& spec,
+                                                 bool async = false);
+
+        // creates the pipelines that the model's meshes are drawn to the target with
+        // they compile on the render thread, rather than mid-frame the first time they are drawn
+        static void PrewarmModelPipelines(const Ref<Model>& model, const Ref<RenderTarget>& target,
+                                          ShaderName shader = ShaderName::Material);
 
         static const MeshBuffers& GetMeshBuffers(const std::unique_ptr<Mesh>& mesh);
 
@@ -183,11 +336,17 @@ namespace fuujin {
         // checks if the thread this is called from is the render thread
         static bool IsRenderThread();
 
+        static QueueStatistics GetQueueStatistics();
+
+        // statistics of the last frame recorded
+        static const FrameStatistics& GetFrameStatistics();
+
         // signals a new frame
         static void NewFrame();
 
         // pushes a render target of a framebuffer
         static void PushRenderTarget(Ref<RenderTarget> target);
+        static void PushRenderTarget(Ref<RenderTarget> target, const TargetUsage& usage);
 
         // flushes and pops a render target from the stack
         static void PopRenderTarget();
@@ -205,6 +364,10 @@ namespace fuujin {
         static bool PushRenderLabel(const std::string& label);
         static bool PopRenderLabel();
 
+        // clears the layers of the active render target set in layerMask
+        // only needed for framebuffers that preserve their contents between renders
+        static void ClearLayers(uint32_t layerMask);
+
     private:
         static void CreateDefaultObjects();
 
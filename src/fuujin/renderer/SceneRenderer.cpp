@@ -6,15 +6,35 @@
 
 #include "fuujin/scene/Components.h"
 
+#include <algorithm>
+
 namespace fuujin {
     static uint64_t s_RendererSceneID = 0;
-    static constexpr uint32_t s_ShadowResolution = 1024;
+
+    // the atlas starts with 96MB of depth per frame in flight, and grows with the scene's lights
+    // up to 384MB per frame
+    static constexpr uint32_t s_DefaultShadowAtlasResolution = 1024;
+    static constexpr uint32_t s_DefaultShadowAtlasCapacity = 16;
+    static constexpr uint32_t s_MinShadowAtlasCapacity = 4;
+
+    // two point lights' worth of faces
+    static constexpr uint32_t s_DefaultShadowFaceBudget = 12;
+
+    static constexpr float s_MovingLightWeight = 2.f;
+    static constexpr float s_MinShadowPriority = 0.01f;
 
     SceneRenderer::SceneRenderer(const Ref<Scene>& scene) {
         ZoneScoped;
 
         m_Scene = scene;
         m_MainID = s_RendererSceneID++;
+        m_Stats = {};
+
+        m_ShadowFaceBudget = s_DefaultShadowFaceBudget;
+        m_ShadowUpdate = 0;
+
+        m_ShadowAtlasResolution = s_DefaultShadowAtlasResolution;
+        m_ShadowAtlasCapacity = s_DefaultShadowAtlasCapacity;
 
         Sampler::Spec shadowSamplerSpec;
         shadowSamplerSpec.U = AddressMode::ClampToBorder;
@@ -35,11 +55,46 @@ namespace fuujin {
         }
     }
 
+    void SceneRenderer::SetShadowAtlasSize(uint32_t resolution, uint32_t capacity) {
+        ZoneScoped;
+
+        m_ShadowAtlasResolution = resolution;
+        m_ShadowAtlasCapacity = capacity;
+
+        // allocated again with the next light
+        m_ShadowAtlas.Reset();
+        for (auto& [entity, shadowData] : m_LightShadowData) {
+            shadowData.Slot.reset();
+        }
+    }
+
     void SceneRenderer::RenderScene() {
         ZoneScoped;
 
-        RenderShadows();
-        RenderMainScene();
+        m_Stats = {};
+        m_Scene->UpdateSpatialIndex();
+
+        // shadows are scheduled around what the main camera sees
+        Renderer::SceneData mainScene;
+        size_t mainCamera = 0;
+        CollectCameras(mainScene, mainCamera);
+
+        RenderShadows(mainScene.Cameras.empty() ? nullptr : &mainScene.Cameras[mainCamera]);
+        RenderMainScene(mainScene, mainCamera);
+    }
+
+    void SceneRenderer::PrewarmPipelines(const Ref<RenderTarget>& target) {
+        ZoneScoped;
+
+        std::unordered_set<Model*> prewarmed;
+        m_Scene->View<ModelComponent>([&](Scene::Entity entity, ModelComponent& model) {
+            if (model.RenderedModel.IsEmpty() || prewarmed.contains(model.RenderedModel.Raw())) {
+                return;
+            }
+
+            prewarmed.insert(model.RenderedModel.Raw());
+            Renderer::PrewarmModelPipelines(model.RenderedModel, target, ShaderName::Material);
+        });
     }
 
     static bool AreSpecsEqual(const ShadowFramebufferSpec& lhs, const ShadowFramebufferSpec& rhs) {
@@ -47,27 +102,121 @@ namespace fuujin {
                lhs.Resolution == rhs.Resolution;
     }
 
-    void SceneRenderer::RenderShadowMap(Scene::Entity entity, const glm::mat4& transform,
-                                        const Ref<Light>& light) {
+    static void GetAnimatorState(const CulledEntity& culled, uint64_t& id, uint64_t& state) {
+        if (culled.EntityAnimator.IsPresent()) {
+            id = culled.EntityAnimator->GetID();
+            state = culled.EntityAnimator->GetState();
+        } else {
+            id = state = 0;
+        }
+    }
+
+    // only casters with faceBit set in their camera mask are compared
+    static bool AreInputsEqual(const ShadowFaceInputs& inputs, const Renderer::Camera& camera,
+                               const std::vector<CulledEntity>& casters, uint32_t faceBit) {
+        ZoneScoped;
+
+        const auto& faceCamera = inputs.FaceCamera;
+        if (!inputs.Valid || faceCamera.Position != camera.Position ||
+            faceCamera.ViewProjection != camera.ViewProjection ||
+            faceCamera.ZRange != camera.ZRange) {
+            return false;
+        }
+
+        // transform revisions are unique, so they also identify the entity
+        size_t index = 0;
+        for (const auto& culled : casters) {
+            if ((culled.CameraMask & faceBit) == 0) {
+                continue;
+            }
+
+            if (index >= inputs.Casters.size()) {
+                return false;
+            }
+
+            uint64_t animatorID, animatorState;
+            GetAnimatorState(culled, animatorID, animatorState);
+
+            const auto& caster = inputs.Casters[index++];
+            if (caster.TransformRevision != culled.TransformRevision ||
+                caster.CastingModel != culled.RenderedModel || caster.AnimatorID != animatorID ||
+                caster.AnimatorState != animatorState) {
+                return false;
+            }
+        }
+
+        return index == inputs.Casters.size();
+    }
+
+    static void RecordInputs(ShadowFaceInputs& inputs, const Renderer::Camera& camera,
+                             const std::vector<CulledEntity>& casters, uint32_t faceBit) {
+        ZoneScoped;
+
+        inputs.Valid = true;
+        inputs.FaceCamera = camera;
+        inputs.Casters.clear();
+
+        for (const auto& culled : casters) {
+            if ((culled.CameraMask & faceBit) == 0) {
+                continue;
+            }
+
+            auto& caster = inputs.Casters.emplace_back();
+            caster.TransformRevision = culled.TransformRevision;
+            caster.CastingModel = culled.RenderedModel;
+
+            GetAnimatorState(culled, caster.AnimatorID, caster.AnimatorState);
+        }
+    }
+
+    // roughly how much of the main camera's view the light's shadows can cover
+    // lights outside of the main camera's view are only updated with leftover budget
+    static float GetShadowPriority(const BoundingSphere& influence,
+                                   const Renderer::Camera* mainCamera,
+                                   const std::optional<Frustum>& mainFrustum) {
+        if (mainCamera == nullptr) {
+            return 1.f;
+        }
+
+        if (mainFrustum.has_value() && !mainFrustum.value().Intersects(influence)) {
+            return 0.f;
+        }
+
+        // 1 once the camera is inside of the influence sphere
+        float distance = glm::length(influence.Center - mainCamera->Position);
+        return influence.Radius / std::max(distance, influence.Radius);
+    }
+
+    void SceneRenderer::PrepareShadowMap(Scene::Entity entity, const glm::mat4& transform,
+                                         const Ref<Light>& light,
+                                         const Renderer::Camera* mainCamera,
+                                         const std::optional<Frustum>& mainFrustum) {
         ZoneScoped;
         const auto& api = Renderer::GetAPI();
 
-        bool framebufferExists = m_LightShadowData.contains(entity);
+        bool dataExists = m_LightShadowData.contains(entity);
         auto& shadowData = m_LightShadowData[entity];
 
-        if (!framebufferExists) {
+        if (!dataExists) {
             shadowData.SceneID = s_RendererSceneID++;
+            shadowData.UpdatedFaces = 0;
+        }
+
+        shadowData.LastPrepared = m_ShadowUpdate;
+        if (m_ShadowAtlas.IsEmpty()) {
+            m_Stats.UnshadowedLights++;
+            return;
         }
 
         ShadowFramebufferSpec currentSpec;
-        currentSpec.Resolution = s_ShadowResolution;
 
-        Renderer::SceneData sceneData;
-        ShaderName shader;
+        auto& sceneData = shadowData.Scene;
+        sceneData.Cameras.clear();
 
+        BoundingSphere influence;
         switch (light->GetType()) {
         case Light::Type::Point: {
-            shader = ShaderName::PointLightDepth;
+            shadowData.Shader = ShaderName::PointLightDepth;
 
             static const glm::vec3 up = glm::vec3(0.f, -1.f, 0.f);
             static const std::vector<glm::vec3> cubeFaceDirections = {
@@ -75,10 +224,12 @@ namespace fuujin {
                 glm::vec3(0.f, -1.f, 0.f), glm::vec3(0.f, 0.f, 1.f),  glm::vec3(0.f, 0.f, -1.f)
             };
 
+            auto pointLight = light.As<PointLight>();
             currentSpec.Layers = (uint32_t)cubeFaceDirections.size();
             currentSpec.AttachmentType = Texture::Type::Cube;
+            currentSpec.Resolution =
+                std::min(pointLight->GetShadowResolution(), m_ShadowAtlasResolution);
 
-            auto pointLight = light.As<PointLight>();
             glm::vec3 offset = pointLight->GetPosition();
 
             glm::vec2 zRange = pointLight->GetShadowZRange();
@@ -88,6 +239,10 @@ namespace fuujin {
             glm::vec3 position = transform * glm::vec4(offset, 1.f);
             glm::mat4 projection = Camera::Perspective(api, glm::radians(90.f), 1.f, near, far);
 
+            // nothing past the influence radius is lit, so it cannot cast a visible shadow
+            influence.Center = position;
+            influence.Radius = pointLight->GetAttenuation().InfluenceRadius;
+
             for (const auto& direction : cubeFaceDirections) {
                 auto& camera = sceneData.Cameras.emplace_back();
                 camera.Position = position;
@@ -107,28 +262,100 @@ namespace fuujin {
             return;
         }
 
-        Renderer::UpdateScene(shadowData.SceneID, sceneData);
-        if (!framebufferExists || !AreSpecsEqual(currentSpec, shadowData.Spec)) {
+        if (!shadowData.Slot.has_value() || !AreSpecsEqual(currentSpec, shadowData.Spec)) {
+            if (shadowData.Slot.has_value()) {
+                m_ShadowAtlas->Free(shadowData.Slot.value());
+            }
+
+            // cubes are handed out as lights appear, and come back as they are removed
+            shadowData.Slot = m_ShadowAtlas->Allocate(currentSpec.Resolution);
+            if (!shadowData.Slot.has_value()) {
+                m_Stats.UnshadowedLights++;
+                return;
+            }
+
             shadowData.Spec = currentSpec;
+            shadowData.LastPosition = influence.Center;
+
+            ShadowFaceInputs emptyFace{ false, {}, {} };
+            shadowData.RenderedInputs.assign(currentSpec.Layers, emptyFace);
+            shadowData.LastUpdated.assign(currentSpec.Layers, 0);
+        }
+
+        m_Stats.ShadowedLights++;
+
+        CullEntities(sceneData, 0, sceneData.Cameras.size(), influence);
+        shadowData.Casters.swap(m_CulledEntities);
+        m_CulledEntities.clear();
+
+        // the spatial index may return casters in any order
+        std::sort(shadowData.Casters.begin(), shadowData.Casters.end(),
+                  [](const CulledEntity& lhs, const CulledEntity& rhs) {
+                      return lhs.TransformRevision < rhs.TransformRevision;
+                  });
+
+        float priority = GetShadowPriority(influence, mainCamera, mainFrustum);
+        if (influence.Center != shadowData.LastPosition) {
+            priority *= s_MovingLightWeight;
+        }
 
-            Framebuffer::Spec spec;
-            spec.Layers = currentSpec.Layers;
-            spec.Width = currentSpec.Resolution;
-            spec.Height = currentSpec.Resolution;
+        priority += s_MinShadowPriority;
+        shadowData.LastPosition = influence.Center;
 
-            auto& depthSpec = spec.Attachments.emplace_back();
-            depthSpec.TextureSampler = m_ShadowSampler;
-            depthSpec.Type = Framebuffer::AttachmentType::Depth;
-            depthSpec.ImageType = Texture::Type::Cube;
-            depthSpec.Format = Texture::Format::D32;
+        // the map is kept around until it would come out differently
+        const auto& renderedFaces = shadowData.RenderedInputs;
+        const auto& lastUpdated = shadowData.LastUpdated;
 
-            auto context = Renderer::GetContext();
-            uint32_t frameCount = Renderer::GetFrameCount();
-            shadowData.Framebuffers = context->CreateFramebuffers(spec, frameCount);
+        for (uint32_t i = 0; i < currentSpec.Layers; i++) {
+            const auto& inputs = renderedFaces[i];
+            if (AreInputsEqual(inputs, sceneData.Cameras[i], shadowData.Casters, 1u << i)) {
+                m_Stats.ShadowFacesReused++;
+                continue;
+            }
+
+            // faces that have waited longer are more likely to make it into the budget
+            uint64_t age = m_ShadowUpdate - lastUpdated[i];
+
+            auto& request = m_ShadowRequests.emplace_back();
+            request.Data = &shadowData;
+            request.Face = i;
+            request.Required = !inputs.Valid;
+            request.Score = priority * (float)age;
         }
+    }
 
-        uint32_t currentFrame = Renderer::GetCurrentFrame();
-        auto framebuffer = shadowData.Framebuffers[currentFrame];
+    void SceneRenderer::RenderShadowMap(Scene::Entity entity, LightShadowData& shadowData) {
+        ZoneScoped;
+
+        auto framebuffer = m_ShadowAtlas->GetFramebuffer(shadowData.Slot.value());
+        auto& renderedFaces = shadowData.RenderedInputs;
+        auto& lastUpdated = shadowData.LastUpdated;
+        const auto& cameras = shadowData.Scene.Cameras;
+
+        for (uint32_t i = 0; i < shadowData.Spec.Layers; i++) {
+            uint32_t faceBit = 1u << i;
+            if ((shadowData.UpdatedFaces & faceBit) == 0) {
+                continue;
+            }
+
+            RecordInputs(renderedFaces[i], cameras[i], shadowData.Casters, faceBit);
+            lastUpdated[i] = m_ShadowUpdate;
+            m_Stats.ShadowFacesRendered++;
+        }
+
+        // casters are only drawn to the faces being updated
+        m_CulledEntities.clear();
+        for (const auto& caster : shadowData.Casters) {
+            uint32_t cameraMask = caster.CameraMask & shadowData.UpdatedFaces;
+            if (cameraMask == 0) {
+                continue;
+            }
+
+            auto& culled = m_CulledEntities.emplace_back(caster);
+            culled.CameraMask = cameraMask;
+        }
+
+        Renderer::UpdateScene(shadowData.SceneID, shadowData.Scene);
 
         std::string lightTag;
         if (entity.HasAll<TagComponent>()) {
@@ -140,15 +367,51 @@ namespace fuujin {
         Renderer::PushRenderTarget(framebuffer);
         Renderer::PushRenderLabel("Render shadow map for light: " + lightTag);
 
-        RenderSceneWithID(shadowData.SceneID, 0, sceneData.Cameras.size(), shader);
+        Renderer::ClearLayers(shadowData.UpdatedFaces);
+        RenderCulledEntities(shadowData.SceneID, 0, cameras.size(), shadowData.Shader);
 
         Renderer::PopRenderLabel();
         Renderer::PopRenderTarget();
     }
 
-    void SceneRenderer::RenderShadows() {
+    void SceneRenderer::RenderShadows(const Renderer::Camera* mainCamera) {
         ZoneScoped;
 
+        m_ShadowUpdate++;
+        m_ShadowRequests.clear();
+
+        uint32_t lightCount = 0;
+        m_Scene->View<LightComponent>([&](Scene::Entity, LightComponent&) { lightCount++; });
+
+        // growing the atlas moves every light to a new cube, so it is grown in powers of two
+        uint32_t atlasCapacity = m_ShadowAtlas.IsPresent() ? m_ShadowAtlas->GetSpec().Capacity : 0;
+        if (lightCount > atlasCapacity && atlasCapacity < m_ShadowAtlasCapacity) {
+            uint32_t capacity = std::min(s_MinShadowAtlasCapacity, m_ShadowAtlasCapacity);
+            while (capacity < lightCount && capacity < m_ShadowAtlasCapacity) {
+                capacity = std::min(capacity * 2, m_ShadowAtlasCapacity);
+            }
+
+            ShadowAtlas::Spec atlasSpec;
+            atlasSpec.Resolution = m_ShadowAtlasResolution;
+            atlasSpec.Capacity = capacity;
+            atlasSpec.DepthSampler = m_ShadowSampler;
+
+            m_ShadowAtlas = Ref<ShadowAtlas>::Create(atlasSpec);
+            for (auto& [entity, shadowData] : m_LightShadowData) {
+                shadowData.Slot.reset();
+            }
+
+            FUUJIN_INFO("Shadow atlas allocated with {} cubes ({} MB)",
+                        capacity, m_ShadowAtlas->GetMemorySize() / (1024 * 1024));
+        }
+
+        m_Stats.ShadowAtlasMemory = m_ShadowAtlas.IsPresent() ? m_ShadowAtlas->GetMemorySize() : 0;
+
+        std::optional<Frustum> mainFrustum;
+        if (mainCamera != nullptr) {
+            mainFrustum.emplace(mainCamera->ViewProjection, Renderer::GetAPI());
+        }
+
         m_Scene->View<LightComponent>([&](Scene::Entity entity, LightComponent& light) {
             glm::mat4 transformMatrix(1.f);
             if (entity.HasAll<TransformComponent>()) {
@@ -156,11 +419,59 @@ namespace fuujin {
                 transformMatrix = transform.Data.ToMatrix();
             }
 
-            RenderShadowMap(entity, transformMatrix, light.SceneLight);
+            PrepareShadowMap(entity, transformMatrix, light.SceneLight, mainCamera, mainFrustum);
         });
+
+        // lights that were removed give their cube back to the atlas
+        for (auto it = m_LightShadowData.begin(); it != m_LightShadowData.end();) {
+            const auto& shadowData = it->second;
+            if (shadowData.LastPrepared == m_ShadowUpdate) {
+                it++;
+                continue;
+            }
+
+            if (shadowData.Slot.has_value()) {
+                m_ShadowAtlas->Free(shadowData.Slot.value());
+            }
+
+            Renderer::FreeScene(shadowData.SceneID);
+            it = m_LightShadowData.erase(it);
+        }
+
+        std::sort(m_ShadowRequests.begin(), m_ShadowRequests.end(),
+                  [](const ShadowFaceRequest& lhs, const ShadowFaceRequest& rhs) {
+                      if (lhs.Required != rhs.Required) {
+                          return lhs.Required;
+                      }
+
+                      return lhs.Score > rhs.Score;
+                  });
+
+        // the budget keeps the cost of shadows fixed, no matter how many lights changed
+        uint32_t budget = m_ShadowFaceBudget;
+        for (const auto& request : m_ShadowRequests) {
+            if (budget > 0) {
+                budget--;
+            } else if (!request.Required) {
+                m_Stats.ShadowFacesDeferred++;
+                continue;
+            }
+
+            request.Data->UpdatedFaces |= 1u << request.Face;
+        }
+
+        for (auto& [entity, shadowData] : m_LightShadowData) {
+            if (shadowData.Slot.has_value() && shadowData.UpdatedFaces != 0) {
+                RenderShadowMap(entity, shadowData);
+                shadowData.UpdatedFaces = 0;
+            }
+
+            // don't hold onto models past the frame
+            shadowData.Casters.clear();
+        }
     }
 
-    void SceneRenderer::RenderMainScene() {
+    void SceneRenderer::CollectCameras(Renderer::SceneData& scene, size_t& mainCamera) {
         ZoneScoped;
 
         auto mainTarget = Renderer::GetActiveRenderTarget();
@@ -172,11 +483,9 @@ namespace fuujin {
         uint32_t cameraWidth = mainTarget->GetWidth();
         uint32_t cameraHeight = mainTarget->GetHeight();
 
-        Renderer::SceneData mainScene;
-        size_t mainCamera = 0;
         m_Scene->View<CameraComponent>([&](Scene::Entity entity, CameraComponent& camera) {
             if (camera.MainCamera) {
-                mainCamera = mainScene.Cameras.size();
+                mainCamera = scene.Cameras.size();
             }
 
             glm::mat4 transformMatrix(1.f);
@@ -189,31 +498,41 @@ namespace fuujin {
             entityCamera.SetViewSize({ cameraWidth, cameraHeight });
             auto viewProjection = entityCamera.CalculateViewProjection(transformMatrix);
 
-            auto& rendererCamera = mainScene.Cameras.emplace_back();
+            auto& rendererCamera = scene.Cameras.emplace_back();
             rendererCamera.Position = glm::vec3(transformMatrix * glm::vec4(glm::vec3(0.f), 1.f));
             rendererCamera.ZRange = entityCamera.GetZRange();
             rendererCamera.ViewProjection = viewProjection;
         });
+    }
+
+    void SceneRenderer::RenderMainScene(Renderer::SceneData& mainScene, size_t mainCamera) {
+        ZoneScoped;
+
+        if (mainScene.Cameras.empty()) {
+            return;
+        }
+
+        if (m_ShadowAtlas.IsPresent()) {
+            mainScene.ShadowAtlas = m_ShadowAtlas->GetTexture();
+        }
 
         m_Scene->View<LightComponent>([&](Scene::Entity entity, LightComponent& light) {
             if (light.SceneLight.IsEmpty()) {
                 return;
             }
 
-            if (!m_LightShadowData.contains(entity)) {
-                return;
-            }
-
-            uint32_t currentFrame = Renderer::GetCurrentFrame();
-            auto framebuffer = m_LightShadowData.at(entity).Framebuffers[currentFrame];
-            auto shadowMap = framebuffer->GetTexture(0);
-
-            size_t shadowMapIndex = mainScene.ShadowCubeMaps.size();
-            mainScene.ShadowCubeMaps.push_back(shadowMap);
-
             auto& rendererLight = mainScene.Lights.emplace_back();
             rendererLight.LightData = light.SceneLight;
-            rendererLight.ShadowIndex = shadowMapIndex;
+            rendererLight.ShadowScale = 1.f;
+
+            // lights that did not fit into the atlas are not shadowed
+            auto shadowData = m_LightShadowData.find(entity);
+            if (shadowData != m_LightShadowData.end() && shadowData->second.Slot.has_value()) {
+                uint32_t slot = shadowData->second.Slot.value();
+
+                rendererLight.ShadowIndex = slot;
+                rendererLight.ShadowScale = m_ShadowAtlas->GetScale(slot);
+            }
 
             if (entity.HasAll<TransformComponent>()) {
                 const auto& transform = entity.GetComponent<TransformComponent>();
@@ -223,48 +542,204 @@ namespace fuujin {
             }
         });
 
-        if (!mainScene.Cameras.empty()) {
-            Renderer::UpdateScene(m_MainID, mainScene);
+        // only the main camera renders the scene, so its fragments only shade nearby lights
+        mainScene.ClusterCamera = mainCamera;
 
-            RenderLabel label("Render scene");
-            RenderSceneWithID(m_MainID, mainCamera, 1, ShaderName::Material);
-        }
+        Renderer::UpdateScene(m_MainID, mainScene);
+
+        RenderLabel label("Render scene");
+        RenderSceneWithID(m_MainID, mainScene, mainCamera, 1, ShaderName::Material);
     }
 
-    void SceneRenderer::RenderSceneWithID(uint64_t id, size_t firstCamera, size_t cameraCount,
-                                          ShaderName shader) {
+    void SceneRenderer::CullEntities(const Renderer::SceneData& scene, size_t firstCamera,
+                                     size_t cameraCount,
+                                     const std::optional<BoundingSphere>& influence) {
         ZoneScoped;
 
-        m_Scene->View<TransformComponent, ModelComponent>(
-            [&](Scene::Entity entity, TransformComponent& transform, ModelComponent& model) {
-                glm::mat4 modelMatrix = transform.Data.ToMatrix();
+        static constexpr size_t maxCameras = sizeof(uint32_t) * 8;
+        if (cameraCount > maxCameras) {
+            throw std::runtime_error("Cannot cull more than 32 cameras in a single pass!");
+        }
+
+        const auto& api = Renderer::GetAPI();
+        size_t endCamera = std::min(firstCamera + cameraCount, scene.Cameras.size());
+
+        m_CullingFrustums.clear();
+        for (size_t i = firstCamera; i < endCamera; i++) {
+            m_CullingFrustums.emplace_back(scene.Cameras[i].ViewProjection, api);
+        }
+
+        // coarse pass over the scene's spatial index
+        auto overlaps = [&](const AABB& box) {
+            if (influence.has_value() && !influence.value().Intersects(box)) {
+                return false;
+            }
+
+            for (const auto& frustum : m_CullingFrustums) {
+                if (frustum.Intersects(box)) {
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        m_CulledEntities.clear();
+        m_CullingSpheres.clear();
+
+        m_Scene->Query(overlaps, [&](const Scene::Entity& entity) {
+            const auto& transform = entity.GetComponent<TransformComponent>();
+            const auto& model = entity.GetComponent<ModelComponent>();
+
+            if (model.RenderedModel.IsEmpty()) {
+                return;
+            }
+
+            auto& culled = m_CulledEntities.emplace_back();
+            culled.Entity = entity;
+            culled.RenderedModel = model.RenderedModel;
+            culled.Transform = transform.Data.ToMatrix();
+            culled.TransformRevision = transform.Data.GetRevision();
+            culled.EntityAnimator.Reset();
+
+            // skinned meshes may be animated outside of their bind pose bounds
+            auto& sphere = m_CullingSpheres.emplace_back();
+            if (model.RenderedModel->GetArmatures().empty()) {
+                const auto& bounds = model.RenderedModel->GetBounds();
+
+                BoundingSphere modelSphere;
+                modelSphere.Center = bounds.GetCenter();
+                modelSphere.Radius = glm::length(bounds.GetExtents());
+
+                sphere = modelSphere.Transform(culled.Transform);
+            } else {
+                sphere.Center = glm::vec3(0.f);
+                sphere.Radius = std::numeric_limits<float>::infinity();
 
                 if (!m_Animators.contains(entity) ||
                     m_Animators.at(entity)->GetModel() != model.RenderedModel) {
                     m_Animators[entity] = Ref<Animator>::Create(model.RenderedModel);
                 }
 
-                auto animator = m_Animators.at(entity);
                 // todo: animation components
+                culled.EntityAnimator = m_Animators.at(entity);
+            }
+        });
+
+        // fine pass, which also finds the cameras that can see each entity
+        size_t entityCount = m_CulledEntities.size();
+        m_CullingMasks.assign(entityCount, 0);
+
+        for (size_t i = 0; i < m_CullingFrustums.size(); i++) {
+            const auto& frustum = m_CullingFrustums[i];
+            uint32_t bit = 1u << (uint32_t)i;
+
+            frustum.TestSpheres(m_CullingSpheres.data(), entityCount, bit, m_CullingMasks.data());
+        }
+
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < entityCount; i++) {
+            if (m_CullingMasks[i] == 0) {
+                continue;
+            }
+
+            if (visibleCount != i) {
+                m_CulledEntities[visibleCount] = std::move(m_CulledEntities[i]);
+            }
+
+            m_CulledEntities[visibleCount].CameraMask = m_CullingMasks[i];
+            visibleCount++;
+        }
+
+        m_CulledEntities.resize(visibleCount);
+        m_Stats.Visible += (uint32_t)visibleCount;
+        m_Stats.Culled += (uint32_t)(m_Scene->GetIndexedEntityCount() - visibleCount);
+    }
+
+    void SceneRenderer::RenderSceneWithID(uint64_t id, const Renderer::SceneData& scene,
+                                          size_t firstCamera, size_t cameraCount,
+                                          ShaderName shader) {
+        ZoneScoped;
 
+        CullEntities(scene, firstCamera, cameraCount);
+        RenderCulledEntities(id, firstCamera, cameraCount, shader);
+    }
+
+    void SceneRenderer::RenderCulledEntities(uint64_t id, size_t firstCamera, size_t cameraCount,
+                                             ShaderName shader) {
+        ZoneScoped;
+
+        // entities sharing a static model and seen by the same cameras are drawn together
+        for (auto& [model, instances] : m_Instances) {
+            for (auto& [cameraMask, transforms] : instances.Transforms) {
+                transforms.clear();
+            }
+        }
+
+        for (const auto& culled : m_CulledEntities) {
+            const auto& entity = culled.Entity;
+            const auto& model = culled.RenderedModel;
+
+            if (model->GetArmatures().empty()) {
+                auto& instances = m_Instances[model.Raw()];
+                instances.InstancedModel = model;
+                instances.Transforms[culled.CameraMask].push_back(culled.Transform);
+
+                continue;
+            }
+
+            ModelRenderCall call;
+            call.RenderedModel = model;
+            call.ModelAnimator = culled.EntityAnimator;
+            call.ModelMatrix = culled.Transform;
+            call.FirstCamera = firstCamera;
+            call.CameraCount = cameraCount;
+            call.CameraMask = culled.CameraMask;
+            call.SceneID = id;
+            call.RenderShader = shader;
+
+            std::string tag;
+            if (entity.HasAll<TagComponent>()) {
+                tag = entity.GetComponent<TagComponent>().Tag;
+            } else {
+                tag = "<untagged entity>";
+            }
+
+            RenderLabel entityLabel("Render entity: " + tag);
+            Renderer::RenderModel(call);
+        }
+
+        // a single label, so that draws of different models may still be sorted together
+        RenderLabel instancesLabel("Render instanced models");
+        for (auto it = m_Instances.begin(); it != m_Instances.end();) {
+            auto& instances = it->second;
+            std::erase_if(instances.Transforms,
+                          [](const auto& group) { return group.second.empty(); });
+
+            if (instances.Transforms.empty()) {
+                it = m_Instances.erase(it);
+                continue;
+            }
+
+            for (auto& [cameraMask, transforms] : instances.Transforms) {
                 ModelRenderCall call;
-                call.RenderedModel = model.RenderedModel;
-                call.ModelAnimator = animator;
-                call.ModelMatrix = modelMatrix;
+                call.RenderedModel = instances.InstancedModel;
                 call.FirstCamera = firstCamera;
                 call.CameraCount = cameraCount;
+                call.CameraMask = cameraMask;
                 call.SceneID = id;
                 call.RenderShader = shader;
 
-                std::string tag;
-                if (entity.HasAll<TagComponent>()) {
-                    tag = entity.GetComponent<TagComponent>().Tag;
-                } else {
-                    tag = "<untagged entity>";
-                }
-
-                RenderLabel entityLabel("Render entity: " + tag);
+                // borrow the transforms to keep their capacity around for the next pass
+                call.InstanceMatrices.swap(transforms);
                 Renderer::RenderModel(call);
-            });
+                call.InstanceMatrices.swap(transforms);
+            }
+
+            it++;
+        }
+
+        // don't hold onto models past the pass
+        m_CulledEntities.clear();
     }
 } // namespace fuujin
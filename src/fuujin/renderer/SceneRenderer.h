@@ -8,6 +8,8 @@
 #include "fuujin/renderer/Light.h"
 #include "fuujin/renderer/Framebuffer.h"
 #include "fuujin/renderer/Renderer.h"
+#include "fuujin/renderer/ShadowAtlas.h"
+#include "fuujin/renderer/Bounds.h"
 
 namespace fuujin {
     struct ShadowFramebufferSpec {
@@ -16,35 +18,148 @@ namespace fuujin {
         Texture::Type AttachmentType;
     };
 
+    struct ShadowCaster {
+        uint64_t TransformRevision;
+        Ref<Model> CastingModel;
+        uint64_t AnimatorID, AnimatorState;
+    };
+
+    // what a single face of a shadow map was last rendered from
+    struct ShadowFaceInputs {
+        bool Valid;
+        Renderer::Camera FaceCamera;
+        std::vector<ShadowCaster> Casters;
+    };
+
+    struct CulledEntity {
+        Scene::Entity Entity;
+        Ref<Model> RenderedModel;
+        Ref<Animator> EntityAnimator;
+
+        glm::mat4 Transform;
+        uint64_t TransformRevision;
+        uint32_t CameraMask;
+    };
+
     struct LightShadowData {
-        std::vector<Ref<Framebuffer>> Framebuffers;
+        std::optional<uint32_t> Slot; // the cube of the shadow atlas the light renders to
+        std::vector<ShadowFaceInputs> RenderedInputs; // per face
+        std::vector<uint64_t> LastUpdated; // per face, the shadow update it was last rendered in
         ShadowFramebufferSpec Spec;
         uint64_t SceneID;
+        glm::vec3 LastPosition;
+
+        // the shadow update the light was last seen in; lights that are gone are freed
+        uint64_t LastPrepared;
+
+        // filled in while scheduling, and dropped once the light is rendered
+        Renderer::SceneData Scene;
+        ShaderName Shader;
+        std::vector<CulledEntity> Casters;
+        uint32_t UpdatedFaces;
+    };
+
+    struct ShadowFaceRequest {
+        LightShadowData* Data;
+        uint32_t Face;
+
+        // faces that were never rendered to the current frame's atlas are not deferred
+        bool Required;
+        float Score;
+    };
+
+    struct ModelInstances {
+        Ref<Model> InstancedModel;
+
+        // keyed by the cameras that can see the instances
+        std::unordered_map<uint32_t, std::vector<glm::mat4>> Transforms;
     };
 
     class SceneRenderer : public RefCounted {
     public:
+        // summed over every pass of the last call to RenderScene
+        struct Statistics {
+            uint32_t Visible, Culled;
+
+            // shadow map faces whose casters and light did not change are not rendered again
+            // changed faces past the budget are deferred, and keep their last depth
+            uint32_t ShadowFacesRendered, ShadowFacesReused, ShadowFacesDeferred;
+
+            // lights holding a cube of the shadow atlas, and those left without one once it is full
+            uint32_t ShadowedLights, UnshadowedLights;
+
+            // bytes of depth in the shadow atlas
+            size_t ShadowAtlasMemory;
+        };
+
         SceneRenderer(const Ref<Scene>& scene);
         ~SceneRenderer();
 
         void RenderScene();
 
+        // compiles the pipelines that the scene's models are drawn to the target with
+        // shadow maps are left out, as their framebuffers are only created once rendered to
+        void PrewarmPipelines(const Ref<RenderTarget>& target);
+
+        const Statistics& GetStatistics() const { return m_Stats; }
+
+        // the number of changed shadow map faces rendered per call to RenderScene
+        // faces that were never rendered are always rendered, but still count against it
+        void SetShadowFaceBudget(uint32_t faces) { m_ShadowFaceBudget = faces; }
+        uint32_t GetShadowFaceBudget() const { return m_ShadowFaceBudget; }
+
+        // the face resolution of the shadow atlas, and the number of cubes it may grow to
+        // the atlas is allocated again, so every shadow map is rendered from scratch
+        void SetShadowAtlasSize(uint32_t resolution, uint32_t capacity);
+
+        // empty until the scene has a light
+        Ref<ShadowAtlas> GetShadowAtlas() const { return m_ShadowAtlas; }
+
     private:
-        void RenderShadowMap(Scene::Entity entity, const glm::mat4& transform,
-                             const Ref<Light>& light);
+        // culls the light's casters and requests an update for each face that changed
+        void PrepareShadowMap(Scene::Entity entity, const glm::mat4& transform,
+                              const Ref<Light>& light, const Renderer::Camera* mainCamera,
+                              const std::optional<Frustum>& mainFrustum);
 
-        void RenderShadows();
-        void RenderMainScene();
+        void RenderShadowMap(Scene::Entity entity, LightShadowData& shadowData);
 
-        void RenderSceneWithID(uint64_t id, size_t firstCamera, size_t cameraCount,
-                               ShaderName shader);
+        void CollectCameras(Renderer::SceneData& scene, size_t& mainCamera);
+
+        void RenderShadows(const Renderer::Camera* mainCamera);
+        void RenderMainScene(Renderer::SceneData& mainScene, size_t mainCamera);
+
+        void RenderSceneWithID(uint64_t id, const Renderer::SceneData& scene, size_t firstCamera,
+                               size_t cameraCount, ShaderName shader);
+
+        // fills m_CulledEntities with the entities visible to any of the passed cameras
+        // if an influence sphere is passed, entities that do not intersect it are culled
+        void CullEntities(const Renderer::SceneData& scene, size_t firstCamera, size_t cameraCount,
+                          const std::optional<BoundingSphere>& influence = {});
+
+        void RenderCulledEntities(uint64_t id, size_t firstCamera, size_t cameraCount,
+                                  ShaderName shader);
 
         Ref<Scene> m_Scene;
         uint64_t m_MainID;
 
         std::unordered_map<Scene::Entity, Ref<Animator>> m_Animators;
+        std::unordered_map<Model*, ModelInstances> m_Instances;
         std::unordered_map<Scene::Entity, LightShadowData> m_LightShadowData;
 
+        std::vector<ShadowFaceRequest> m_ShadowRequests;
+        uint32_t m_ShadowFaceBudget;
+        uint64_t m_ShadowUpdate;
+
+        // kept between passes so that culling does not allocate once warmed up
+        std::vector<CulledEntity> m_CulledEntities;
+        std::vector<Frustum> m_CullingFrustums;
+        std::vector<BoundingSphere> m_CullingSpheres;
+        std::vector<uint32_t> m_CullingMasks;
+        Statistics m_Stats;
+
         Ref<Sampler> m_ShadowSampler;
+
+        Ref<ShadowAtlas> m_ShadowAtlas;
+        uint32_t m_ShadowAtlasResolution, m_ShadowAtlasCapacity;
     };
 } // namespace fuujin
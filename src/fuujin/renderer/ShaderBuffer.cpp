@@ -5,6 +5,14 @@
 #include <sstream>
 
 namespace fuujin {
+    struct TypeFieldHandles {
+        std::weak_ptr<GPUType> Type;
+        std::unordered_map<std::string, ShaderBuffer::FieldHandle> Handles;
+    };
+
+    // keyed by address - the weak pointer catches types that were freed and reallocated
+    static thread_local std::unordered_map<const GPUType*, TypeFieldHandles> s_FieldHandles;
+
     bool ShaderBuffer::ParseFieldExpresssion(const std::string& expression, FieldExpression& data) {
         ZoneScoped;
 
@@ -66,6 +74,9 @@ namespace fuujin {
         const auto& fieldData = fields.at(expression.Field);
         size_t newOffset = fieldData.Offset + currentOffset;
 
+        field.Stride = 0;
+        field.Count = 1;
+
         if (expression.Indices.size() > fieldData.Dimensions.size()) {
             FUUJIN_ERROR("Attempted to specify {} indices - array is {}-dimensional",
                          expression.Indices.size(), fieldData.Dimensions.size());
@@ -90,6 +101,11 @@ namespace fuujin {
 
                 strides.pop();
             }
+
+            if (!strides.empty()) {
+                field.Stride = strides.top();
+                field.Count = fieldData.Dimensions[expression.Indices.size()];
+            }
         }
 
         if (child.empty()) {
@@ -102,6 +118,36 @@ namespace fuujin {
         }
     }
 
+    bool ShaderBuffer::GetFieldHandle(const std::shared_ptr<GPUType>& type,
+                                      const std::string& expression, FieldHandle& handle) {
+        ZoneScoped;
+
+        auto& typeHandles = s_FieldHandles[type.get()];
+        if (typeHandles.Type.expired() || typeHandles.Type.lock() != type) {
+            typeHandles.Type = type;
+            typeHandles.Handles.clear();
+        }
+
+        auto it = typeHandles.Handles.find(expression);
+        if (it == typeHandles.Handles.end()) {
+            // failures are cached too, so that a missing field only warns once
+            FieldHandle newHandle{};
+            RecursiveFieldInfo field;
+
+            if (FindField(expression, type, field)) {
+                newHandle.Type = field.Type;
+                newHandle.Offset = field.TotalOffset;
+                newHandle.Stride = field.Stride;
+                newHandle.Count = field.Count;
+            }
+
+            it = typeHandles.Handles.insert(std::make_pair(expression, newHandle)).first;
+        }
+
+        handle = it->second;
+        return handle.IsValid();
+    }
+
     ShaderBuffer::ShaderBuffer(const std::shared_ptr<GPUType>& type) {
         ZoneScoped;
 
@@ -128,27 +174,69 @@ namespace fuujin {
     bool ShaderBuffer::SetData(const std::string& name, const Buffer& data) {
         ZoneScoped;
 
-        RecursiveFieldInfo field;
-        if (!FindField(name, m_Type, field)) {
+        FieldHandle handle;
+        if (!GetFieldHandle(name, handle)) {
+            return false;
+        }
+
+        return SetData(handle, 0, data);
+    }
+
+    bool ShaderBuffer::GetData(const std::string& name, Buffer& data) const {
+        ZoneScoped;
+
+        FieldHandle handle;
+        if (!GetFieldHandle(name, handle)) {
+            return false;
+        }
+
+        auto slice = m_Buffer.Slice(handle.Offset, handle.Type->GetSize());
+        Buffer::Copy(slice, data, data.GetSize());
+
+        return true;
+    }
+
+    bool ShaderBuffer::SetData(const FieldHandle& handle, size_t index, const Buffer& data) {
+        ZoneScoped;
+
+        if (!handle.IsValid() || index >= handle.Count) {
             return false;
         }
 
-        auto slice = m_Buffer.Slice(field.TotalOffset, field.Type->GetSize());
+        auto slice = m_Buffer.Slice(handle.Offset + handle.Stride * index, handle.Type->GetSize());
         Buffer::Copy(data, slice, data.GetSize());
 
         return true;
     }
 
-    bool ShaderBuffer::GetData(const std::string& name, Buffer& data) const {
+    bool ShaderBuffer::SetArrayData(const FieldHandle& handle, size_t firstIndex,
+                                    const void* data, size_t elementSize, size_t count) {
         ZoneScoped;
 
-        RecursiveFieldInfo field;
-        if (!FindField(name, m_Type, field)) {
+        if (!handle.IsValid() || firstIndex + count > handle.Count) {
             return false;
         }
 
-        auto slice = m_Buffer.Slice(field.TotalOffset, field.Type->GetSize());
-        Buffer::Copy(slice, data, data.GetSize());
+        if (count == 0) {
+            return true;
+        }
+
+        size_t offset = handle.Offset + handle.Stride * firstIndex;
+        const auto source = Buffer::Wrapper(data, elementSize * count);
+
+        if (handle.Stride == elementSize) {
+            auto slice = m_Buffer.Slice(offset, elementSize * count);
+            Buffer::Copy(source, slice, elementSize * count);
+
+            return true;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const auto element = source.Slice(elementSize * i, elementSize);
+            auto slice = m_Buffer.Slice(offset + handle.Stride * i, handle.Type->GetSize());
+
+            Buffer::Copy(element, slice, elementSize);
+        }
 
         return true;
     }
@@ -156,13 +244,24 @@ namespace fuujin {
     bool ShaderBuffer::Slice(const std::string& name, ShaderBuffer& slice) {
         ZoneScoped;
 
-        RecursiveFieldInfo field;
-        if (!FindField(name, m_Type, field)) {
+        FieldHandle handle;
+        if (!GetFieldHandle(name, handle)) {
+            return false;
+        }
+
+        return Slice(handle, 0, slice);
+    }
+
+    bool ShaderBuffer::Slice(const FieldHandle& handle, size_t index, ShaderBuffer& slice) {
+        ZoneScoped;
+
+        if (!handle.IsValid() || index >= handle.Count) {
             return false;
         }
 
-        auto bufferSlice = m_Buffer.Slice(field.TotalOffset, field.Type->GetSize());
-        slice = ShaderBuffer(std::move(bufferSlice), field.Type);
+        size_t offset = handle.Offset + handle.Stride * index;
+        auto bufferSlice = m_Buffer.Slice(offset, handle.Type->GetSize());
+        slice = ShaderBuffer(std::move(bufferSlice), handle.Type);
 
         return true;
     }
@@ -16,17 +16,37 @@ namespace fuujin {
         struct RecursiveFieldInfo {
             size_t TotalOffset;
             std::shared_ptr<GPUType> Type;
+
+            // set if the expression left an array dimension unindexed
+            // elements along it are Stride bytes apart
+            size_t Stride, Count;
+        };
+
+        // a field resolved ahead of time, which can be written to without parsing its name
+        // index passed alongside it selects an element along the first unindexed dimension
+        struct FieldHandle {
+            std::shared_ptr<GPUType> Type;
+            size_t Offset, Stride, Count;
+
+            bool IsValid() const { return Type != nullptr; }
         };
 
         static bool ParseFieldExpresssion(const std::string& expression, FieldExpression& data);
         static bool FindField(const std::string& identifier, const std::shared_ptr<GPUType>& type,
                               RecursiveFieldInfo& field, size_t currentOffset = 0);
 
+        // resolved once per type and expression, and cached per thread after that
+        static bool GetFieldHandle(const std::shared_ptr<GPUType>& type,
+                                   const std::string& expression, FieldHandle& handle);
+
         ShaderBuffer() = default;
         ~ShaderBuffer() = default;
 
         ShaderBuffer(const std::shared_ptr<GPUType>& type);
 
+        // wraps the passed buffer, which may be a view of memory owned elsewhere
+        ShaderBuffer(Buffer&& data, const std::shared_ptr<GPUType>& type);
+
         // we dont care about copying
         ShaderBuffer(const ShaderBuffer&) = default;
         ShaderBuffer& operator=(const ShaderBuffer&) = default;
@@ -35,9 +55,65 @@ namespace fuujin {
         ShaderBuffer(ShaderBuffer&& other);
         ShaderBuffer& operator=(ShaderBuffer&& other);
 
+        bool GetFieldHandle(const std::string& expression, FieldHandle& handle) const {
+            return GetFieldHandle(m_Type, expression, handle);
+        }
+
         bool SetData(const std::string& name, const Buffer& data);
         bool GetData(const std::string& name, Buffer& data) const;
 
+        bool SetData(const FieldHandle& handle, size_t index, const Buffer& data);
+
+        // writes count elements of elementSize bytes, starting at firstIndex
+        // tightly packed arrays are written with a single copy
+        bool SetArrayData(const FieldHandle& handle, size_t firstIndex, const void* data,
+                          size_t elementSize, size_t count);
+
+        template <typename _Ty>
+        bool Set(const FieldHandle& handle, size_t index, const _Ty& value) {
+            ZoneScoped;
+
+            auto data = Buffer::Wrapper(&value, sizeof(_Ty));
+            return SetData(handle, index, data);
+        }
+
+        bool Set(const FieldHandle& handle, size_t index, const glm::mat4& value) {
+            ZoneScoped;
+
+            glm::mat4 matrix = value;
+            if (Renderer::GetAPI().TransposeMatrices) {
+                matrix = glm::transpose(matrix);
+            }
+
+            auto data = Buffer::Wrapper(&matrix, sizeof(glm::mat4));
+            return SetData(handle, index, data);
+        }
+
+        template <typename _Ty>
+        bool SetArray(const FieldHandle& handle, size_t firstIndex, const _Ty* values,
+                      size_t count) {
+            ZoneScoped;
+
+            return SetArrayData(handle, firstIndex, values, sizeof(_Ty), count);
+        }
+
+        bool SetArray(const FieldHandle& handle, size_t firstIndex, const glm::mat4* values,
+                      size_t count) {
+            ZoneScoped;
+
+            if (!Renderer::GetAPI().TransposeMatrices) {
+                return SetArrayData(handle, firstIndex, values, sizeof(glm::mat4), count);
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                if (!Set(handle, firstIndex + i, values[i])) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
         template <typename _Ty>
         bool Set(const std::string& name, const _Ty& value) {
             ZoneScoped;
@@ -85,10 +161,9 @@ namespace fuujin {
         const Buffer& GetBuffer() const { return m_Buffer; }
 
         bool Slice(const std::string& name, ShaderBuffer& slice);
+        bool Slice(const FieldHandle& handle, size_t index, ShaderBuffer& slice);
 
     private:
-        ShaderBuffer(Buffer&& data, const std::shared_ptr<GPUType>& type);
-
         Buffer m_Buffer;
         std::shared_ptr<GPUType> m_Type;
     };
@@ -112,7 +112,20 @@ namespace fuujin {
             code[shaderName][stage] = spv;
         }
 
+        // shaders indexing into texture tables cannot be created without descriptor indexing,
+        // and those writing gl_Layer from the vertex stage without layered vertex output
+        const auto& api = Renderer::GetAPI();
+        bool bindlessSupported = api.MaxBindlessTextures > 0;
+
         for (const auto& [identifier, shaderCode] : code) {
+            if (!bindlessSupported && identifier.find("Bindless") != std::string::npos) {
+                continue;
+            }
+
+            if (!api.LayeredVertexOutput && identifier.find("Layered") != std::string::npos) {
+                continue;
+            }
+
             auto id = identifier;
             if (!id.empty()) {
                 id = '/' + id;
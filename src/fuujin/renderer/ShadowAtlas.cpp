@@ -0,0 +1,133 @@
+#include "fuujinpch.h"
+#include "fuujin/renderer/ShadowAtlas.h"
+
+#include "fuujin/renderer/Renderer.h"
+
+#include <algorithm>
+
+namespace fuujin {
+    static constexpr uint32_t s_CubeFaces = 6;
+
+    ShadowAtlas::ShadowAtlas(const Spec& spec) {
+        ZoneScoped;
+
+        if (spec.Resolution == 0 || spec.Capacity == 0) {
+            throw std::runtime_error("Shadow atlas must hold at least one cube!");
+        }
+
+        m_Spec = spec;
+        m_UsedSlots = 0;
+
+        m_Slots.resize(spec.Capacity);
+        for (auto& slot : m_Slots) {
+            slot.Used = false;
+            slot.Resolution = 0;
+        }
+
+        Texture::Spec textureSpec;
+        textureSpec.TextureSampler = spec.DepthSampler;
+        textureSpec.Width = textureSpec.Height = spec.Resolution;
+        textureSpec.Depth = 1;
+        textureSpec.MipLevels = 1;
+        textureSpec.Samples = 1;
+        textureSpec.ImageFormat = Texture::Format::D32;
+        textureSpec.TextureType = Texture::Type::CubeArray;
+        textureSpec.AdditionalFeatures.insert(Texture::Feature::DepthAttachment);
+        textureSpec.Layers = spec.Capacity;
+
+        // frames in flight share the array, as faces that are not rendered must carry over
+        // rendering a face waits on sampling from earlier frames through its render pass
+        m_Texture = Renderer::GetContext()->CreateTexture(textureSpec);
+    }
+
+    std::optional<uint32_t> ShadowAtlas::Allocate(uint32_t resolution) {
+        ZoneScoped;
+
+        uint32_t index = 0;
+        while (index < m_Slots.size() && m_Slots[index].Used) {
+            index++;
+        }
+
+        if (index >= m_Slots.size()) {
+            return {};
+        }
+
+        auto& slot = m_Slots[index];
+        slot.Used = true;
+        slot.Resolution = std::clamp(resolution, 1u, m_Spec.Resolution);
+        m_UsedSlots++;
+
+        // framebuffers smaller than the array only render to the corner of each face
+        Framebuffer::Spec spec;
+        spec.Width = spec.Height = slot.Resolution;
+        spec.Layers = s_CubeFaces;
+
+        // faces that are not updated keep the depth they were last rendered with
+        spec.PreserveContents = true;
+
+        auto& depthSpec = spec.Attachments.emplace_back();
+        depthSpec.TextureSampler = m_Spec.DepthSampler;
+        depthSpec.Type = Framebuffer::AttachmentType::Depth;
+        depthSpec.ImageType = Texture::Type::CubeArray;
+        depthSpec.Format = Texture::Format::D32;
+        depthSpec.BaseLayer = index * s_CubeFaces;
+        depthSpec.Source = m_Texture;
+
+        if (m_RenderPassSource.IsPresent()) {
+            slot.CubeFramebuffer = m_RenderPassSource->Recreate(spec);
+        } else {
+            slot.CubeFramebuffer = m_RenderPassSource =
+                Renderer::GetContext()->CreateFramebuffer(spec);
+        }
+
+        return index;
+    }
+
+    void ShadowAtlas::Free(uint32_t slot) {
+        ZoneScoped;
+
+        if (slot >= m_Slots.size() || !m_Slots[slot].Used) {
+            throw std::runtime_error("Attempted to free an unallocated shadow atlas cube!");
+        }
+
+        auto& data = m_Slots[slot];
+        data.Used = false;
+        data.Resolution = 0;
+        data.CubeFramebuffer.Reset();
+
+        m_UsedSlots--;
+    }
+
+    Ref<Framebuffer> ShadowAtlas::GetFramebuffer(uint32_t slot) const {
+        ZoneScoped;
+
+        return GetSlot(slot).CubeFramebuffer;
+    }
+
+    uint32_t ShadowAtlas::GetResolution(uint32_t slot) const {
+        ZoneScoped;
+
+        return GetSlot(slot).Resolution;
+    }
+
+    float ShadowAtlas::GetScale(uint32_t slot) const {
+        ZoneScoped;
+
+        return (float)GetSlot(slot).Resolution / (float)m_Spec.Resolution;
+    }
+
+    size_t ShadowAtlas::GetMemorySize() const {
+        ZoneScoped;
+
+        size_t faceSize = (size_t)m_Spec.Resolution * m_Spec.Resolution * sizeof(float);
+        return faceSize * s_CubeFaces * m_Spec.Capacity;
+    }
+
+    const ShadowAtlas::Slot& ShadowAtlas::GetSlot(uint32_t slot) const {
+        if (slot >= m_Slots.size() || !m_Slots[slot].Used) {
+            throw std::runtime_error("Invalid shadow atlas cube!");
+        }
+
+        return m_Slots[slot];
+    }
+} // namespace fuujin
@@ -0,0 +1,63 @@
+#pragma once
+#include "fuujin/core/Ref.h"
+
+#include "fuujin/renderer/Framebuffer.h"
+
+namespace fuujin {
+    /*
+     * Depth cube maps shared between the lights of a scene. The atlas is a single cube map array
+     * with a fixed number of cubes, allocated up front, and a light holds one cube of it until the
+     * light is freed. Lights may render at a lower resolution than the array, in which case their
+     * maps only cover a corner of each face.
+     */
+    class ShadowAtlas : public RefCounted {
+    public:
+        struct Spec {
+            uint32_t Resolution, Capacity;
+            Ref<Sampler> DepthSampler;
+        };
+
+        ShadowAtlas(const Spec& spec);
+        ~ShadowAtlas() = default;
+
+        ShadowAtlas(const ShadowAtlas&) = delete;
+        ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+        // returns the allocated cube, or nothing if every cube is taken
+        // the resolution is clamped to that of the atlas
+        std::optional<uint32_t> Allocate(uint32_t resolution);
+        void Free(uint32_t slot);
+
+        // renders to the faces of the cube
+        Ref<Framebuffer> GetFramebuffer(uint32_t slot) const;
+        Ref<Texture> GetTexture() const { return m_Texture; }
+
+        uint32_t GetResolution(uint32_t slot) const;
+
+        // the fraction of each face that the cube's map covers
+        float GetScale(uint32_t slot) const;
+
+        const Spec& GetSpec() const { return m_Spec; }
+        uint32_t GetUsedSlots() const { return m_UsedSlots; }
+
+        // bytes of depth allocated for the array
+        size_t GetMemorySize() const;
+
+    private:
+        struct Slot {
+            bool Used;
+            uint32_t Resolution;
+            Ref<Framebuffer> CubeFramebuffer;
+        };
+
+        const Slot& GetSlot(uint32_t slot) const;
+
+        Spec m_Spec;
+        Ref<Texture> m_Texture;
+        std::vector<Slot> m_Slots;
+        uint32_t m_UsedSlots;
+
+        // every framebuffer shares its render pass, and so the pipelines drawing to them
+        Ref<Framebuffer> m_RenderPassSource;
+    };
+} // namespace fuujin
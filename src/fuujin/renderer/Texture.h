@@ -34,7 +34,7 @@ namespace fuujin {
     class Texture : public Asset {
     public:
         enum class Format { RGBA8 = 0, RGB8, A8, D32 };
-        enum class Type { _2D = 0, _3D, Cube };
+        enum class Type { _2D = 0, _3D, Cube, CubeArray };
         enum class Feature { ShaderStorage, ColorAttachment, DepthAttachment, Transfer };
 
         struct Spec {
@@ -47,6 +47,9 @@ namespace fuujin {
             Format ImageFormat;
             Type TextureType;
             std::set<Feature> AdditionalFeatures;
+
+            // the number of cubes in a cube map array
+            uint32_t Layers = 1;
         };
 
         virtual uint64_t GetID() const = 0;
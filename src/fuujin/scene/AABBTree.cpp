@@ -0,0 +1,330 @@
+#include "fuujinpch.h"
+#include "fuujin/scene/AABBTree.h"
+
+namespace fuujin {
+    thread_local std::vector<int32_t> AABBTree::s_QueryStack;
+
+    AABBTree::AABBTree(float margin) {
+        ZoneScoped;
+
+        m_Margin = margin;
+        Clear();
+    }
+
+    int32_t AABBTree::Insert(const AABB& box, uint64_t userData) {
+        ZoneScoped;
+
+        int32_t leaf = AllocateNode();
+        auto& node = m_Nodes[leaf];
+
+        node.Box.Min = box.Min - glm::vec3(m_Margin);
+        node.Box.Max = box.Max + glm::vec3(m_Margin);
+        node.UserData = userData;
+        node.Height = 0;
+
+        InsertLeaf(leaf);
+        m_ProxyCount++;
+
+        return leaf;
+    }
+
+    void AABBTree::Remove(int32_t proxy) {
+        ZoneScoped;
+
+        if (proxy < 0 || (size_t)proxy >= m_Nodes.size() || !m_Nodes[proxy].IsLeaf() ||
+            m_Nodes[proxy].Height != 0) {
+            throw std::runtime_error("Invalid AABB tree proxy!");
+        }
+
+        RemoveLeaf(proxy);
+        FreeNode(proxy);
+
+        m_ProxyCount--;
+    }
+
+    bool AABBTree::Move(int32_t proxy, const AABB& box) {
+        ZoneScoped;
+
+        auto& node = m_Nodes[proxy];
+        if (node.Box.Contains(box)) {
+            return false;
+        }
+
+        AABB fatBox;
+        fatBox.Min = box.Min - glm::vec3(m_Margin);
+        fatBox.Max = box.Max + glm::vec3(m_Margin);
+
+        // nearby moves keep their place in the tree and only grow or shrink their ancestors
+        if (node.Box.Intersects(fatBox)) {
+            node.Box = fatBox;
+            Refit(node.Parent);
+
+            return true;
+        }
+
+        RemoveLeaf(proxy);
+        m_Nodes[proxy].Box = fatBox;
+        InsertLeaf(proxy);
+
+        return true;
+    }
+
+    void AABBTree::Clear() {
+        ZoneScoped;
+
+        m_Nodes.clear();
+        m_Root = m_FreeList = NullNode;
+        m_ProxyCount = 0;
+    }
+
+    int32_t AABBTree::AllocateNode() {
+        ZoneScoped;
+
+        int32_t index;
+        if (m_FreeList != NullNode) {
+            index = m_FreeList;
+            m_FreeList = m_Nodes[index].Parent;
+        } else {
+            index = (int32_t)m_Nodes.size();
+            m_Nodes.emplace_back();
+        }
+
+        auto& node = m_Nodes[index];
+        node.UserData = 0;
+        node.Parent = node.Left = node.Right = NullNode;
+        node.Height = 0;
+
+        return index;
+    }
+
+    void AABBTree::FreeNode(int32_t index) {
+        ZoneScoped;
+
+        auto& node = m_Nodes[index];
+        node.Parent = m_FreeList;
+        node.Left = node.Right = NullNode;
+        node.Height = -1;
+
+        m_FreeList = index;
+    }
+
+    void AABBTree::InsertLeaf(int32_t leaf) {
+        ZoneScoped;
+
+        if (m_Root == NullNode) {
+            m_Root = leaf;
+            m_Nodes[leaf].Parent = NullNode;
+
+            return;
+        }
+
+        // descend towards the sibling that grows the total surface area the least
+        AABB leafBox = m_Nodes[leaf].Box;
+        int32_t index = m_Root;
+
+        while (!m_Nodes[index].IsLeaf()) {
+            const auto& node = m_Nodes[index];
+
+            float area = node.Box.GetSurfaceArea();
+            float combinedArea = AABB::Union(node.Box, leafBox).GetSurfaceArea();
+
+            // cost of pairing with this node, and of pushing the leaf further down
+            float cost = 2.f * combinedArea;
+            float inheritanceCost = 2.f * (combinedArea - area);
+
+            float childCosts[2];
+            int32_t children[2] = { node.Left, node.Right };
+
+            for (size_t i = 0; i < 2; i++) {
+                const auto& child = m_Nodes[children[i]];
+                float childArea = AABB::Union(child.Box, leafBox).GetSurfaceArea();
+
+                if (!child.IsLeaf()) {
+                    childArea -= child.Box.GetSurfaceArea();
+                }
+
+                childCosts[i] = childArea + inheritanceCost;
+            }
+
+            if (cost < childCosts[0] && cost < childCosts[1]) {
+                break;
+            }
+
+            index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+        }
+
+        int32_t sibling = index;
+        int32_t oldParent = m_Nodes[sibling].Parent;
+        int32_t newParent = AllocateNode();
+
+        auto& parentNode = m_Nodes[newParent];
+        parentNode.Parent = oldParent;
+        parentNode.Box = AABB::Union(leafBox, m_Nodes[sibling].Box);
+        parentNode.Height = m_Nodes[sibling].Height + 1;
+        parentNode.Left = sibling;
+        parentNode.Right = leaf;
+
+        if (oldParent != NullNode) {
+            auto& grandparent = m_Nodes[oldParent];
+            if (grandparent.Left == sibling) {
+                grandparent.Left = newParent;
+            } else {
+                grandparent.Right = newParent;
+            }
+        } else {
+            m_Root = newParent;
+        }
+
+        m_Nodes[sibling].Parent = newParent;
+        m_Nodes[leaf].Parent = newParent;
+
+        Refit(newParent);
+    }
+
+    void AABBTree::RemoveLeaf(int32_t leaf) {
+        ZoneScoped;
+
+        if (leaf == m_Root) {
+            m_Root = NullNode;
+            return;
+        }
+
+        int32_t parent = m_Nodes[leaf].Parent;
+        int32_t grandparent = m_Nodes[parent].Parent;
+
+        const auto& parentNode = m_Nodes[parent];
+        int32_t sibling = parentNode.Left == leaf ? parentNode.Right : parentNode.Left;
+
+        m_Nodes[sibling].Parent = grandparent;
+        if (grandparent != NullNode) {
+            auto& grandparentNode = m_Nodes[grandparent];
+            if (grandparentNode.Left == parent) {
+                grandparentNode.Left = sibling;
+            } else {
+                grandparentNode.Right = sibling;
+            }
+
+            FreeNode(parent);
+            Refit(grandparent);
+        } else {
+            m_Root = sibling;
+            FreeNode(parent);
+        }
+
+        m_Nodes[leaf].Parent = NullNode;
+    }
+
+    void AABBTree::Refit(int32_t index) {
+        ZoneScoped;
+
+        while (index != NullNode) {
+            index = Balance(index);
+
+            auto& node = m_Nodes[index];
+            const auto& left = m_Nodes[node.Left];
+            const auto& right = m_Nodes[node.Right];
+
+            node.Box = AABB::Union(left.Box, right.Box);
+            node.Height = 1 + std::max(left.Height, right.Height);
+
+            index = node.Parent;
+        }
+    }
+
+    int32_t AABBTree::Balance(int32_t index) {
+        ZoneScoped;
+
+        auto& a = m_Nodes[index];
+        if (a.IsLeaf() || a.Height < 2) {
+            return index;
+        }
+
+        int32_t indexB = a.Left;
+        int32_t indexC = a.Right;
+
+        auto& b = m_Nodes[indexB];
+        auto& c = m_Nodes[indexC];
+
+        int32_t balance = c.Height - b.Height;
+        if (balance > 1) {
+            // rotate c up
+            int32_t indexF = c.Left;
+            int32_t indexG = c.Right;
+
+            auto& f = m_Nodes[indexF];
+            auto& g = m_Nodes[indexG];
+
+            c.Left = index;
+            c.Parent = a.Parent;
+            a.Parent = indexC;
+
+            if (c.Parent != NullNode) {
+                auto& parent = m_Nodes[c.Parent];
+                if (parent.Left == index) {
+                    parent.Left = indexC;
+                } else {
+                    parent.Right = indexC;
+                }
+            } else {
+                m_Root = indexC;
+            }
+
+            // the taller of c's children stays with c
+            auto& kept = f.Height > g.Height ? f : g;
+            auto& moved = f.Height > g.Height ? g : f;
+
+            c.Right = f.Height > g.Height ? indexF : indexG;
+            a.Right = f.Height > g.Height ? indexG : indexF;
+            moved.Parent = index;
+
+            a.Box = AABB::Union(b.Box, moved.Box);
+            c.Box = AABB::Union(a.Box, kept.Box);
+
+            a.Height = 1 + std::max(b.Height, moved.Height);
+            c.Height = 1 + std::max(a.Height, kept.Height);
+
+            return indexC;
+        }
+
+        if (balance < -1) {
+            // rotate b up
+            int32_t indexD = b.Left;
+            int32_t indexE = b.Right;
+
+            auto& d = m_Nodes[indexD];
+            auto& e = m_Nodes[indexE];
+
+            b.Left = index;
+            b.Parent = a.Parent;
+            a.Parent = indexB;
+
+            if (b.Parent != NullNode) {
+                auto& parent = m_Nodes[b.Parent];
+                if (parent.Left == index) {
+                    parent.Left = indexB;
+                } else {
+                    parent.Right = indexB;
+                }
+            } else {
+                m_Root = indexB;
+            }
+
+            auto& kept = d.Height > e.Height ? d : e;
+            auto& moved = d.Height > e.Height ? e : d;
+
+            b.Right = d.Height > e.Height ? indexD : indexE;
+            a.Left = d.Height > e.Height ? indexE : indexD;
+            moved.Parent = index;
+
+            a.Box = AABB::Union(c.Box, moved.Box);
+            b.Box = AABB::Union(a.Box, kept.Box);
+
+            a.Height = 1 + std::max(c.Height, moved.Height);
+            b.Height = 1 + std::max(a.Height, kept.Height);
+
+            return indexB;
+        }
+
+        return index;
+    }
+} // namespace fuujin
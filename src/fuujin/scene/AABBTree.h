@@ -0,0 +1,105 @@
+#pragma once
+
+#include "fuujin/renderer/Bounds.h"
+
+namespace fuujin {
+    /*
+     * Dynamic bounding volume hierarchy over axis-aligned boxes. Leaves store a box fattened by a
+     * margin, so that small movements only refit the leaf's ancestors instead of restructuring the
+     * tree. Inserts pick a sibling by surface area and rotations keep the tree balanced.
+     */
+    class AABBTree {
+    public:
+        static constexpr int32_t NullNode = -1;
+
+        AABBTree(float margin = 0.1f);
+        ~AABBTree() = default;
+
+        AABBTree(const AABBTree&) = delete;
+        AABBTree& operator=(const AABBTree&) = delete;
+
+        // returns a proxy that stays valid until removed
+        int32_t Insert(const AABB& box, uint64_t userData);
+        void Remove(int32_t proxy);
+
+        // returns true if the box left the fattened leaf, in which case the tree changed
+        bool Move(int32_t proxy, const AABB& box);
+
+        void Clear();
+
+        uint64_t GetUserData(int32_t proxy) const { return m_Nodes[proxy].UserData; }
+        const AABB& GetFatBounds(int32_t proxy) const { return m_Nodes[proxy].Box; }
+
+        size_t GetProxyCount() const { return m_ProxyCount; }
+        int32_t GetHeight() const { return m_Root == NullNode ? 0 : m_Nodes[m_Root].Height; }
+
+        // callback signature:
+        // void(int32_t proxy)
+        // nodes are only descended into if overlaps(const AABB&) returns true
+        template <typename _Overlap, typename _Func>
+        void Query(const _Overlap& overlaps, const _Func& callback) const {
+            ZoneScoped;
+
+            if (m_Root == NullNode) {
+                return;
+            }
+
+            auto& stack = s_QueryStack;
+            size_t base = stack.size();
+            stack.push_back(m_Root);
+
+            while (stack.size() > base) {
+                int32_t index = stack.back();
+                stack.pop_back();
+
+                const auto& node = m_Nodes[index];
+                if (!overlaps(node.Box)) {
+                    continue;
+                }
+
+                if (node.IsLeaf()) {
+                    callback(index);
+                } else {
+                    stack.push_back(node.Left);
+                    stack.push_back(node.Right);
+                }
+            }
+        }
+
+    private:
+        struct Node {
+            AABB Box;
+            uint64_t UserData;
+
+            // doubles as the next free node when unused
+            int32_t Parent;
+            int32_t Left, Right;
+
+            // leaves are at 0, free nodes at -1
+            int32_t Height;
+
+            bool IsLeaf() const { return Left == NullNode; }
+        };
+
+        // shared between trees so that nested queries on one thread do not allocate
+        static thread_local std::vector<int32_t> s_QueryStack;
+
+        int32_t AllocateNode();
+        void FreeNode(int32_t index);
+
+        void InsertLeaf(int32_t leaf);
+        void RemoveLeaf(int32_t leaf);
+
+        // recomputes boxes and heights from the passed node up to the root
+        void Refit(int32_t index);
+
+        // returns the node that took the passed node's place
+        int32_t Balance(int32_t index);
+
+        std::vector<Node> m_Nodes;
+        int32_t m_Root, m_FreeList;
+        size_t m_ProxyCount;
+
+        float m_Margin;
+    };
+} // namespace fuujin
@@ -10,6 +10,7 @@ namespace fuujin {
         ZoneScoped;
 
         m_ID = s_SceneID++;
+        m_SpatialGeneration = 0;
     }
 
     Scene::~Scene() {
@@ -29,4 +30,90 @@ namespace fuujin {
 
         return entity;
     }
+
+    void Scene::UpdateSpatialIndex() {
+        ZoneScoped;
+
+        uint64_t generation = ++m_SpatialGeneration;
+        m_SpatialUpdates.clear();
+
+        auto view = m_Registry.view<TransformComponent, ModelComponent>();
+        for (entt::entity id : view) {
+            const auto& transform = view.get<TransformComponent>(id).Data;
+            const auto& model = view.get<ModelComponent>(id).RenderedModel;
+
+            auto [it, inserted] = m_SpatialProxies.try_emplace(id);
+            auto& proxy = it->second;
+
+            if (inserted) {
+                proxy.Node = AABBTree::NullNode;
+                proxy.Unbounded = false;
+                proxy.IndexedModel = nullptr;
+                proxy.Revision = 0;
+            }
+
+            proxy.Generation = generation;
+            if (!inserted && proxy.IndexedModel == model.Raw() &&
+                proxy.Revision == transform.GetRevision()) {
+                continue;
+            }
+
+            proxy.IndexedModel = model.Raw();
+            proxy.Revision = transform.GetRevision();
+            m_SpatialUpdates.push_back(id);
+        }
+
+        // entities that lost either component, or were destroyed
+        for (auto it = m_SpatialProxies.begin(); it != m_SpatialProxies.end();) {
+            const auto& proxy = it->second;
+            if (proxy.Generation == generation) {
+                it++;
+                continue;
+            }
+
+            if (proxy.Node != AABBTree::NullNode) {
+                m_SpatialIndex.Remove(proxy.Node);
+            }
+
+            if (proxy.Unbounded) {
+                std::erase(m_UnboundedEntities, it->first);
+            }
+
+            it = m_SpatialProxies.erase(it);
+        }
+
+        for (entt::entity id : m_SpatialUpdates) {
+            auto& proxy = m_SpatialProxies.at(id);
+            auto model = proxy.IndexedModel;
+
+            bool unbounded = model != nullptr && !model->GetArmatures().empty();
+            if (unbounded != proxy.Unbounded) {
+                if (unbounded) {
+                    m_UnboundedEntities.push_back(id);
+                } else {
+                    std::erase(m_UnboundedEntities, id);
+                }
+
+                proxy.Unbounded = unbounded;
+            }
+
+            if (model == nullptr || unbounded) {
+                if (proxy.Node != AABBTree::NullNode) {
+                    m_SpatialIndex.Remove(proxy.Node);
+                    proxy.Node = AABBTree::NullNode;
+                }
+
+                continue;
+            }
+
+            const auto& transform = view.get<TransformComponent>(id).Data;
+            auto bounds = model->GetBounds().Transform(transform.ToMatrix());
+
+            if (proxy.Node == AABBTree::NullNode) {
+                proxy.Node = m_SpatialIndex.Insert(bounds, (uint64_t)id);
+            } else {
+                m_SpatialIndex.Move(proxy.Node, bounds);
+            }
+        }
+    }
 } // namespace fuujin
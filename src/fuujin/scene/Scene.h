@@ -1,9 +1,13 @@
 #pragma once
 #include "fuujin/core/Ref.h"
 
+#include "fuujin/scene/AABBTree.h"
+
 #include <entt/entt.hpp>
 
 namespace fuujin {
+    class Model;
+
     class Scene : public RefCounted {
     public:
         class Entity {
@@ -67,10 +71,83 @@ namespace fuujin {
             }
         }
 
+        // the spatial index covers entities with both a transform and a model
+        // changes to either are picked up in a single batch when this is called
+        void UpdateSpatialIndex();
+
+        size_t GetIndexedEntityCount() const { return m_SpatialProxies.size(); }
+
+        // callback signature:
+        // void(const Scene::Entity[&])
+        // nodes are only descended into if overlaps(const AABB&) returns true
+        // skinned models are passed to every query, as their bounds depend on their animation
+        template <typename _Overlap, typename _Func>
+        void Query(const _Overlap& overlaps, const _Func& callback) {
+            ZoneScoped;
+
+            m_SpatialIndex.Query(overlaps, [&](int32_t proxy) {
+                auto id = (entt::entity)m_SpatialIndex.GetUserData(proxy);
+                callback(Entity(id, this));
+            });
+
+            for (entt::entity id : m_UnboundedEntities) {
+                callback(Entity(id, this));
+            }
+        }
+
+        template <typename _Func>
+        void QueryAABB(const AABB& box, const _Func& callback) {
+            Query([&](const AABB& node) { return node.Intersects(box); }, callback);
+        }
+
+        template <typename _Func>
+        void QuerySphere(const BoundingSphere& sphere, const _Func& callback) {
+            Query([&](const AABB& node) { return sphere.Intersects(node); }, callback);
+        }
+
+        template <typename _Func>
+        void QueryFrustum(const Frustum& frustum, const _Func& callback) {
+            Query([&](const AABB& node) { return frustum.Intersects(node); }, callback);
+        }
+
+        // callback signature:
+        // void(const Scene::Entity[&], float distance)
+        // distance is where the ray enters the indexed bounds, which are fattened by a margin
+        template <typename _Func>
+        void RayCast(const Ray& ray, float maxDistance, const _Func& callback) {
+            ZoneScoped;
+
+            float distance;
+            m_SpatialIndex.Query(
+                [&](const AABB& node) { return node.Intersects(ray, maxDistance, distance); },
+                [&](int32_t proxy) {
+                    auto id = (entt::entity)m_SpatialIndex.GetUserData(proxy);
+                    callback(Entity(id, this), distance);
+                });
+
+            for (entt::entity id : m_UnboundedEntities) {
+                callback(Entity(id, this), 0.f);
+            }
+        }
+
     private:
+        struct SpatialProxy {
+            int32_t Node;
+            bool Unbounded;
+
+            Model* IndexedModel;
+            uint64_t Revision, Generation;
+        };
+
         entt::registry m_Registry;
         uint64_t m_ID;
 
+        AABBTree m_SpatialIndex;
+        std::unordered_map<entt::entity, SpatialProxy> m_SpatialProxies;
+        std::vector<entt::entity> m_UnboundedEntities;
+        std::vector<entt::entity> m_SpatialUpdates;
+        uint64_t m_SpatialGeneration;
+
         friend class Scene::Entity;
     };
 
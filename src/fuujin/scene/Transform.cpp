@@ -2,6 +2,10 @@
 #include "fuujin/scene/Transform.h"
 
 namespace fuujin {
+    static std::atomic<uint64_t> s_TransformRevision = 0;
+
+    uint64_t Transform::NextRevision() { return ++s_TransformRevision; }
+
     Transform::Transform() {
         ZoneScoped;
 
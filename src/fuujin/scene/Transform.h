@@ -22,10 +22,14 @@ namespace fuujin {
         const glm::quat& GetRotationQuat() const { return m_RotationQuat; }
         const glm::vec3& GetScale() const { return m_Scale; }
 
+        // unique across all transforms; changes whenever this transform does
+        uint64_t GetRevision() const { return m_Revision; }
+
         void SetTranslation(const glm::vec3& translation) {
             ZoneScoped;
 
             m_Translation = translation;
+            m_Revision = NextRevision();
         }
 
         void SetRotation(const glm::vec3& rotationEuler) {
@@ -33,6 +37,7 @@ namespace fuujin {
 
             m_RotationEuler = rotationEuler;
             m_RotationQuat = glm::quat(rotationEuler);
+            m_Revision = NextRevision();
         }
 
         void SetRotation(const glm::quat& rotationQuat) {
@@ -40,20 +45,26 @@ namespace fuujin {
 
             m_RotationQuat = rotationQuat;
             m_RotationEuler = glm::eulerAngles(rotationQuat);
+            m_Revision = NextRevision();
         }
 
         void SetScale(const glm::vec3& scale) {
             ZoneScoped;
 
             m_Scale = scale;
+            m_Revision = NextRevision();
         }
 
         glm::mat4 ToMatrix() const;
 
     private:
+        static uint64_t NextRevision();
+
         glm::vec3 m_Translation;
         glm::vec3 m_RotationEuler;
         glm::quat m_RotationQuat;
         glm::vec3 m_Scale;
+
+        uint64_t m_Revision;
     };
 } // namespace fuujin
@@ -62,13 +62,21 @@ namespace fuujin {
     namespace fs = std::experimental::filesystem;
 #endif
 
+    // heap allocations made on the calling thread
+    inline thread_local uint64_t s_ThreadAllocationCount = 0;
+
+    inline uint64_t GetThreadAllocationCount() { return s_ThreadAllocationCount; }
+
     inline void* allocate(size_t size) {
+        s_ThreadAllocationCount++;
+
         void* block = std::malloc(size);
         TracyAlloc(block, size);
         return block;
     }
 
     inline void* reallocate(void* block, size_t size) {
+        s_ThreadAllocationCount++;
         TracyFree(block);
 
         void* newBlock = std::realloc(block, size);
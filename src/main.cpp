@@ -196,6 +196,8 @@ private:
             light.Entity.AddComponent<LightComponent>().SceneLight = pointLight;
         }
 
+        // the scene is drawn to the swapchain, which is the active target while updating
+        m_Renderer->PrewarmPipelines(Renderer::GetActiveRenderTarget());
         Renderer::Wait();
     }
 